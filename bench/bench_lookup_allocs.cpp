@@ -0,0 +1,117 @@
+//----------------------------------------------------------------------------
+/*! \file
+    \brief Аллокации и время на один поиск пути (findFileEntry, openFile/closeFile)
+
+    Считаются вызовы глобального operator new за время цикла поиска. Для сравнения -
+    старый разбор пути через splitPath (std::vector<std::string>), через который
+    раньше шёл каждый поиск.
+
+    Запуск: bench_lookup_allocs [число файлов (по умолчанию 10000)]
+*/
+
+#include "../rcfs.h"
+#include "rcfs_bench.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+#if defined(__GNUC__) && !defined(__clang__)
+    // Замещающие operator new/delete - gcc видит malloc/free после встраивания и ошибочно предупреждает
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<std::size_t> numAllocs{0};
+
+void* operator new(std::size_t size)
+{
+    ++numAllocs;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept                  { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept     { std::free(p); }
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_bench;
+
+static const std::uint8_t fileData[16] = {};
+
+//----------------------------------------------------------------------------
+template<typename Lookup>
+void measure(const char *title, const std::vector<std::string> &paths, std::size_t numRounds, Lookup lookup)
+{
+    const std::size_t allocsBefore = numAllocs.load();
+    auto start = Clock::now();
+
+    std::size_t numFound = 0;
+    for(std::size_t round=0; round!=numRounds; ++round)
+    {
+        for(const auto &path : paths)
+            numFound += lookup(path) ? 1 : 0;
+    }
+
+    const double      seconds    = secondsSince(start);
+    const std::size_t numLookups = numRounds*paths.size();
+    const std::size_t allocs     = numAllocs.load()-allocsBefore;
+
+    keepValue(numFound);
+    std::printf("%-40s allocs/lookup %8.3f   ns/lookup %8.1f\n", title, (double)allocs/(double)numLookups, seconds*1e9/(double)numLookups);
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    const std::size_t numFiles  = argc>1 ? (std::size_t)std::strtoul(argv[1], 0, 10) : 10000;
+    const std::size_t numRounds = 20;
+
+    DirectoryEntry     root;
+    ResourceFileSystem rcfs(false, &root);
+
+    // Пути глубиной 4-6 компонентов, с разным регистром при поиске
+    std::vector<std::string> paths, lookupPaths;
+    for(std::size_t i=0; i!=numFiles; ++i)
+    {
+        std::string path = "assets/pack" + std::to_string(i%7) + "/group" + std::to_string(i%53) + "/";
+        if (i%3==0)
+            path += "textures/";
+        path += "resource_" + std::to_string(i) + ".bin";
+
+        rcfs.createFile(path);
+        rcfs.setFileData(path, fileData, sizeof(fileData));
+
+        paths.push_back(path);
+
+        std::string lookupPath = path;
+        lookupPath[0] = 'A'; // Регистр - без учёта
+        lookupPaths.push_back(lookupPath);
+    }
+
+    std::printf("files: %zu, lookups per measurement: %zu\n", numFiles, numFiles*numRounds);
+
+    measure("splitPath (old lookup path)", lookupPaths, numRounds, [&](const std::string &path) { return !rcfs.splitPath(path).empty(); });
+    measure("findFileEntry, tree", lookupPaths, numRounds, [&](const std::string &path) { return rcfs.findFileEntry(path)!=0; });
+    measure("openFile+closeFile, tree", lookupPaths, numRounds, [&](const std::string &path)
+            {
+                int iFile = rcfs.openFile(path);
+                return iFile>=0 && rcfs.closeFile(iFile);
+            });
+
+    rcfs.seal();
+
+    measure("findFileEntry, sealed (flat index)", lookupPaths, numRounds, [&](const std::string &path) { return rcfs.findFileEntry(path)!=0; });
+    measure("openFile+closeFile, sealed", lookupPaths, numRounds, [&](const std::string &path)
+            {
+                int iFile = rcfs.openFile(path);
+                return iFile>=0 && rcfs.closeFile(iFile);
+            });
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+//----------------------------------------------------------------------------
+/*! \file
+    \brief LZ-кодек на корпусе: степень сжатия, скорость сжатия и распаковки
+
+    Для каждого файла корпуса печатаются степень сжатия (исходный/сжатый
+    размер) и скорости для нескольких maxChain, скорость распаковки
+    lzDecompress, совмещённого XOR -> LZ (decodeCodecChainTo) и, для
+    сравнения, memcpy того же объёма.
+
+    Запуск: bench_lz_codec [файлы корпуса...]
+    Без аргументов - на сгенерированных данных (текст из словаря, двоичные таблицы, случайные).
+*/
+
+#include "../rcfs.h"
+#include "../rcfs_file_decoders.h"
+#include "rcfs_bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_bench;
+
+//----------------------------------------------------------------------------
+//! Повторяет job, пока не наберётся ~0.3 с, возвращает ГБ/с по size
+template<typename Job>
+double measureGBs(std::size_t size, Job job)
+{
+    std::size_t numRounds = 0;
+    auto start = Clock::now();
+    double seconds = 0;
+
+    do
+    {
+        job();
+        ++numRounds;
+        seconds = secondsSince(start);
+    }
+    while(seconds<0.3);
+
+    return (double)size*(double)numRounds/seconds/1e9;
+}
+
+static
+std::vector<std::uint8_t> generateText(std::size_t size)
+{
+    static const char *words[] = { "the ", "resource ", "file ", "system ", "directory ", "of ", "and ", "data ", "name ", "path "
+                                 , "open ", "read ", "close ", "decode ", "buffer ", "\n", ", ", ". ", "marty_rcfs ", "index " };
+    std::mt19937 rng(1);
+    std::vector<std::uint8_t> data;
+    while(data.size()<size)
+    {
+        const char *w = words[rng()%20];
+        data.insert(data.end(), w, w+std::strlen(w));
+    }
+    data.resize(size);
+    return data;
+}
+
+static
+std::vector<std::uint8_t> generateTable(std::size_t size)
+{
+    // Записи по 16 байт с медленно меняющимися полями - как таблицы/сетки в ресурсах
+    std::mt19937 rng(2);
+    std::vector<std::uint8_t> data(size);
+    for(std::size_t i=0; i<size; i+=16)
+    {
+        const std::uint32_t rec[4] = { (std::uint32_t)(i/16), 0x3F800000u, (std::uint32_t)(rng()%16), 0 };
+        std::memcpy(&data[i], rec, std::min<std::size_t>(16, size-i));
+    }
+    return data;
+}
+
+static
+std::vector<std::uint8_t> generateRandom(std::size_t size)
+{
+    std::mt19937 rng(3);
+    std::vector<std::uint8_t> data(size);
+    for(auto &b : data)
+        b = (std::uint8_t)rng();
+    return data;
+}
+
+//----------------------------------------------------------------------------
+static
+void benchCorpusFile(const std::string &name, const std::vector<std::uint8_t> &data)
+{
+    const std::size_t size = data.size();
+    if (!size)
+    {
+        std::printf("%s: empty or not read\n", name.c_str());
+        return;
+    }
+
+    std::printf("%s: %zu bytes\n", name.c_str(), size);
+
+    std::vector<std::uint8_t> compressed;
+    for(unsigned maxChain : { 1u, 4u, (unsigned)MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN, 64u })
+    {
+        auto start = Clock::now();
+        lzCompress(compressed, data, maxChain);
+        const double seconds = secondsSince(start);
+
+        std::printf("    maxChain %3u   ratio %6.3f   compress %8.1f MB/s\n", maxChain, (double)size/(double)compressed.size(), (double)size/seconds/1e6);
+    }
+
+    lzCompress(compressed, data);
+
+    std::vector<std::uint8_t> encoded;
+    encodeCodecChain(encoded, data.data(), size, codecChainXorLz, 4, 0x12345678, 0x9ABCDEF1);
+
+    std::vector<std::uint8_t> decoded(size);
+
+    const double lzGBs = measureGBs(size, [&]()
+                         {
+                             lzDecompressBlock(decoded.data(), size, compressed.data()+16, compressed.size()-16);
+                             keepValue(decoded[size/2]);
+                         });
+
+    const double xorLzGBs = measureGBs(size, [&]()
+                            {
+                                decodeCodecChainTo(decoded.data(), size, encoded.data(), encoded.size(), codecChainXorLz, 4, 0x12345678, 0x9ABCDEF1);
+                                keepValue(decoded[size/2]);
+                            });
+
+    const double memcpyGBs = measureGBs(size, [&]()
+                             {
+                                 std::memcpy(decoded.data(), data.data(), size);
+                                 keepValue(decoded[size/2]);
+                             });
+
+    const bool ok = decodeCodecChainTo(decoded.data(), size, encoded.data(), encoded.size(), codecChainXorLz, 4, 0x12345678, 0x9ABCDEF1)
+                 && decoded==data;
+
+    std::printf("    decompress %6.2f GB/s   XOR -> LZ %6.2f GB/s   memcpy %6.2f GB/s   %s\n", lzGBs, xorLzGBs, memcpyGBs, ok ? "ok" : "MISMATCH");
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    if (argc>1)
+    {
+        for(int i=1; i<argc; ++i)
+            benchCorpusFile(argv[i], loadFile(argv[i]));
+        return 0;
+    }
+
+    const std::size_t size = 4<<20;
+    benchCorpusFile("generated text"  , generateText  (size));
+    benchCorpusFile("generated table" , generateTable (size));
+    benchCorpusFile("generated random", generateRandom(size));
+
+    return 0;
+}
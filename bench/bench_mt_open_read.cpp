@@ -0,0 +1,103 @@
+//----------------------------------------------------------------------------
+/*! \file
+    \brief Пропускная способность open/read/close из нескольких потоков
+
+    Каждый поток в цикле открывает случайный файл, читает его целиком в свой
+    буфер и закрывает. Печатается число циклов в секунду для 1, 2, 4... потоков.
+    Собирать с MARTY_RCFS_THREAD_SAFE:
+
+        g++ -std=c++17 -O2 -DNDEBUG -DMARTY_RCFS_THREAD_SAFE -I<...> -pthread bench/bench_mt_open_read.cpp -o bench_mt_open_read
+
+    Запуск: bench_mt_open_read [макс. число потоков (по умолчанию hardware_concurrency)] [число файлов (по умолчанию 1000)]
+*/
+
+#if !defined(MARTY_RCFS_THREAD_SAFE)
+    #define MARTY_RCFS_THREAD_SAFE
+#endif
+
+#include "../rcfs.h"
+#include "rcfs_bench.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_bench;
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    const unsigned    hwThreads  = std::thread::hardware_concurrency();
+    const unsigned    maxThreads = argc>1 ? (unsigned)std::strtoul(argv[1], 0, 10) : (hwThreads ? hwThreads : 4);
+    const std::size_t numFiles   = argc>2 ? (std::size_t)std::strtoul(argv[2], 0, 10) : 1000;
+    const std::size_t fileSize   = 256;
+    const double      duration   = 0.5; // Секунд на замер
+
+    DirectoryEntry     root;
+    ResourceFileSystem rcfs(false, &root);
+
+    std::vector<std::uint8_t> fileData(fileSize);
+    for(std::size_t i=0; i!=fileSize; ++i)
+        fileData[i] = (std::uint8_t)i;
+
+    std::vector<std::string> paths;
+    for(std::size_t i=0; i!=numFiles; ++i)
+    {
+        std::string path = "data/group" + std::to_string(i%16) + "/file_" + std::to_string(i) + ".bin";
+        rcfs.createFile(path);
+        rcfs.setFileData(path, fileData.data(), fileData.size());
+        paths.push_back(path);
+    }
+
+    rcfs.seal();
+
+    std::printf("files: %zu, file size: %zu\n", numFiles, fileSize);
+
+    for(unsigned numThreads=1; numThreads<=maxThreads; numThreads*=2)
+    {
+        std::atomic<bool>        stop{false};
+        std::atomic<std::size_t> numCycles{0};
+        std::atomic<std::size_t> numErrors{0};
+
+        std::vector<std::thread> threads;
+        for(unsigned t=0; t!=numThreads; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                std::vector<std::uint8_t> buf(fileSize);
+                std::size_t idx = t*7919u, cycles = 0, errors = 0;
+
+                while(!stop.load(std::memory_order_relaxed))
+                {
+                    idx = (idx*1103515245u + 12345u) % numFiles;
+
+                    std::size_t nReaded = 0;
+                    int iFile = rcfs.openFile(paths[idx]);
+                    if (iFile<0 || !rcfs.readFile(iFile, buf.data(), fileSize, &nReaded) || nReaded!=fileSize || !rcfs.closeFile(iFile))
+                        ++errors;
+
+                    ++cycles;
+                }
+
+                numCycles += cycles;
+                numErrors += errors;
+            });
+        }
+
+        auto start = Clock::now();
+        std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+        stop = true;
+        for(auto &thread : threads)
+            thread.join();
+
+        const double seconds = secondsSince(start);
+        std::printf("threads %3u   open/read/close per second %12.0f   errors %zu\n", numThreads, (double)numCycles.load()/seconds, numErrors.load());
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+//----------------------------------------------------------------------------
+/*! \file
+    \brief Скорость нормализации имён (ГБ/с): векторный и скалярный варианты, хэш без учёта регистра
+
+    Для сравнения - побайтный перевод в нижний регистр через std::tolower с копией в std::string
+    и std::hash от неё: так имя готовилось к поиску раньше.
+
+    Запуск: bench_normalize [длина пути (по умолчанию 4096)]
+*/
+
+#include "../rcfs.h"
+#include "rcfs_bench.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_bench;
+
+//----------------------------------------------------------------------------
+template<typename Job>
+void measure(const char *title, std::size_t pathSize, Job job)
+{
+    // Не меньше ~1 ГБ обработанных данных на замер
+    const std::size_t numRounds = ((std::size_t)1 << 30) / (pathSize ? pathSize : 1);
+    const std::size_t rounds    = numRounds ? numRounds : 1;
+
+    auto start = Clock::now();
+    for(std::size_t round=0; round!=rounds; ++round)
+        job();
+
+    const double seconds = secondsSince(start);
+    std::printf("%-40s %8.2f GB/s\n", title, (double)pathSize*(double)rounds/seconds/1e9);
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    const std::size_t pathSize = argc>1 ? (std::size_t)std::strtoul(argv[1], 0, 10) : 4096;
+
+    // Длинный глубокий путь со смешанным регистром и обоими разделителями
+    std::string path;
+    for(std::size_t i=0; path.size()<pathSize; ++i)
+        path += (i%2 ? "\\Some_Mixed_Dir" : "/Level") + std::to_string(i);
+    path.resize(pathSize);
+
+    std::vector<char> dst(pathSize);
+
+    #if defined(MARTY_RCFS_SIMD_AVX2)
+        const char *simdName = "AVX2";
+    #elif defined(MARTY_RCFS_SIMD_SSE2)
+        const char *simdName = "SSE2";
+    #else
+        const char *simdName = "none";
+    #endif
+
+    std::printf("path size: %zu, SIMD: %s\n", pathSize, simdName);
+
+    measure("normalizePathSymbols", pathSize, [&]()
+            {
+                normalizePathSymbols(dst.data(), path.data(), pathSize, true);
+                keepValue(dst[pathSize/2]);
+            });
+
+    measure("normalizePathSymbolsScalar", pathSize, [&]()
+            {
+                normalize_utils::normalizePathSymbolsScalar(dst.data(), path.data(), pathSize, true);
+                keepValue(dst[pathSize/2]);
+            });
+
+    measure("std::tolower copy (old)", pathSize, [&]()
+            {
+                std::string lower;
+                lower.reserve(pathSize);
+                for(char ch : path)
+                    lower.push_back(ch=='\\' ? '/' : (char)std::tolower((unsigned char)ch));
+                keepValue(lower[pathSize/2]);
+            });
+
+    measure("foldCaseHash", pathSize, [&]() { keepValue(foldCaseHash(path)); });
+
+    measure("std::tolower copy + std::hash (old)", pathSize, [&]()
+            {
+                std::string lower(path);
+                for(char &ch : lower)
+                    ch = (char)std::tolower((unsigned char)ch);
+                keepValue(std::hash<std::string>()(lower));
+            });
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+//----------------------------------------------------------------------------
+/*! \file
+    \brief Скорость XOR-декодирования (ГБ/с): xorDecodeData, скалярный вариант и побайтный цикл
+
+    Побайтный цикл - как у прежнего декодера через _2c::xorDecrypt: ключ
+    пересчитывается на каждом байте.
+
+    Запуск: bench_xor_decode [размер данных в МБ (по умолчанию 16)]
+*/
+
+#include "../rcfs.h"
+#include "../rcfs_file_decoders.h"
+#include "rcfs_bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_bench;
+
+//----------------------------------------------------------------------------
+static
+void byteLoopXor(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size, unsigned keySize, std::uint32_t seed, std::uint32_t inc)
+{
+    std::uint32_t key = seed;
+    for(std::size_t i=0; i!=size; ++i)
+    {
+        if (i && i%keySize==0)
+            key += inc;
+        pDst[i] = (std::uint8_t)(pSrc[i] ^ (std::uint8_t)(key>>(8*(i%keySize))));
+    }
+}
+
+template<typename Job>
+void measure(const char *title, unsigned keySize, std::size_t size, Job job)
+{
+    const std::size_t numRounds = ((std::size_t)1<<30)/size + 1;
+
+    auto start = Clock::now();
+    for(std::size_t round=0; round!=numRounds; ++round)
+        job();
+
+    const double seconds = secondsSince(start);
+    std::printf("key %u  %-28s %8.2f GB/s\n", keySize, title, (double)size*(double)numRounds/seconds/1e9);
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    const std::size_t size = (argc>1 ? (std::size_t)std::strtoul(argv[1], 0, 10) : 16) << 20;
+
+    std::vector<std::uint8_t> src(size), dst(size);
+    for(std::size_t i=0; i!=size; ++i)
+        src[i] = (std::uint8_t)(i*131+7);
+
+    #if defined(MARTY_RCFS_XOR_DECODE_AVX2)
+        const char *simdName = "AVX2";
+    #elif defined(MARTY_RCFS_XOR_DECODE_SSE2)
+        const char *simdName = "SSE2";
+    #else
+        const char *simdName = "none";
+    #endif
+
+    std::printf("data size: %zu MB, SIMD: %s\n", size>>20, simdName);
+
+    for(unsigned keySize : { 1u, 2u, 4u })
+    {
+        measure("xorDecodeData", keySize, size, [&]()
+                {
+                    xorDecodeData(dst.data(), src.data(), size, keySize, 0x12345678, 0x9ABCDEF1);
+                    keepValue(dst[size/2]);
+                });
+
+        measure("xorDecodeData, in place", keySize, size, [&]()
+                {
+                    xorDecodeData(dst.data(), dst.data(), size, keySize, 0x12345678, 0x9ABCDEF1);
+                    keepValue(dst[size/2]);
+                });
+
+        measure("xorDecodeScalar", keySize, size, [&]()
+                {
+                    xor_decode_utils::xorDecodeScalar(dst.data(), src.data(), size, keySize, 0x12345678, 0x9ABCDEF1);
+                    keepValue(dst[size/2]);
+                });
+
+        measure("byte loop (old)", keySize, size, [&]()
+                {
+                    byteLoopXor(dst.data(), src.data(), size, keySize, 0x12345678, 0x9ABCDEF1);
+                    keepValue(dst[size/2]);
+                });
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Общее для бенчмарков marty_rcfs
+
+    Каждый бенчмарк - отдельная программа, печатает результаты в stdout.
+    Сборка - как у тестов (см. tests/rcfs_test.h), с оптимизацией, например:
+
+        g++ -std=c++17 -O2 -DNDEBUG -I<каталог с marty_cpp и umba> -pthread bench/bench_xor_decode.cpp -o bench_xor_decode
+
+    Числа зависят от машины; сравнивать имеет смысл строки одного запуска.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs_bench {
+
+
+
+//----------------------------------------------------------------------------
+typedef std::chrono::steady_clock   Clock;
+
+inline
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+//! Не даёт компилятору выбросить вычисление результата
+template<typename T>
+void keepValue(const T &value)
+{
+    static volatile std::uintptr_t sink = 0;
+    sink = sink + (std::uintptr_t)value;
+}
+
+//! Содержимое файла. Пустое - файл не прочитан
+inline
+std::vector<std::uint8_t> loadFile(const char *fileName)
+{
+    std::ifstream f(fileName, std::ios::binary);
+    if (!f)
+        return std::vector<std::uint8_t>();
+
+    return std::vector<std::uint8_t>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs_bench
+
@@ -1,15 +1,24 @@
 #pragma once
 
-#include <unordered_map>
-#include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 #include <exception>
 #include <stdexcept>
 
+#if defined(MARTY_RCFS_THREAD_SAFE)
+    #include <atomic>
+    #include <condition_variable>
+    #include <mutex>
+#endif
+
 #include "common.h"
 #include "rcfs_flags.h"
+#include "rcfs_normalize.h"
+#include "rcfs_arena.h"
+#include "rcfs_intern.h"
+#include "rcfs_decode_cache.h"
 
 /*
     Файловая система только для чтения.
@@ -17,41 +26,206 @@
     Нельзя переименовывать файлы и каталоги.
     Можно добавлять файлы и каталоги.
 
+    Все записи дерева (кроме корня), их файловые/каталожные части и имена
+    выделяются из арены, которой владеет корневой каталог. Адреса записей
+    стабильны всё время жизни дерева.
+
+    Имена интернируются в таблице арены (см. rcfs_intern.h): каждое различное
+    имя хранится один раз, и дочерние элементы сравниваются по указателю.
+
  */
 
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
 namespace marty_rcfs {
 
 
+class DirectoryEntry;
+class DirectoryEntryArena;
+
+//----------------------------------------------------------------------------
+//! Файловая часть записи. Есть только у файлов
+struct FileEntryData
+{
+    const std::uint8_t                              *pConstFileData = 0;
+    std::size_t                                      fileSize       = 0;
+
+    #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+    unsigned                                         decryptKeySize = 0;
+    unsigned                                         decryptKeySeed = 0;
+    unsigned                                         decryptKeyInc  = 0;
+    unsigned                                         codecChain     = 0; //!< Цепочка кодеков (rcfs_codec_chain.h). 0 - не задана
+
+    std::vector<std::uint8_t>                        fileDataDecrypted;
+    std::size_t                                      decodedSize = (std::size_t)-1; //!< Размер после декодирования, сообщённый декодером при регистрации. (std::size_t)-1 - неизвестен
+
+    DirectoryEntry                                  *pCachePrev = 0; //!< Список LRU кэша декодированных данных (rcfs_decode_cache.h)
+    DirectoryEntry                                  *pCacheNext = 0;
+
+    decode_state_utils::StateVar                     decodeState{FileDecodeState::NotDecoded};
+    decode_state_utils::FlagVar                      cacheReferenced{false}; //!< Открывался после попадания в кэш - второй шанс при вытеснении
+    #endif
+
+}; // struct FileEntryData
+
+//----------------------------------------------------------------------------
+//! Дочерний элемент каталога
+struct DirectoryEntryChild
+{
+    InternedName                                     name;       //!< Интернированное имя, хранится в таблице имён арены
+    DirectoryEntry                                  *pEntry = 0;
+
+}; // struct DirectoryEntryChild
+
+//----------------------------------------------------------------------------
+//! Каталожная часть записи. Есть только у каталогов
+/*! Дочерние элементы лежат непрерывным массивом в порядке добавления.
+    Небольшие каталоги просматриваются перебором, для больших строится
+    open addressing хэш-индекс по номерам элементов.
+ */
+struct DirectoryEntryChildren
+{
+    static const std::size_t linearSearchLimit = 8; //!< До скольки элементов ищем перебором
+
+    std::vector<DirectoryEntryChild>                 items;
+    std::vector<std::uint32_t>                       hashIndex; //!< Номер элемента + 1, 0 - пустой слот
+
+    //! Имена сравниваются по указателю - поиск по строке сначала интернирует её через таблицу имён
+    DirectoryEntry* find(InternedName name) const
+    {
+        if (hashIndex.empty())
+        {
+            for(const auto &item : items)
+            {
+                if (item.name==name)
+                    return item.pEntry;
+            }
+            return 0;
+        }
+
+        const std::size_t mask = hashIndex.size()-1;
+        for(std::size_t slotIdx=name.hash()&mask; hashIndex[slotIdx]!=0; slotIdx=(slotIdx+1)&mask)
+        {
+            const DirectoryEntryChild &item = items[hashIndex[slotIdx]-1];
+            if (item.name==name)
+                return item.pEntry;
+        }
+
+        return 0;
+    }
+
+    void add(InternedName name, DirectoryEntry *pEntry)
+    {
+        items.emplace_back(DirectoryEntryChild{name, pEntry});
+
+        if (items.size()<=linearSearchLimit)
+            return;
+
+        // Заполнение индекса держим не выше 50%
+        if (hashIndex.size()<items.size()*2)
+            rebuildHashIndex();
+        else
+            insertHashIndex((std::uint32_t)(items.size()-1));
+    }
+
+    void insertHashIndex(std::uint32_t itemIdx)
+    {
+        const std::size_t mask = hashIndex.size()-1;
+        std::size_t slotIdx = items[itemIdx].name.hash() & mask;
+        while(hashIndex[slotIdx]!=0)
+            slotIdx = (slotIdx+1) & mask;
+        hashIndex[slotIdx] = itemIdx+1;
+    }
+
+    //! Отдаёт лишнюю память массивов - когда каталог больше не будет пополняться
+    void compact()
+    {
+        items.shrink_to_fit();
+        hashIndex.shrink_to_fit();
+    }
+
+    void rebuildHashIndex()
+    {
+        std::size_t numSlots = 16;
+        while(numSlots<items.size()*2)
+            numSlots *= 2;
+
+        hashIndex.assign(numSlots, 0);
+        for(std::size_t itemIdx=0; itemIdx!=items.size(); ++itemIdx)
+            insertHashIndex((std::uint32_t)itemIdx);
+    }
+
+}; // struct DirectoryEntryChildren
+
+//----------------------------------------------------------------------------
+//! Расход памяти деревом
+struct DirectoryEntryMemoryStats
+{
+    std::size_t      numDirectories  = 0; //!< Включая корень
+    std::size_t      numFiles        = 0;
+    std::size_t      entryBytes      = 0; //!< Узлы DirectoryEntry
+    std::size_t      payloadBytes    = 0; //!< Каталожные и файловые части
+    std::size_t      childArrayBytes = 0; //!< Массивы дочерних элементов и их хэш-индексы
+    std::size_t      nameBytes       = 0; //!< Таблица интернированных имён
+    std::size_t      numUniqueNames  = 0; //!< Различных имён в таблице
+    std::size_t      totalBytes      = 0;
+
+    double bytesPerEntry() const
+    {
+        std::size_t numEntries = numDirectories + numFiles;
+        return numEntries ? (double)totalBytes/(double)numEntries : 0.0;
+    }
+
+}; // struct DirectoryEntryMemoryStats
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
 class DirectoryEntry
 {
 
     friend class ResourceFileSystem;
+    friend class DirectoryEntryArena;
+    template<typename T, std::size_t ChunkSize> friend class ArenaObjectPool;
 
-    #if defined(MARTY_RCFS_ORDERED)
-        typedef std::map<std::string, DirectoryEntry>               DirectoryEntryMapType;
-    #else
-        typedef std::unordered_map<std::string, DirectoryEntry>     DirectoryEntryMapType;
-    #endif
+public:
+
+    typedef std::vector<DirectoryEntryChild>::const_iterator     ChildIterator;
 
 protected:
 
     FileAttrs                                        m_attrs = FileAttrs::FileAttrsDefault;
-    DirectoryEntryMapType                            m_items;
-    //std::map<std::string, DirectoryEntry>  m_items;
 
-    const std::uint8_t                              *m_pConstFileData = 0;
-    std::size_t                                      m_fileSize;
+    #if defined(MARTY_RCFS_THREAD_SAFE)
+    std::atomic<int>
+    #else
+    int
+    #endif
+                                                     m_lockCount{0};
 
-    #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-    unsigned                                         m_decryptKeySize = 0;
-    unsigned                                         m_decryptKeySeed = 0;
-    unsigned                                         m_decryptKeyInc  = 0;
+    DirectoryEntryArena                             *m_pArena = 0;
 
-    std::vector<std::uint8_t>                        m_fileDataDecrypted;
-    #endif
+    // Каталог или файл - определяется по m_attrs
+    union
+    {
+        DirectoryEntryChildren                      *m_pChildren = 0;
+        FileEntryData                               *m_pFileData;
+    };
 
-    int
-                                                     m_lockCount = 0;
+
+    //! Запись из арены
+    DirectoryEntry(DirectoryEntryArena *pArena, bool isDirectory);
+
+    static const std::vector<DirectoryEntryChild>& getEmptyChildItems()
+    {
+        static const std::vector<DirectoryEntryChild> emptyItems;
+        return emptyItems;
+    }
 
 public:
 
@@ -60,47 +234,45 @@ public:
         return m_attrs;
     }
 
-    DirectoryEntryMapType::const_iterator itemsBegin() const
+    //! Для файлов - пустой диапазон
+    ChildIterator itemsBegin() const
     {
-        return m_items.begin();
+        const DirectoryEntryChildren *pChildren = getChildren();
+        return pChildren ? pChildren->items.begin() : getEmptyChildItems().begin();
     }
 
-    DirectoryEntryMapType::const_iterator itemsEnd() const
+    ChildIterator itemsEnd() const
     {
-        return m_items.end();
+        const DirectoryEntryChildren *pChildren = getChildren();
+        return pChildren ? pChildren->items.end() : getEmptyChildItems().end();
     }
 
     //------------------------------
 
-    //! Запись типа каталог
-    DirectoryEntry()
-    : m_attrs(FileAttrs::DirectoryAttrsDefault)
-    , m_items()
-    {}
+    //! Запись типа каталог (корень дерева), владеет ареной для всех потомков
+    DirectoryEntry();
 
-    //! Запись типа файл
+    //! Отдельная запись типа файл, владеет своей ареной
     DirectoryEntry( const std::uint8_t *pConstFileData, std::size_t fileSize
                   #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
                   , unsigned decryptKeySize = 0
                   , unsigned decryptKeySeed = 0
                   , unsigned decryptKeyInc  = 0
+                  , unsigned codecChain     = 0
                   #endif
-                  )
-    : m_attrs(FileAttrs::FileAttrsDefault)
-    , m_items()
-    , m_pConstFileData(pConstFileData)
-    , m_fileSize      (fileSize      )
-    #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-    , m_decryptKeySize(decryptKeySize)
-    , m_decryptKeySeed(decryptKeySeed)
-    , m_decryptKeyInc (decryptKeyInc )
-    , m_fileDataDecrypted      ()
-    #endif
-    {}
+                  );
+
+    ~DirectoryEntry();
+
+    // Копировать и перемещать нельзя - на записи ссылаются открытые файлы, индексы и арена
+    DirectoryEntry(const DirectoryEntry&) = delete;
+    DirectoryEntry(DirectoryEntry&&) = delete;
+    DirectoryEntry& operator=(const DirectoryEntry&) = delete;
+    DirectoryEntry& operator=(DirectoryEntry&&) = delete;
 
 
-    // Хорошо бы переделать на атомики. Пока не актуально, но в других проектах может сделать проблему
     // Файлы лочаться при открытии, и запрещают изменения содержимого
+    // При MARTY_RCFS_THREAD_SAFE счётчик атомарный
     void lock  () { ++m_lockCount; }
     void unlock() { --m_lockCount; }
     bool locked() { if (m_lockCount<0) throw std::runtime_error("DirectoryEntry: lock/unlock mismatch"); return m_lockCount>0; }
@@ -114,11 +286,21 @@ public:
     const std::uint8_t* getFileDataPtr() const;
     std::size_t getFileDataSize() const;
 
-    DirectoryEntry* findAnyChildEntry(const std::string &name) const; //!< Find child of any type
-    DirectoryEntry* findExactChildEntry(const std::string &name, bool findDirectory = false) const; //!< Find child exact file or directory
+    DirectoryEntryChildren* getChildren() const { return isDirectoryEntry() ? m_pChildren : 0; } //!< 0 for file entries
+    FileEntryData* getFileData() const { return isDirectoryEntry() ? 0 : m_pFileData; } //!< 0 for directory entries
 
-    DirectoryEntry* createDirectoryChildEntry(const std::string &name, bool failOnExist = true); //!< Create direct child directory entry
-    DirectoryEntry* createFileChildEntry(const std::string &name); //!< Create direct child file entry
+    DirectoryEntryArena* getArena() const { return m_pArena; }
+    DirectoryEntryMemoryStats getMemoryStats() const; //!< Memory usage of the whole tree this entry belongs to
+
+    DirectoryEntry* findAnyChildEntry(std::string_view name) const; //!< Find child of any type
+    DirectoryEntry* findAnyChildEntry(InternedName name) const; //!< Find child of any type by interned name (pointer compare only)
+    DirectoryEntry* findExactChildEntry(std::string_view name, bool findDirectory = false) const; //!< Find child exact file or directory
+
+    DirectoryEntry* findAnyChildEntryNoCase(std::string_view name) const; //!< Find child of any type, ignoring ASCII case (keys must be lowercase)
+    DirectoryEntry* findExactChildEntryNoCase(std::string_view name, bool findDirectory = false) const; //!< Find child exact file or directory, ignoring ASCII case
+
+    DirectoryEntry* createDirectoryChildEntry(std::string_view name, bool failOnExist = true); //!< Create direct child directory entry
+    DirectoryEntry* createFileChildEntry(std::string_view name); //!< Create direct child file entry
 
     bool resetFileEntryData(); //!< Reset all file data
     bool assignFileEntryData( const std::uint8_t *pConstFileData
@@ -127,6 +309,7 @@ public:
                             , unsigned            decryptKeySize = 0
                             , unsigned            decryptKeySeed = 0
                             , unsigned            decryptKeyInc  = 0
+                            , unsigned            codecChain     = 0
                             #endif
                             );
 
@@ -155,33 +338,19 @@ public:
 
     //! Create directory by path, force or not
     template<typename IterType>
-    DirectoryEntry* createSubDirectory(IterType pathIter, IterType pathIterEnd, const std::string &name, bool forceCreate = true)
+    DirectoryEntry* createSubDirectory(IterType pathIter, IterType pathIterEnd, std::string_view name, bool forceCreate = true)
     {
 
         DirectoryEntry *pDirEntry = this;
 
         for(; pathIter!=pathIterEnd; ++pathIter)
         {
-            DirectoryEntry* pAnyChild = pDirEntry->findAnyChildEntry(*pathIter);
-
-            if (!pAnyChild)
-            {
-                if (!forceCreate)
-                    return 0; // Нельзя создавать всю иерархию
-
-                // можно создавать подкаталог вообще без проблем
-                pDirEntry = pDirEntry->createDirectoryChildEntry(*pathIter, true /* failOnExist - на всякий случай делаем ошибку, если существует */);
-                if (!pDirEntry)
-                     return pDirEntry;
-            }
-            else
-            {
-                // Такая энтря уже есть
-                if (!pAnyChild->isDirectoryEntry())
-                    return 0; // Найден файл, поэтом создать каталог уже не выйдет
-
-                pDirEntry = pAnyChild;
-            }
+            // Существующий каталог возвращается, новый создаётся; если с таким именем есть файл - 0.
+            // Имя интернируется один раз, дальше - сравнение указателей
+            pDirEntry = forceCreate ? pDirEntry->createDirectoryChildEntry(*pathIter, false /* failOnExist */)
+                                    : pDirEntry->findExactChildEntry(*pathIter, true /* findDirectory */); // Нельзя создавать всю иерархию
+            if (!pDirEntry)
+                return pDirEntry;
         }
 
         return pDirEntry->createDirectoryChildEntry(name, true /* failOnExist */ );
@@ -193,8 +362,10 @@ public:
     DirectoryEntry* createFile( IterType pathIter, IterType pathIterEnd, const std::string &name, bool failOnExist = true )
     {
         DirectoryEntry *pDirEntry = findSubDirectory(pathIter, pathIterEnd);
+        if (!pDirEntry)
+            return pDirEntry;
 
-        DirectoryEntry* pAnyEntry = pDirEntry->findAnyEntry(name);
+        DirectoryEntry* pAnyEntry = pDirEntry->findAnyChildEntry(name);
 
         if (!pAnyEntry)
         {
@@ -208,17 +379,8 @@ public:
         if (failOnExist)
             return 0;
 
-        if (locked())
-            return 0;
-
-        pAnyEntry->m_pConstFileData = 0;
-        pAnyEntry->m_fileSize       = 0;
-        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-        pAnyEntry->m_decryptKeySize = 0;
-        pAnyEntry->m_decryptKeySeed = 0;
-        pAnyEntry->m_decryptKeyInc  = 0;
-        pAnyEntry->m_fileDataDecrypted.clear();
-        #endif
+        if (!pAnyEntry->resetFileEntryData())
+            return 0; // Файл открыт
 
         return pAnyEntry;
     }
@@ -227,6 +389,8 @@ public:
     DirectoryEntry* findDirectoryEntry( IterType pathIter, IterType pathIterEnd, const std::string &name, bool findDirectory )
     {
         DirectoryEntry *pDirEntry = findSubDirectory(pathIter, pathIterEnd);
+        if (!pDirEntry)
+            return pDirEntry;
 
         //findExactChildEntry(const std::string &name, bool findDirectory) const
         // DirectoryEntry* pEntry =
@@ -270,34 +434,206 @@ public:
 
 
 
+//----------------------------------------------------------------------------
+//! Арена дерева - все записи, их файловые/каталожные части и имена. Владелец - корневая запись
+class DirectoryEntryArena
+{
+    DirectoryEntry                                  *m_pOwner;
+
+    ArenaObjectPool<DirectoryEntry>                  m_entries;
+    ArenaObjectPool<DirectoryEntryChildren>          m_children;
+    ArenaObjectPool<FileEntryData>                   m_fileData;
+    NameInternTable                                  m_names;
+
+    #if defined(MARTY_RCFS_THREAD_SAFE)
+    std::mutex                                       m_decodeMutex;     //!< Состояния декодирования данных файлов дерева и кэш декодированных данных. Само декодирование - без мьютекса
+    std::condition_variable                          m_decodeCondition; //!< Окончание декодирования какого-либо файла
+    #endif
+
+    #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+    DecodedDataCache<DirectoryEntry>                 m_decodeCache;
+    #endif
+
+public:
+
+    explicit DirectoryEntryArena(DirectoryEntry *pOwner) : m_pOwner(pOwner) {}
+
+    ~DirectoryEntryArena()
+    {
+        m_entries.clear();
+        m_children.clear();
+        m_fileData.clear();
+    }
+
+    DirectoryEntryArena(const DirectoryEntryArena&) = delete;
+    DirectoryEntryArena& operator=(const DirectoryEntryArena&) = delete;
+
+    DirectoryEntry* getOwner() const { return m_pOwner; }
+
+    #if defined(MARTY_RCFS_THREAD_SAFE)
+    std::mutex& getDecodeMutex() { return m_decodeMutex; }
+    std::condition_variable& getDecodeCondition() { return m_decodeCondition; }
+    #endif
+
+    #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+    DecodedDataCache<DirectoryEntry>& getDecodeCache() { return m_decodeCache; }
+    #endif
+
+    DirectoryEntry*          createEntry(bool isDirectory) { return m_entries.create(this, isDirectory); }
+    DirectoryEntryChildren*  createChildren()              { return m_children.create(); }
+    FileEntryData*           createFileData()              { return m_fileData.create(); }
+
+    InternedName             internName(std::string_view name)            { return m_names.intern(name); }
+    InternedName             findName(std::string_view name) const        { return m_names.find(name); }
+    InternedName             findNameNoCase(std::string_view name) const  { return m_names.findNoCase(name); }
+
+    //! Обходит все записи арены (без корня) - handler(DirectoryEntry&)
+    template<typename Handler>
+    void forEachEntry(Handler handler)
+    {
+        m_entries.forEachMutable(handler);
+    }
+
+    //! Отдаёт лишнюю память массивов дочерних элементов (вызывается при запечатывании)
+    void compact()
+    {
+        m_children.forEachMutable([](DirectoryEntryChildren &children) { children.compact(); });
+    }
+
+    DirectoryEntryMemoryStats getMemoryStats() const
+    {
+        DirectoryEntryMemoryStats stats;
+
+        stats.numDirectories = m_children.size();
+        stats.numFiles       = m_fileData.size();
+        stats.entryBytes     = sizeof(*this) + m_entries.bytesReserved();
+        stats.payloadBytes   = m_children.bytesReserved() + m_fileData.bytesReserved();
+        stats.nameBytes      = m_names.bytesReserved();
+        stats.numUniqueNames = m_names.size();
+
+        m_children.forEach([&](const DirectoryEntryChildren &children)
+                           {
+                               stats.childArrayBytes += children.items.capacity()*sizeof(DirectoryEntryChild)
+                                                      + children.hashIndex.capacity()*sizeof(std::uint32_t);
+                           }
+                          );
+
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        m_fileData.forEach([&](const FileEntryData &fileData)
+                           {
+                               stats.payloadBytes += fileData.fileDataDecrypted.capacity();
+                           }
+                          );
+        #endif
+
+        stats.totalBytes = stats.entryBytes + stats.payloadBytes + stats.childArrayBytes + stats.nameBytes;
+
+        return stats;
+    }
+
+}; // class DirectoryEntryArena
+
+//----------------------------------------------------------------------------
+
+
+
+//------------------------------
+inline
+DirectoryEntry::DirectoryEntry(DirectoryEntryArena *pArena, bool isDirectory)
+: m_attrs(isDirectory ? FileAttrs::DirectoryAttrsDefault : FileAttrs::FileAttrsDefault)
+, m_pArena(pArena)
+{
+    if (isDirectory)
+        m_pChildren = pArena->createChildren();
+    else
+        m_pFileData = pArena->createFileData();
+}
+
+//------------------------------
+inline
+DirectoryEntry::DirectoryEntry()
+: m_attrs(FileAttrs::DirectoryAttrsDefault)
+, m_pArena(new DirectoryEntryArena(this))
+{
+    m_pChildren = m_pArena->createChildren();
+}
+
+//------------------------------
+inline
+DirectoryEntry::DirectoryEntry( const std::uint8_t *pConstFileData, std::size_t fileSize
+                              #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+                              , unsigned decryptKeySize
+                              , unsigned decryptKeySeed
+                              , unsigned decryptKeyInc
+                              , unsigned codecChain
+                              #endif
+                              )
+: m_attrs(FileAttrs::FileAttrsDefault)
+, m_pArena(new DirectoryEntryArena(this))
+{
+    m_pFileData = m_pArena->createFileData();
+    m_pFileData->pConstFileData = pConstFileData;
+    m_pFileData->fileSize       = fileSize      ;
+    #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+    m_pFileData->decryptKeySize = decryptKeySize;
+    m_pFileData->decryptKeySeed = decryptKeySeed;
+    m_pFileData->decryptKeyInc  = decryptKeyInc ;
+    m_pFileData->codecChain     = codecChain    ;
+    #endif
+}
+
+//------------------------------
+inline
+DirectoryEntry::~DirectoryEntry()
+{
+    // Записи из арены разрушает сама арена
+    if (m_pArena && m_pArena->getOwner()==this)
+        delete m_pArena;
+}
+
+//------------------------------
+inline
+DirectoryEntryMemoryStats DirectoryEntry::getMemoryStats() const
+{
+    DirectoryEntryMemoryStats stats = m_pArena->getMemoryStats();
+
+    // Корень - не из арены
+    stats.entryBytes += sizeof(*m_pArena->getOwner());
+    stats.totalBytes += sizeof(*m_pArena->getOwner());
+
+    return stats;
+}
+
 //------------------------------
 inline
 const std::uint8_t* DirectoryEntry::getFileDataPtr() const
 {
-    if (!m_pConstFileData || !m_fileSize)
+    const FileEntryData *pFileData = getFileData();
+    if (!pFileData || !pFileData->pConstFileData || !pFileData->fileSize)
         return 0;
 
     #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-    if (!m_fileDataDecrypted.empty())
-        return m_fileDataDecrypted.data();
+    if (!pFileData->fileDataDecrypted.empty())
+        return pFileData->fileDataDecrypted.data();
     #endif
 
-    return m_pConstFileData;
+    return pFileData->pConstFileData;
 }
 
 //------------------------------
 inline
 std::size_t DirectoryEntry::getFileDataSize() const
 {
-    if (!m_pConstFileData || !m_fileSize)
+    const FileEntryData *pFileData = getFileData();
+    if (!pFileData || !pFileData->pConstFileData || !pFileData->fileSize)
         return 0;
 
     #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-    if (!m_fileDataDecrypted.empty())
-        return m_fileDataDecrypted.size();
+    if (!pFileData->fileDataDecrypted.empty())
+        return pFileData->fileDataDecrypted.size();
     #endif
 
-    return m_fileSize    ;
+    return pFileData->fileSize;
 }
 
 //------------------------------
@@ -312,21 +648,36 @@ bool DirectoryEntry::isDirectoryEntry() const
 //------------------------------
 //! Find child of any type
 inline
-DirectoryEntry* DirectoryEntry::findAnyChildEntry(const std::string &name) const
+DirectoryEntry* DirectoryEntry::findAnyChildEntry(std::string_view name) const
 {
-    if (name.empty())
+    const DirectoryEntryChildren *pChildren = getChildren();
+    if (!pChildren || name.empty())
         return 0;
 
-    DirectoryEntryMapType::const_iterator it = m_items.find(name);
-    if (it==m_items.end())
+    // Имени нет в таблице - значит, нет и в дереве
+    InternedName interned = m_pArena->findName(name);
+    if (interned.empty())
         return 0;
-    return const_cast<DirectoryEntry*>(&it->second);
+
+    return pChildren->find(interned);
+}
+
+//------------------------------
+//! Find child of any type by interned name
+inline
+DirectoryEntry* DirectoryEntry::findAnyChildEntry(InternedName name) const
+{
+    const DirectoryEntryChildren *pChildren = getChildren();
+    if (!pChildren || name.empty())
+        return 0;
+
+    return pChildren->find(name);
 }
 
 //------------------------------
 //! Find child exact file or directory
 inline
-DirectoryEntry* DirectoryEntry::findExactChildEntry(const std::string &name, bool findDirectory) const
+DirectoryEntry* DirectoryEntry::findExactChildEntry(std::string_view name, bool findDirectory) const
 {
     if (name.empty())
         return 0;
@@ -341,20 +692,55 @@ DirectoryEntry* DirectoryEntry::findExactChildEntry(const std::string &name, boo
     return 0;
 }
 
+//------------------------------
+//! Find child of any type, ignoring ASCII case
+inline
+DirectoryEntry* DirectoryEntry::findAnyChildEntryNoCase(std::string_view name) const
+{
+    const DirectoryEntryChildren *pChildren = getChildren();
+    if (!pChildren || name.empty())
+        return 0;
+
+    InternedName interned = m_pArena->findNameNoCase(name);
+    if (interned.empty())
+        return 0;
+
+    return pChildren->find(interned);
+}
+
+//------------------------------
+//! Find child exact file or directory, ignoring ASCII case
+inline
+DirectoryEntry* DirectoryEntry::findExactChildEntryNoCase(std::string_view name, bool findDirectory) const
+{
+    DirectoryEntry* pEntry = findAnyChildEntryNoCase(name);
+    if (!pEntry)
+         return pEntry;
+
+    if (pEntry->isDirectoryEntry()==findDirectory)
+         return pEntry;
+
+    return 0;
+}
+
 //------------------------------
 //! Create direct child directory entry
 inline
-DirectoryEntry* DirectoryEntry::createDirectoryChildEntry(const std::string &name, bool failOnExist)
+DirectoryEntry* DirectoryEntry::createDirectoryChildEntry(std::string_view name, bool failOnExist)
 {
-    if (name.empty())
+    DirectoryEntryChildren *pChildren = getChildren();
+    if (!pChildren || name.empty())
         return 0;
 
-    DirectoryEntry* pChildEntry = findAnyChildEntry(name);
+    InternedName interned = m_pArena->internName(name);
+
+    DirectoryEntry* pChildEntry = pChildren->find(interned);
     if (pChildEntry==0)
     {
         // Записи не существует, можно создавать
-        m_items[name] = DirectoryEntry();
-        return &m_items[name];
+        pChildEntry = m_pArena->createEntry(true /* isDirectory */);
+        pChildren->add(interned, pChildEntry);
+        return pChildEntry;
     }
 
     if (!pChildEntry->isDirectoryEntry())
@@ -374,17 +760,21 @@ DirectoryEntry* DirectoryEntry::createDirectoryChildEntry(const std::string &nam
 //------------------------------
 //! Create direct child file entry
 inline
-DirectoryEntry* DirectoryEntry::createFileChildEntry(const std::string &name)
+DirectoryEntry* DirectoryEntry::createFileChildEntry(std::string_view name)
 {
-    if (name.empty())
+    DirectoryEntryChildren *pChildren = getChildren();
+    if (!pChildren || name.empty())
         return 0;
 
-    DirectoryEntry* pChildEntry = findAnyChildEntry(name);
+    InternedName interned = m_pArena->internName(name);
+
+    DirectoryEntry* pChildEntry = pChildren->find(interned);
     if (pChildEntry==0)
     {
         // Записи не существует, можно создавать
-        m_items[name] = DirectoryEntry(0,0);
-        return &m_items[name];
+        pChildEntry = m_pArena->createEntry(false /* isDirectory */);
+        pChildren->add(interned, pChildEntry);
+        return pChildEntry;
     }
 
     return 0;
@@ -394,16 +784,24 @@ DirectoryEntry* DirectoryEntry::createFileChildEntry(const std::string &name)
 inline
 bool DirectoryEntry::resetFileEntryData()
 {
+    FileEntryData *pFileData = getFileData();
+    if (!pFileData)
+        return false;
+
     if (locked())
         return false;
 
-    m_pConstFileData = 0;
-    m_fileSize       = 0;
+    pFileData->pConstFileData = 0;
+    pFileData->fileSize       = 0;
     #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-    m_decryptKeySize = 0;
-    m_decryptKeySeed = 0;
-    m_decryptKeyInc  = 0;
-    m_fileDataDecrypted.clear();
+    pFileData->decryptKeySize = 0;
+    pFileData->decryptKeySeed = 0;
+    pFileData->decryptKeyInc  = 0;
+    pFileData->codecChain     = 0;
+    pFileData->decodedSize    = (std::size_t)-1;
+    m_pArena->getDecodeCache().remove(this);
+    pFileData->fileDataDecrypted.clear();
+    decode_state_utils::store(pFileData->decodeState, FileDecodeState::NotDecoded);
     #endif
 
     return true;
@@ -417,19 +815,28 @@ bool DirectoryEntry::assignFileEntryData( const std::uint8_t *pConstFileData
                                         , unsigned            decryptKeySize
                                         , unsigned            decryptKeySeed
                                         , unsigned            decryptKeyInc
+                                        , unsigned            codecChain
                                         #endif
                                         )
 {
+    FileEntryData *pFileData = getFileData();
+    if (!pFileData)
+        return false;
+
     if (locked())
         return false;
 
-    m_pConstFileData = pConstFileData;
-    m_fileSize       = fileSize      ;
+    pFileData->pConstFileData = pConstFileData;
+    pFileData->fileSize       = fileSize      ;
     #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-    m_decryptKeySize = decryptKeySize;
-    m_decryptKeySeed = decryptKeySeed;
-    m_decryptKeyInc = decryptKeyInc ;
-    m_fileDataDecrypted.clear();
+    pFileData->decryptKeySize = decryptKeySize;
+    pFileData->decryptKeySeed = decryptKeySeed;
+    pFileData->decryptKeyInc  = decryptKeyInc ;
+    pFileData->codecChain     = codecChain    ;
+    pFileData->decodedSize    = (std::size_t)-1;
+    m_pArena->getDecodeCache().remove(this);
+    pFileData->fileDataDecrypted.clear();
+    decode_state_utils::store(pFileData->decodeState, FileDecodeState::NotDecoded);
     #endif
 
     return true;
@@ -458,4 +865,3 @@ DirectoryEntry* getDefaultRootDirectoryEntry()
 
 } // namespace marty_rcfs
 
-
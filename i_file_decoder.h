@@ -1,8 +1,23 @@
 #pragma once
 
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Интерфейсы декодеров данных файлов (IFileDecoder, IRangeFileDecoder) и декодер-заглушка
+
+    Встроенные декодеры (XOR, LZ, цепочки кодеков) - в rcfs_file_decoders.h,
+    чтобы пользователю со своим декодером не тянуть за собой кодеки и потоки.
+*/
+
+//----------------------------------------------------------------------------
+
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "rcfs_codec_chain_defs.h"
 
 //----------------------------------------------------------------------------
 
@@ -27,6 +42,8 @@ namespace marty_rcfs {
 //----------------------------------------------------------------------------
 
 
+struct IRangeFileDecoder;
+
 struct IFileDecoder
 {
     virtual ~IFileDecoder() {}
@@ -39,10 +56,218 @@ struct IFileDecoder
                        , unsigned decryptKeyInc
                        ) const = 0;
 
+    //! Расширение для декодирования диапазонов (см. IRangeFileDecoder). 0 - декодер его не поддерживает
+    virtual
+    const IRangeFileDecoder* getRangeDecoder() const
+    {
+        return 0;
+    }
+
+    //! Размер данных файла после декодирования, без декодирования
+    /*! Если декодирование файлу не требуется (decodeFileData вернёт false) - fileSize.
+        (std::size_t)-1 - размер до декодирования неизвестен.
+     */
+    virtual
+    std::size_t getDecodedSize( const std::uint8_t *pFileData
+                              , std::size_t          fileSize
+                              , unsigned decryptKeySize
+                              , unsigned decryptKeySeed
+                              , unsigned decryptKeyInc
+                              ) const
+    {
+        MARTY_ARG_USED(pFileData);
+        MARTY_ARG_USED(fileSize);
+        MARTY_ARG_USED(decryptKeySize);
+        MARTY_ARG_USED(decryptKeySeed);
+        MARTY_ARG_USED(decryptKeyInc );
+
+        return (std::size_t)-1;
+    }
+
+    //! Декодирование с цепочкой кодеков записи (см. rcfs_codec_chain.h)
+    /*! ResourceFileSystem вызывает эту функцию. По умолчанию поддерживается только
+        пустая цепочка - вызывается decodeFileData.
+     */
+    virtual
+    bool decodeFileDataChain( std::vector<std::uint8_t> &decodedData
+                            , const std::uint8_t *pFileData
+                            , std::size_t          fileSize
+                            , unsigned codecChain
+                            , unsigned decryptKeySize
+                            , unsigned decryptKeySeed
+                            , unsigned decryptKeyInc
+                            ) const
+    {
+        if (codecChain!=codecChainDefault)
+            throw std::runtime_error("IFileDecoder::decodeFileDataChain: codec chains are not supported by this decoder");
+
+        return decodeFileData(decodedData, pFileData, fileSize, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    //! getDecodedSize с цепочкой кодеков записи
+    virtual
+    std::size_t getDecodedSizeChain( const std::uint8_t *pFileData
+                                   , std::size_t          fileSize
+                                   , unsigned codecChain
+                                   , unsigned decryptKeySize
+                                   , unsigned decryptKeySeed
+                                   , unsigned decryptKeyInc
+                                   ) const
+    {
+        if (codecChain!=codecChainDefault)
+            return (std::size_t)-1;
+
+        return getDecodedSize(pFileData, fileSize, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    //! Декодирование в буфер вызывающего (пул, арена, буфер чтения) ровно dstSize байт
+    /*! dstSize - размер декодированных данных, его до декодирования сообщает getDecodedSizeChain
+        (если он неизвестен - (std::size_t)-1 - декодировать можно только через decodeFileDataChain).
+        false - декодирование не требуется, данные читаются как есть, pDst не изменяется.
+        Если данные повреждены или декодируются не в dstSize байт - исключение.
+        По умолчанию - через decodeFileDataChain во временный вектор и копирование;
+        декодеры, которые умеют писать сразу в буфер, переопределяют эту функцию.
+     */
+    virtual
+    bool decodeFileDataTo( std::uint8_t        *pDst
+                         , std::size_t          dstSize
+                         , const std::uint8_t  *pFileData
+                         , std::size_t          fileSize
+                         , unsigned codecChain
+                         , unsigned decryptKeySize
+                         , unsigned decryptKeySeed
+                         , unsigned decryptKeyInc
+                         ) const
+    {
+        std::vector<std::uint8_t> decodedData;
+        if (!decodeFileDataChain(decodedData, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc))
+            return false;
+
+        if (decodedData.size()!=dstSize)
+            throw std::runtime_error("IFileDecoder::decodeFileDataTo: decoded size mismatch");
+
+        std::memcpy(pDst, decodedData.data(), dstSize);
+        return true;
+    }
+
 }; // struct IFileDecoder
 
 
 
+//----------------------------------------------------------------------------
+//! Состояние декодирования диапазонов одного открытого файла (например, кэш последнего куска)
+/*! Создаётся IRangeFileDecoder::createRangeDecodeState при открытии файла,
+    принадлежит дескриптору и удаляется при закрытии файла.
+ */
+struct IRangeDecodeState
+{
+    virtual ~IRangeDecodeState() {}
+
+}; // struct IRangeDecodeState
+
+
+
+//----------------------------------------------------------------------------
+//! Декодирование произвольного диапазона файла без декодирования предыдущих данных
+/*! canDecodeRange/decodeFileDataRange - для файлов без цепочки кодеков: размер декодированных
+    данных равен размеру закодированных, байт декодированных данных с номером i зависит только
+    от байта i исходных данных и его позиции.
+    Файлы с цепочкой (например, контейнер кусков, rcfs_chunked.h) декодируются по диапазонам
+    через canDecodeRangeChain/decodeFileDataRangeChain - позиции в них указываются в
+    декодированных данных, размер которых сообщает IFileDecoder::getDecodedSizeChain.
+    Используется ResourceFileSystem в режиме декодирования диапазонов (setRangeDecodeMode).
+ */
+struct IRangeFileDecoder
+{
+    virtual ~IRangeFileDecoder() {}
+
+    //! Можно ли декодировать файл с такими параметрами по диапазонам. false - файл декодируется целиком через IFileDecoder
+    virtual
+    bool canDecodeRange( unsigned decryptKeySize
+                       , unsigned decryptKeySeed
+                       , unsigned decryptKeyInc
+                       ) const = 0;
+
+    //! Декодирует size байт файла, начиная с offset, в pDst. offset+size<=fileSize
+    virtual
+    bool decodeFileDataRange( std::uint8_t        *pDst
+                            , const std::uint8_t  *pFileData
+                            , std::size_t          fileSize
+                            , std::size_t          offset
+                            , std::size_t          size
+                            , unsigned decryptKeySize
+                            , unsigned decryptKeySeed
+                            , unsigned decryptKeyInc
+                            ) const = 0;
+
+    //! canDecodeRange с цепочкой кодеков записи. По умолчанию - только без цепочки или с цепочкой codecChainXor
+    virtual
+    bool canDecodeRangeChain( unsigned codecChain
+                            , unsigned decryptKeySize
+                            , unsigned decryptKeySeed
+                            , unsigned decryptKeyInc
+                            ) const
+    {
+        if (codecChain!=codecChainDefault && codecChain!=codecChainXor)
+            return false;
+
+        return canDecodeRange(decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    //! Декодирует size байт декодированных данных файла, начиная с offset, в pDst. pFileData/fileSize - закодированные данные
+    /*! По умолчанию - decodeFileDataRange.
+     */
+    virtual
+    bool decodeFileDataRangeChain( std::uint8_t        *pDst
+                                 , const std::uint8_t  *pFileData
+                                 , std::size_t          fileSize
+                                 , unsigned             codecChain
+                                 , std::size_t          offset
+                                 , std::size_t          size
+                                 , unsigned decryptKeySize
+                                 , unsigned decryptKeySeed
+                                 , unsigned decryptKeyInc
+                                 ) const
+    {
+        MARTY_ARG_USED(codecChain);
+
+        return decodeFileDataRange(pDst, pFileData, fileSize, offset, size, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    //! Создаёт состояние декодирования для открываемого файла. 0 - состояние не нужно
+    virtual
+    IRangeDecodeState* createRangeDecodeState(unsigned codecChain) const
+    {
+        MARTY_ARG_USED(codecChain);
+        return 0;
+    }
+
+    //! decodeFileDataRangeChain с состоянием открытого файла (pState - из createRangeDecodeState, может быть 0)
+    /*! ResourceFileSystem вызывает эту функцию. Может вызываться параллельно с одним pState.
+        По умолчанию - decodeFileDataRangeChain.
+     */
+    virtual
+    bool decodeFileDataRangeState( IRangeDecodeState   *pState
+                                 , std::uint8_t        *pDst
+                                 , const std::uint8_t  *pFileData
+                                 , std::size_t          fileSize
+                                 , unsigned             codecChain
+                                 , std::size_t          offset
+                                 , std::size_t          size
+                                 , unsigned decryptKeySize
+                                 , unsigned decryptKeySeed
+                                 , unsigned decryptKeyInc
+                                 ) const
+    {
+        MARTY_ARG_USED(pState);
+
+        return decodeFileDataRangeChain(pDst, pFileData, fileSize, codecChain, offset, size, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+}; // struct IRangeFileDecoder
+
+
+
 //----------------------------------------------------------------------------
 struct NoDecodeFileDecoder : public IFileDecoder
 {
@@ -65,6 +290,39 @@ struct NoDecodeFileDecoder : public IFileDecoder
 
         return false;
     }
+
+    virtual
+    std::size_t getDecodedSize( const std::uint8_t *pFileData
+                              , std::size_t          fileSize
+                              , unsigned decryptKeySize
+                              , unsigned decryptKeySeed
+                              , unsigned decryptKeyInc
+                              ) const override
+    {
+        MARTY_ARG_USED(pFileData);
+        MARTY_ARG_USED(decryptKeySize);
+        MARTY_ARG_USED(decryptKeySeed);
+        MARTY_ARG_USED(decryptKeyInc );
+
+        return fileSize;
+    }
+
+    virtual
+    bool decodeFileDataTo( std::uint8_t        *pDst
+                         , std::size_t          dstSize
+                         , const std::uint8_t  *pFileData
+                         , std::size_t          fileSize
+                         , unsigned codecChain
+                         , unsigned decryptKeySize
+                         , unsigned decryptKeySeed
+                         , unsigned decryptKeyInc
+                         ) const override
+    {
+        if (codecChain!=codecChainDefault)
+            return IFileDecoder::decodeFileDataTo(pDst, dstSize, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc);
+
+        return false;
+    }
 };
 
 
@@ -95,6 +353,8 @@ IFileDecoder* getDefaultNoDecodeFileDecoder()
 // #include <stdexcept>
 
 // Не хочу RC FS связывать жестко с XOR Encrypt
+// Оставлен для совместимости - встроенный marty_rcfs::XorFileDecoder (rcfs_file_decoders.h)
+// декодирует те же данные без _2c и без копирования
 // Делаем макрос, чтобы по месту без лишней пыли определить класс декодера, использующего XOR Encrypt
 
 #define MARTY_RCFS_IMPLEMENT_XOR_DECRYPT_FILE_DECODER(className) \
@@ -116,9 +376,49 @@ struct className : public marty_rcfs::IFileDecoder               \
        if (decryptKeySize!=1 && decryptKeySize!=2 && decryptKeySize!=4) \
            throw std::runtime_error( #className "::decodeFileData: invalid decryptKeySize"); \
                                                                                              \
-       std::vector<std::uint8_t> tmpData = std::vector<std::uint8_t>(pFileData, pFileData+fileSize); \
-       _2c::xorDecrypt(tmpData.begin(), tmpData.end(), (_2c::EKeySize)decryptKeySize, decryptKeySeed, decryptKeyInc); \
-       std::swap(decodedData, tmpData);                          \
+       decodedData.assign(pFileData, pFileData+fileSize); /* Ёмкость переиспользуется */ \
+       _2c::xorDecrypt(decodedData.begin(), decodedData.end(), (_2c::EKeySize)decryptKeySize, decryptKeySeed, decryptKeyInc); \
+                                                                 \
+       return true;                                              \
+   }                                                             \
+                                                                 \
+   virtual                                                       \
+   std::size_t getDecodedSize( const std::uint8_t *pFileData     \
+                             , std::size_t          fileSize     \
+                             , unsigned decryptKeySize           \
+                             , unsigned decryptKeySeed           \
+                             , unsigned decryptKeyInc            \
+                             ) const override                    \
+   {                                                             \
+       MARTY_ARG_USED(pFileData); MARTY_ARG_USED(decryptKeySize); MARTY_ARG_USED(decryptKeySeed); MARTY_ARG_USED(decryptKeyInc); \
+       return fileSize; /* XOR не меняет размер */               \
+   }                                                             \
+                                                                 \
+   virtual                                                       \
+   bool decodeFileDataTo( std::uint8_t        *pDst              \
+                        , std::size_t          dstSize           \
+                        , const std::uint8_t  *pFileData         \
+                        , std::size_t          fileSize          \
+                        , unsigned codecChain                    \
+                        , unsigned decryptKeySize                \
+                        , unsigned decryptKeySeed                \
+                        , unsigned decryptKeyInc                 \
+                        ) const override                         \
+   {                                                             \
+       if (codecChain!=marty_rcfs::codecChainDefault)            \
+           return marty_rcfs::IFileDecoder::decodeFileDataTo(pDst, dstSize, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc); \
+                                                                 \
+       if (decryptKeySize==0)                                    \
+           return false; /* Not required decription */           \
+                                                                 \
+       if (decryptKeySize!=1 && decryptKeySize!=2 && decryptKeySize!=4) \
+           throw std::runtime_error( #className "::decodeFileDataTo: invalid decryptKeySize"); \
+                                                                 \
+       if (dstSize!=fileSize)                                    \
+           throw std::runtime_error( #className "::decodeFileDataTo: decoded size mismatch"); \
+                                                                 \
+       std::memcpy(pDst, pFileData, fileSize);                   \
+       _2c::xorDecrypt(pDst, pDst+fileSize, (_2c::EKeySize)decryptKeySize, decryptKeySeed, decryptKeyInc); \
                                                                  \
        return true;                                              \
    }                                                             \
@@ -4,6 +4,13 @@
 //----------------------------------------------------------------------------
 #include "common.h"
 #include "directory_entry.h"
+#include "rcfs_path.h"
+#include "rcfs_static_index.h"
+#include "rcfs_descriptor_table.h"
+
+#if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+    #include "rcfs_flat_index.h"
+#endif
 
 #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
     #include "i_file_decoder.h"
@@ -12,12 +19,18 @@
 #include "../common/undef_min_max.h"
 
 #include <utility>
-#include <unordered_map>
-#include <map>
+#include <memory>
 #include <exception>
 #include <stdexcept>
 #include <cstring>
+#include <string_view>
 #include <utility>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 
 //
@@ -55,6 +68,96 @@ namespace marty_rcfs {
 
 class ResourceFileSystem;
 
+//----------------------------------------------------------------------------
+//! Идентификатор ресурса - путь, разрешённый один раз через ResourceFileSystem::resolve
+/*! Открытие, размер и чтение по идентификатору не разбирают путь и не ходят по дереву.
+    Записи дерева не удаляются и не перемещаются, поэтому идентификатор действителен,
+    пока живо дерево (для статической таблицы - пока жива таблица).
+ */
+class ResourceId
+{
+    friend class ResourceFileSystem;
+
+    DirectoryEntry          *pFileEntry   = 0;
+    const StaticFileEntry   *pStaticEntry = 0;
+
+    ResourceId(DirectoryEntry *pEntry, const StaticFileEntry *pStatic) : pFileEntry(pEntry), pStaticEntry(pStatic) {}
+
+public:
+
+    ResourceId() {}
+
+    bool valid() const { return pFileEntry!=0 || pStaticEntry!=0; }
+    explicit operator bool() const { return valid(); }
+
+    bool operator==(const ResourceId &other) const { return pFileEntry==other.pFileEntry && pStaticEntry==other.pStaticEntry; }
+    bool operator!=(const ResourceId &other) const { return !(*this==other); }
+
+    DirectoryEntry*        getFileEntry  () const { return pFileEntry;   }
+    const StaticFileEntry* getStaticEntry() const { return pStaticEntry; }
+
+}; // class ResourceId
+
+//----------------------------------------------------------------------------
+//! Данные файла без копирования - указатель и размер
+/*! Получается для открытого файла (ResourceFileSystem::getFileView, AutoFileHandle::getView).
+    Открытый файл заблокирован (lock count), поэтому данные не меняются и не освобождаются,
+    пока файл не закрыт. После закрытия представление использовать нельзя.
+    begin()/end()/data()/size() позволяют построить из него std::span (C++20).
+ */
+class FileView
+{
+    const std::uint8_t     *m_pData = 0;
+    std::size_t             m_size  = 0;
+
+public:
+
+    FileView() {}
+    FileView(const std::uint8_t *pData, std::size_t size) : m_pData(pData), m_size(size) {}
+
+    const std::uint8_t* data () const { return m_pData; }
+    std::size_t         size () const { return m_size;  }
+    bool                empty() const { return m_size==0; }
+
+    const std::uint8_t* begin() const { return m_pData; }
+    const std::uint8_t* end  () const { return m_pData+m_size; }
+
+    std::uint8_t operator[](std::size_t idx) const { return m_pData[idx]; }
+
+    std::string_view toStringView() const { return std::string_view((const char*)m_pData, m_size); }
+
+    //! Часть данных, обрезается по размеру
+    FileView subView(std::size_t pos, std::size_t count = (std::size_t)-1) const
+    {
+        if (pos>=m_size)
+            return FileView();
+
+        std::size_t rest = m_size - pos;
+        return FileView(m_pData+pos, count<rest ? count : rest);
+    }
+
+}; // class FileView
+
+//----------------------------------------------------------------------------
+//! Буфер для чтения вразброс (readvFile) - как iovec
+struct ReadIoVec
+{
+    void               *pData = 0;
+    std::size_t         size  = 0;
+
+}; // struct ReadIoVec
+
+//----------------------------------------------------------------------------
+//! Откуда отсчитывается смещение в ResourceFileSystem::seekFile
+enum class SeekOrigin
+{
+    Begin,
+    Current,
+    End
+
+}; // enum class SeekOrigin
+
+//----------------------------------------------------------------------------
 class AutoFileHandle
 {
     ResourceFileSystem *pRcfs;
@@ -70,7 +173,8 @@ public:
     AutoFileHandle& operator=(const AutoFileHandle&) = delete;
     AutoFileHandle& operator=(AutoFileHandle&&) = delete;
 
-    bool open (const std::string &fullName);
+    bool open (std::string_view fullName);
+    bool open (const ResourceId &resourceId);
     bool close();
 
     bool read(std::vector<std::uint8_t> &buf, std::size_t nBytesToRead) const;
@@ -81,6 +185,19 @@ public:
     bool read(std::vector<char> &buf) const;
     bool read(std::string &buf) const;
 
+    bool readAppend(std::vector<std::uint8_t> &buf, std::size_t nBytesToRead) const;
+    bool readAppend(std::vector<char> &buf, std::size_t nBytesToRead) const;
+    bool readAppend(std::string &buf, std::size_t nBytesToRead) const;
+
+    bool readv(const ReadIoVec *pIoVecs, std::size_t numIoVecs, std::size_t *pBytesReaded) const;
+
+    FileView getView() const; //!< Данные открытого файла без копирования, действительны до close()
+
+    bool        read (std::uint8_t *pBuf, std::size_t nBytesToRead, std::size_t *pBytesReaded) const;
+    bool        pread(std::size_t offset, std::uint8_t *pBuf, std::size_t nBytesToRead, std::size_t *pBytesReaded) const;
+    bool        seek (std::ptrdiff_t offset, SeekOrigin origin = SeekOrigin::Begin) const;
+    std::size_t tell () const;
+
     // bool closeFile(int iFile) const
     // int openFile(const std::string &fullName) const
 
@@ -94,6 +211,110 @@ public:
 
 
 //----------------------------------------------------------------------------
+//! Сведения о файле по метаданным (ResourceFileSystem::statFile)
+struct FileStat
+{
+    std::size_t     size        = 0;     //!< Размер читаемых (декодированных) данных. (std::size_t)-1 - декодер не сообщает размер до декодирования
+    std::size_t     storedSize  = 0;     //!< Размер хранимых данных
+    bool            encoded     = false; //!< Для файла задан ключ декодирования
+    bool            staticEntry = false; //!< Файл из статической таблицы
+
+}; // struct FileStat
+
+//----------------------------------------------------------------------------
+//! Статистика пакетного чтения
+struct BatchReadStats
+{
+    std::size_t     numRequested = 0;
+    std::size_t     numFound     = 0;
+    std::size_t     numDecoded   = 0; //!< Декодировано этим пакетом (остальные не требуют декодирования или уже декодированы)
+    std::size_t     numCopied    = 0; //!< Скопировано в буферы пакета (режим копирования)
+    std::size_t     bytesFound   = 0; //!< Суммарный размер найденных файлов
+    std::size_t     bytesCopied  = 0;
+
+}; // struct BatchReadStats
+
+//----------------------------------------------------------------------------
+//! Статистика предварительного декодирования (ResourceFileSystem::warmUp)
+struct WarmUpStats
+{
+    std::size_t     numFiles     = 0; //!< Файлов с данными
+    std::size_t     numDecoded   = 0; //!< Декодировано (остальные не требуют декодирования или уже были декодированы)
+    std::size_t     bytesDecoded = 0; //!< Объём декодированных данных
+    unsigned        numThreads   = 0;
+    double          wallTime     = 0; //!< Секунды
+
+}; // struct WarmUpStats
+
+//----------------------------------------------------------------------------
+//! Результат пакетного чтения (ResourceFileSystem::readBatch)
+/*! Без копирования найденные файлы остаются заблокированными, пока пакет не
+    освобождён (release, повторный readBatch или деструктор), и их представления
+    действительны. В режиме копирования представления указывают на буферы пакета;
+    буферы переиспользуются при повторных readBatch.
+    Пакет не должен жить дольше дерева ФС.
+ */
+class ResourceBatch
+{
+    friend class ResourceFileSystem;
+
+public:
+
+    struct Item
+    {
+        ResourceId                      id;     //!< Недействителен - файл не найден
+        FileView                        view;
+        std::vector<std::uint8_t>       data;   //!< Копия данных (только в режиме копирования)
+    };
+
+protected:
+
+    std::vector<Item>                   m_items;
+    std::vector<DirectoryEntry*>        m_lockedEntries;
+    std::vector<std::uint32_t>          m_order;         //!< Порядок обхода при разрешении путей
+    BatchReadStats                      m_stats;
+
+public:
+
+    ResourceBatch() {}
+    ~ResourceBatch() { release(); }
+
+    ResourceBatch(const ResourceBatch&) = delete;
+    ResourceBatch& operator=(const ResourceBatch&) = delete;
+
+    //! Снимает блокировки с файлов. Представления без копирования становятся недействительными
+    void release()
+    {
+        for(DirectoryEntry *pEntry : m_lockedEntries)
+            pEntry->unlock();
+
+        m_lockedEntries.clear();
+    }
+
+    std::size_t size() const { return m_items.size(); }
+    const Item& operator[](std::size_t idx) const { return m_items[idx]; }
+
+    std::vector<Item>::const_iterator begin() const { return m_items.begin(); }
+    std::vector<Item>::const_iterator end  () const { return m_items.end(); }
+
+    const BatchReadStats& getStats() const { return m_stats; }
+
+}; // class ResourceBatch
+
+//----------------------------------------------------------------------------
+//! Файловая система ресурсов
+/*! Многопоточность (MARTY_RCFS_THREAD_SAFE):
+    - дерево заполняется и запечатывается (seal) до начала многопоточной работы;
+    - после этого openFile/readFile/getFileSize/closeFile можно вызывать из любых потоков одновременно;
+    - поиск по дереву и индексам только читает и блокировок не берёт;
+    - таблица дескрипторов поделена на шарды, поиск дескриптора - без блокировок;
+    - счётчики блокировок записей атомарные;
+    - декодирование данных файла выполняется под мьютексом дерева, один раз;
+    - один дескриптор не должен одновременно использоваться для чтения из разных потоков
+      (кроме preadFile/preadvFile - они позицию чтения не читают и не меняют, и могут идти
+      параллельно с чем угодно на том же дескрипторе).
+    Без MARTY_RCFS_THREAD_SAFE синхронизация - на вызывающей стороне.
+ */
 class ResourceFileSystem
 {
 
@@ -101,42 +322,44 @@ protected:
 
     struct OpenedFileInfo
     {
-        DirectoryEntry  *pFileEntry = 0;
-        std::size_t      readPos    = 0;
+        DirectoryEntry         *pFileEntry   = 0;
+        std::size_t             readPos      = 0;
+        const StaticFileEntry  *pStaticEntry = 0; //!< Файл из статической таблицы (pFileEntry при этом 0)
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        const IRangeFileDecoder *pRangeDecoder = 0; //!< Не 0 - данные файла не декодированы, при чтении декодируется только читаемый диапазон
+        std::shared_ptr<IRangeDecodeState> pRangeState; //!< Состояние декодирования диапазонов (кэш последнего куска), освобождается при закрытии файла
+        #endif
     };
 
 
 
     //------------------------------
 
-    #if defined(MARTY_RCFS_ORDERED)
-        typedef std::map<int, OpenedFileInfo>            OpenedFileInfoMapType;
-    #else
-        typedef std::unordered_map<int, OpenedFileInfo>  OpenedFileInfoMapType;
-    #endif
+    typedef DescriptorTable<OpenedFileInfo>              OpenedFileTableType;
 
 
     bool                                                m_caseSens = false; //!< Устанавливается один раз при инициализации и поменять нельзя
     DirectoryEntry                                     *m_pRootDirectory;
     #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
     IFileDecoder                                       *m_pFileDecoder ;
+    bool                                                m_rangeDecode = false; //!< Режим декодирования диапазонов
     #endif
 
-    mutable int                                        m_nextDescriptor = 1; // 31 бит хватит для всех. Для многопоточки надо бы атомики !!!
-    mutable OpenedFileInfoMapType                      m_openedFiles;        // В многопотоке эту мапу надо бы защитить !!!
+    mutable OpenedFileTableType                        m_openedFiles;        // Поиск без блокировок, при MARTY_RCFS_THREAD_SAFE - шарды со своими мьютексами
 
 
     mutable bool                                       m_sealed = false; //!< Запечатано - больше нельзя обновлять ресурсы
 
-    //------------------------------
+    #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+    mutable std::shared_ptr<const FlatIndex>           m_pFlatIndex; //!< Строится при запечатывании, неизменяемый, разделяется копиями
+    #endif
 
+    StaticIndexView                                    m_staticIndex; //!< Статическая (constexpr) таблица ресурсов, просматривается раньше дерева
+
+    //------------------------------
 
 
 
-    int generateFileDescriptor() const
-    {
-        return m_nextDescriptor++;
-    }
 
     void checkRoot() const
     {
@@ -165,8 +388,13 @@ public:
     , m_pRootDirectory(std::move(rcfsOther.m_pRootDirectory))
     #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
     , m_pFileDecoder(std::move(rcfsOther.m_pFileDecoder))
+    , m_rangeDecode(rcfsOther.m_rangeDecode)
     #endif
     , m_sealed(std::move(rcfsOther.m_sealed))
+    #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+    , m_pFlatIndex(std::move(rcfsOther.m_pFlatIndex))
+    #endif
+    , m_staticIndex(rcfsOther.m_staticIndex)
     {}
 
     ResourceFileSystem( const ResourceFileSystem& rcfsOther )
@@ -174,15 +402,63 @@ public:
     , m_pRootDirectory(rcfsOther.m_pRootDirectory)
     #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
     , m_pFileDecoder(rcfsOther.m_pFileDecoder)
+    , m_rangeDecode(rcfsOther.m_rangeDecode)
     #endif
     , m_sealed(rcfsOther.m_sealed)
+    #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+    , m_pFlatIndex(rcfsOther.m_pFlatIndex)
+    #endif
+    , m_staticIndex(rcfsOther.m_staticIndex)
     {}
 
 
-    void seal() const
+    //! Запечатывает ФС. Если buildFlatIndex - дерево компилируется в плоский индекс, и поиск идёт по нему
+    void seal(bool buildFlatIndex = true) const
     {
         m_sealed = true;
+
+        if (m_pRootDirectory)
+            m_pRootDirectory->getArena()->compact();
+
+        #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+        m_pFlatIndex.reset();
+        if (buildFlatIndex && m_pRootDirectory)
+        {
+            std::shared_ptr<FlatIndex> pFlatIndex = std::make_shared<FlatIndex>();
+            pFlatIndex->build(m_pRootDirectory);
+            m_pFlatIndex = pFlatIndex;
+        }
+        #else
+        MARTY_ARG_USED(buildFlatIndex);
+        #endif
+    }
+
+    bool isSealed() const { return m_sealed; }
+
+    #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+    //! Статистика плоского индекса (нулевая, если индекс не построен)
+    FlatIndexStats getFlatIndexStats() const
+    {
+        if (!m_pFlatIndex)
+            return FlatIndexStats();
+        return m_pFlatIndex->getStats();
+    }
+
+    const FlatIndex* getFlatIndex() const { return m_pFlatIndex.get(); }
+
+    //! Содержимое каталога по плоскому индексу - непрерывный диапазон записей [pBegin, pEnd)
+    /*! false - индекс не построен, путь слишком глубокий для разбора без аллокаций или каталог не найден
+     */
+    bool findFlatIndexChildren(std::string_view dirPath, const FlatIndex::Record *&pBegin, const FlatIndex::Record *&pEnd) const
+    {
+        PathPartsView  pathParts;
+
+        if (!m_pFlatIndex || !splitPathNoAlloc(dirPath, pathParts))
+            return false;
+
+        return m_pFlatIndex->findChildren(pathParts, m_caseSens, pBegin, pEnd);
     }
+    #endif
 
 
     bool getCaseSens() const { return m_caseSens; }
@@ -190,46 +466,226 @@ public:
     #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
     IFileDecoder* getFileDecoder() const { return m_pFileDecoder; }
 
+    //! Устанавливает декодер. Размеры декодированных данных в записях пересчитываются новым декодером
     IFileDecoder* setFileDecoder(IFileDecoder* pFileDecoder)
     {
         std::swap(m_pFileDecoder, pFileDecoder);
+
+        if (m_pRootDirectory)
+            m_pRootDirectory->getArena()->forEachEntry([&](DirectoryEntry &entry) { updateDecodedSize(&entry); });
+
         return pFileDecoder;
     }
-    #endif
 
-    DirectoryEntry* getRootDirectory() const { return m_pRootDirectory; }
+    //! Режим декодирования диапазонов
+    /*! Если декодер поддерживает IRangeFileDecoder, файл при открытии не декодируется:
+        чтение декодирует только читаемый диапазон прямо в буфер вызывающего.
+        Полная декодированная копия при этом не создаётся, и getFileView для таких
+        файлов возвращает пустое представление (ResourceStreamBuf тогда читает кусками).
+        Файлы в контейнере кусков (codecChainChunkedXorLz и т.п., rcfs_chunked.h) при этом
+        декодируются только кусками, покрывающими читаемый диапазон; последний частично
+        прочитанный кусок хранится при дескрипторе (вне бюджета кэша декодированных данных)
+        и освобождается при закрытии файла.
+        Действует на файлы, открытые после включения.
+     */
+    void setRangeDecodeMode(bool rangeDecode) { m_rangeDecode = rangeDecode; }
+    bool getRangeDecodeMode() const { return m_rangeDecode; }
 
-    DirectoryEntry* setRootDirectory(DirectoryEntry* pRootDirectory)
+protected:
+
+    //! Вызывает handler(DecodedDataCache&) для кэша декодированных данных дерева. При MARTY_RCFS_THREAD_SAFE - под мьютексом декодирования
+    template<typename Handler>
+    void withDecodeCache(Handler handler) const
     {
-        std::swap(m_pRootDirectory, pRootDirectory);
-        return pRootDirectory;
+        checkRoot();
+
+        DirectoryEntryArena *pArena = m_pRootDirectory->getArena();
+
+        #if defined(MARTY_RCFS_THREAD_SAFE)
+        std::lock_guard<std::mutex> decodeLock(pArena->getDecodeMutex());
+        #endif
+
+        handler(pArena->getDecodeCache());
     }
 
+public:
+
+    //! Бюджет кэша декодированных данных дерева, байт. Лишнее вытесняется сразу
+    /*! Кэш общий для всех копий ФС над одним деревом. Вытесняются только файлы, которые сейчас не открыты.
+     */
+    void setDecodeCacheBudget(std::size_t budgetBytes) const
+    {
+        withDecodeCache([&](DecodedDataCache<DirectoryEntry> &cache) { cache.setBudget(budgetBytes); });
+    }
 
-    static char toLower( char ch )
+    std::size_t getDecodeCacheBudget() const
     {
-        if (ch>='A' && ch<='Z')
-            return ch-'A'+'a';
+        std::size_t budgetBytes = 0;
+        withDecodeCache([&](DecodedDataCache<DirectoryEntry> &cache) { budgetBytes = cache.getBudget(); });
+        return budgetBytes;
+    }
 
-        return ch;
+    DecodeCacheStats getDecodeCacheStats() const
+    {
+        DecodeCacheStats stats;
+        withDecodeCache([&](DecodedDataCache<DirectoryEntry> &cache) { stats = cache.getStats(); });
+        return stats;
     }
 
-    std::string normalizeNameSymbols(std::string name) const
+    //! Декодирует заранее все файлы дерева, чтобы первое открытие файла было только поиском
+    /*! Декодирование идёт в numThreads потоков (0 - по числу ядер), каждый поток декодирует
+        в свой буфер, результат устанавливается в запись под мьютексом. Файлы, которые
+        в это время декодирует открытие, повторно не декодируются. Декодер должен
+        допускать одновременные вызовы decodeFileData для разных файлов.
+        Вызывается после наполнения ФС (обычно сразу после seal()). Без MARTY_RCFS_THREAD_SAFE
+        с ФС в это время не должны работать другие потоки: свои потоки warmUp синхронизирует
+        собственным мьютексом, а состояние декодирования записей атомарное в любой сборке -
+        вытеснение по бюджету в одном потоке безопасно для остальных.
+        Декодированные данные учитываются кэшем декодированных данных - при бюджете меньше
+        объёма всех данных первые декодированные файлы будут вытеснены.
+     */
+    WarmUpStats warmUp(unsigned numThreads = 0) const
     {
-        for(auto &ch : name)
+        checkRoot();
+
+        WarmUpStats stats;
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        if (!m_pFileDecoder)
+            return stats;
+
+        DirectoryEntryArena *pArena = m_pRootDirectory->getArena();
+
+        std::vector<DirectoryEntry*> fileEntries;
+        pArena->forEachEntry([&](DirectoryEntry &entry)
+                             {
+                                 const FileEntryData *pFileData = entry.getFileData();
+                                 if (pFileData && pFileData->pConstFileData)
+                                     fileEntries.push_back(&entry);
+                             }
+                            );
+
+        stats.numFiles = fileEntries.size();
+
+        if (!numThreads)
+            numThreads = std::thread::hardware_concurrency();
+        if (!numThreads)
+            numThreads = 1;
+        if (numThreads>fileEntries.size())
+            numThreads = (unsigned)fileEntries.size();
+
+        stats.numThreads = numThreads;
+
+        std::mutex                  statsMutex;
+        DecodeSync                  sync = getDecodeSync(m_pRootDirectory);
+        #if !defined(MARTY_RCFS_THREAD_SAFE)
+        std::mutex                  commitMutex; // Синхронизируем только свои потоки
+        sync.pMutex = &commitMutex;
+        #endif
+
+        std::atomic<std::size_t>    nextEntryIdx{0};
+        std::exception_ptr          workerException;
+
+        auto worker = [&]()
         {
-            if (ch=='\\')
+            std::vector<std::uint8_t> decodedData;
+            std::size_t numDecoded = 0, bytesDecoded = 0;
+
+            try
             {
-                ch = '/';
-                continue;
+                for(std::size_t entryIdx=nextEntryIdx++; entryIdx<fileEntries.size(); entryIdx=nextEntryIdx++)
+                {
+                    // Уже декодированные и декодируемые сейчас (открытием) файлы пропускаются
+                    std::size_t decodedBytes = 0;
+                    if (decodeFileEntryDataOnce(fileEntries[entryIdx], sync, false, decodedData, &decodedBytes))
+                    {
+                        bytesDecoded += decodedBytes;
+                        ++numDecoded;
+                    }
+                }
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                if (!workerException)
+                    workerException = std::current_exception();
+                nextEntryIdx = fileEntries.size(); // Останавливаем остальные потоки
             }
 
-            if (m_caseSens)
-                continue;
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.numDecoded   += numDecoded;
+            stats.bytesDecoded += bytesDecoded;
+        };
+
+        if (numThreads<=1)
+        {
+            worker();
+        }
+        else
+        {
+            std::vector<std::thread> threads;
+            threads.reserve(numThreads);
+            for(unsigned i=0; i!=numThreads; ++i)
+                threads.emplace_back(worker);
 
-            ch = toLower(ch);
+            for(auto &thread : threads)
+                thread.join();
         }
 
+        if (workerException)
+            std::rethrow_exception(workerException);
+
+        stats.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-startTime).count();
+
+        return stats;
+    }
+
+    //! Освобождает декодированные данные не открытых файлов, пока их объём больше targetBytes (при нехватке памяти). Возвращает освобождённый объём
+    std::size_t trimDecodeCache(std::size_t targetBytes = 0) const
+    {
+        std::size_t bytesFreed = 0;
+        withDecodeCache([&](DecodedDataCache<DirectoryEntry> &cache) { bytesFreed = cache.trim(targetBytes); });
+        return bytesFreed;
+    }
+    #endif
+
+    DirectoryEntry* getRootDirectory() const { return m_pRootDirectory; }
+
+    //! Расход памяти деревом каталогов
+    DirectoryEntryMemoryStats getMemoryStats() const
+    {
+        checkRoot();
+        return m_pRootDirectory->getMemoryStats();
+    }
+
+    //! Подключает статическую таблицу ресурсов (см. rcfs_static_index.h). Сама таблица должна жить дольше ФС
+    void setStaticIndex(const StaticIndexView &staticIndex) { m_staticIndex = staticIndex; }
+    const StaticIndexView& getStaticIndex() const { return m_staticIndex; }
+
+    DirectoryEntry* setRootDirectory(DirectoryEntry* pRootDirectory)
+    {
+        std::swap(m_pRootDirectory, pRootDirectory);
+
+        #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+        if (m_pFlatIndex)
+            seal(true); // Индекс строился по старому корню - перестраиваем
+        #endif
+
+        return pRootDirectory;
+    }
+
+
+    static char toLower( char ch )
+    {
+        return asciiToLower(ch);
+    }
+
+    std::string normalizeNameSymbols(std::string name) const
+    {
+        if (!name.empty())
+            normalizePathSymbols(&name[0], name.data(), name.size(), !m_caseSens /* toLowerCase */);
+
         return name;
     }
 
@@ -370,12 +826,43 @@ public:
 
 protected:
 
-    //DirectoryEntry* findDirectoryEntry( IterType pathIter, IterType pathIterEnd, const std::string &name, bool findDirectory )
-    DirectoryEntry* findDirectoryEntry( const std::string &fullName, bool findDirectory ) const
+    //! Разбивает путь на компоненты без аллокаций и без копирования
+    /*! Регистр не нормализуется - без учёта регистра сравнивают поиск по дереву и индексы
+     */
+    bool splitPathNoAlloc(std::string_view path, PathPartsView &parts) const
     {
-        checkRoot();
+        return parts.split(path);
+    }
 
-        std::vector<std::string> pathParts = splitPath(fullName);
+    //! Поиск по компонентам пути, без аллокаций
+    DirectoryEntry* findDirectoryEntryByParts( const PathPartsView &parts, bool findDirectory ) const
+    {
+        if (parts.empty())
+            return m_pRootDirectory;
+
+        #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+        if (m_pFlatIndex)
+            return m_pFlatIndex->find(parts, findDirectory, m_caseSens);
+        #endif
+
+        DirectoryEntry *pDirEntry = m_pRootDirectory;
+
+        for(std::size_t i=0; i!=parts.size()-1; ++i)
+        {
+            pDirEntry = m_caseSens ? pDirEntry->findExactChildEntry      (parts[i], true /* findDirectory */)
+                                   : pDirEntry->findExactChildEntryNoCase(parts[i], true /* findDirectory */);
+            if (!pDirEntry)
+                return pDirEntry;
+        }
+
+        return m_caseSens ? pDirEntry->findExactChildEntry      (parts.back(), findDirectory)
+                          : pDirEntry->findExactChildEntryNoCase(parts.back(), findDirectory);
+    }
+
+    //! Старый вариант поиска, через splitPath. Используется для слишком длинных или глубоких путей
+    DirectoryEntry* findDirectoryEntrySlow( std::string_view fullName, bool findDirectory ) const
+    {
+        std::vector<std::string> pathParts = splitPath(std::string(fullName));
 
         if (pathParts.empty())
             return m_pRootDirectory;
@@ -384,19 +871,33 @@ protected:
                                                  pathItEnd   = pathParts.end  ();
         --pathItEnd;
 
-        std::string simpleFileName = *pathItEnd;
+        DirectoryEntry* pDirEntry = m_pRootDirectory->findSubDirectory(pathItBegin, pathItEnd);
+        if (!pDirEntry)
+            return pDirEntry;
 
-        return m_pRootDirectory->findDirectoryEntry( pathItBegin, pathItEnd, simpleFileName, findDirectory );
+        return pDirEntry->findExactChildEntry(*pathItEnd, findDirectory);
+    }
+
+    DirectoryEntry* findDirectoryEntry( std::string_view fullName, bool findDirectory ) const
+    {
+        checkRoot();
+
+        PathPartsView  pathParts;
+
+        if (!splitPathNoAlloc(fullName, pathParts))
+            return findDirectoryEntrySlow(fullName, findDirectory);
+
+        return findDirectoryEntryByParts(pathParts, findDirectory);
     }
 
 public:
 
-    DirectoryEntry* findDirectoryEntry(const std::string &fullName) const
+    DirectoryEntry* findDirectoryEntry(std::string_view fullName) const
     {
         return findDirectoryEntry( fullName, true /* findDirectory */);
     }
 
-    DirectoryEntry* findFileEntry(const std::string &fullName) const
+    DirectoryEntry* findFileEntry(std::string_view fullName) const
     {
         return findDirectoryEntry( fullName, false /* findDirectory */);
         // checkRoot();
@@ -425,6 +926,7 @@ public:
                     , unsigned            decryptKeySize = 0
                     , unsigned            decryptKeySeed = 0
                     , unsigned            decryptKeyInc  = 0
+                    , unsigned            codecChain     = codecChainDefault //!< Цепочка кодеков (rcfs_codec_chain.h)
                     #endif
                     ) const
     {
@@ -435,91 +937,423 @@ public:
         if (!pFileEntry)
             return false;
 
-        return pFileEntry->assignFileEntryData( pConstFileData, fileSize
-                                              #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-                                              , decryptKeySize, decryptKeySeed, decryptKeyInc
-                                              #endif
-                                              );
+        if (!pFileEntry->assignFileEntryData( pConstFileData, fileSize
+                                            #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+                                            , decryptKeySize, decryptKeySeed, decryptKeyInc, codecChain
+                                            #endif
+                                            )
+           )
+            return false;
+
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        updateDecodedSize(pFileEntry);
+        #endif
+
+        return true;
     }
 
 
-    int openFile(const std::string &fullName) const
+    //! Ищет файл в статической таблице
+    const StaticFileEntry* findStaticFileEntry(std::string_view fullName) const
     {
-        DirectoryEntry* pFileEntry = findFileEntry(fullName);
-        if (!pFileEntry) // file not found
-            return -1;
-
-        int fileId = generateFileDescriptor();
+        if (m_staticIndex.empty())
+            return 0;
 
-        m_openedFiles[fileId] = OpenedFileInfo{ pFileEntry, 0 /* pos */  };
+        PathPartsView  pathParts;
 
-        pFileEntry->lock();
+        if (!splitPathNoAlloc(fullName, pathParts))
+            return 0;
 
-        // Decode/decrypt on demand
-        // Теперь нужно декодировать файл, если нужно
-        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-        if (m_pFileDecoder && pFileEntry->m_pConstFileData && pFileEntry->m_fileDataDecrypted.empty())
-        {
-            // Установлен декодер, у файла есть установленные данные, и, возможно,
-            // декодирования ещё не производилось (pFileEntry->m_fileDataDecrypted.empty())
+        return m_staticIndex.find(pathParts, m_caseSens);
+    }
 
-            std::vector<std::uint8_t> tmpDecodedData;
+protected:
 
-            bool decodeRes = m_pFileDecoder->decodeFileData( tmpDecodedData
-                                                           , pFileEntry->m_pConstFileData
-                                                           , pFileEntry->m_fileSize
-                                                           , pFileEntry->m_decryptKeySize
-                                                           , pFileEntry->m_decryptKeySeed
-                                                           , pFileEntry->m_decryptKeyInc
-                                                           );
-            // Если декодирование было произведено
-            if (decodeRes)
-                std::swap(tmpDecodedData, pFileEntry->m_fileDataDecrypted);
+    #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+    //! Синхронизация декодирования: мьютекс состояний и кэша, условие окончания декодирования. pMutex==0 - один поток
+    struct DecodeSync
+    {
+        std::mutex                  *pMutex     = 0;
+        std::condition_variable     *pCondition = 0;
+    };
 
-        }
+    static DecodeSync getDecodeSync(DirectoryEntry *pFileEntry)
+    {
+        DecodeSync sync;
+        #if defined(MARTY_RCFS_THREAD_SAFE)
+        sync.pMutex     = &pFileEntry->getArena()->getDecodeMutex();
+        sync.pCondition = &pFileEntry->getArena()->getDecodeCondition();
+        #else
+        MARTY_ARG_USED(pFileEntry);
         #endif
-
-        return fileId;
+        return sync;
     }
 
-    bool closeFile(int iFile) const
+    //! Декодирует данные файла ровно один раз. true - декодирование выполнено этим вызовом
+    /*! Уже декодированный файл проверяется без блокировок. Файл, который сейчас
+        декодирует другой поток, не декодируется повторно: при forOpen вызов ждёт
+        окончания чужого декодирования, иначе (warmUp) сразу возвращает false.
+        Само декодирование идёт без мьютекса - разные файлы декодируются параллельно.
+        При открытии запись должна быть заблокирована вызывающим (lock), иначе
+        декодированные данные могут быть вытеснены.
+        decodedData - рабочий буфер, pDecodedBytes - размер декодированных данных.
+     */
+    bool decodeFileEntryDataOnce( DirectoryEntry *pFileEntry, const DecodeSync &sync, bool forOpen
+                                , std::vector<std::uint8_t> &decodedData, std::size_t *pDecodedBytes = 0
+                                ) const
     {
-        OpenedFileInfoMapType::iterator ofit = m_openedFiles.find(iFile);
-        if (ofit==m_openedFiles.end())
+        FileEntryData *pFileData = pFileEntry->getFileData();
+        if (!m_pFileDecoder || !pFileData || !pFileData->pConstFileData)
             return false;
 
-        if (ofit->second.pFileEntry)
-            ofit->second.pFileEntry->unlock();
+        DecodedDataCache<DirectoryEntry> &cache = pFileEntry->getArena()->getDecodeCache();
 
-        m_openedFiles.erase(ofit);
+        // Быстрый путь. Запись заблокирована до чтения состояния, поэтому Decoded уже не вытеснится
+        FileDecodeState state = decode_state_utils::load(pFileData->decodeState);
+        if (state==FileDecodeState::Decoded || state==FileDecodeState::NotRequired)
+        {
+            if (forOpen && state==FileDecodeState::Decoded)
+                cache.touch(pFileEntry);
+            return false;
+        }
 
-        return true;
-    }
+        std::unique_lock<std::mutex> lock;
+        if (sync.pMutex)
+            lock = std::unique_lock<std::mutex>(*sync.pMutex);
 
-    std::size_t getFileSize(int iFile) const
-    {
-        OpenedFileInfoMapType::const_iterator ofit = m_openedFiles.find(iFile);
-        if (ofit==m_openedFiles.end())
-            return (std::size_t)-1;
+        // Под мьютексом Evicting не виден - вытеснение идёт под ним целиком
+        for(bool waited=false; ; )
+        {
+            state = decode_state_utils::load(pFileData->decodeState);
+            if (state!=FileDecodeState::Decoding)
+                break;
 
-        if (!ofit->second.pFileEntry)
-            return (std::size_t)-1;
+            if (!forOpen || !sync.pCondition)
+                return false;
 
-        #if 0
-        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-        if (!ofit->second.pFileEntry->m_fileDataDecrypted.empty())
-            return ofit->second.pFileEntry->m_fileDataDecrypted.size();
-        #endif
+            if (!waited)
+            {
+                cache.countWait();
+                waited = true;
+            }
 
-        return ofit->second.pFileEntry->m_fileSize;
-        #endif
+            sync.pCondition->wait(lock);
+        }
 
-        return ofit->second.pFileEntry->getFileDataSize();
-    }
+        if (state==FileDecodeState::Decoded || state==FileDecodeState::NotRequired)
+        {
+            if (forOpen && state==FileDecodeState::Decoded)
+                cache.touch(pFileEntry);
+            return false;
+        }
 
-    std::size_t getFileSize(const std::string &fullName) const
-    {
-        int iFile = openFile(fullName);
+        decode_state_utils::store(pFileData->decodeState, FileDecodeState::Decoding);
+        if (lock.owns_lock())
+            lock.unlock();
+
+        bool decodeRes = false;
+
+        try
+        {
+            decodedData.clear();
+            decodeRes = m_pFileDecoder->decodeFileDataChain( decodedData
+                                                           , pFileData->pConstFileData
+                                                           , pFileData->fileSize
+                                                           , pFileData->codecChain
+                                                           , pFileData->decryptKeySize
+                                                           , pFileData->decryptKeySeed
+                                                           , pFileData->decryptKeyInc
+                                                           );
+        }
+        catch(...)
+        {
+            // Следующее открытие попробует снова
+            if (sync.pMutex)
+                lock.lock();
+            decode_state_utils::store(pFileData->decodeState, FileDecodeState::NotDecoded);
+            if (sync.pCondition)
+                sync.pCondition->notify_all();
+            throw;
+        }
+
+        if (sync.pMutex)
+            lock.lock();
+
+        if (decodeRes)
+        {
+            if (pDecodedBytes)
+                *pDecodedBytes = decodedData.size();
+
+            std::swap(decodedData, pFileData->fileDataDecrypted);
+            decode_state_utils::store(pFileData->decodeState, FileDecodeState::Decoded);
+            cache.insert(pFileEntry); // Может вытеснить другие незаблокированные файлы
+        }
+        else
+        {
+            decode_state_utils::store(pFileData->decodeState, FileDecodeState::NotRequired);
+        }
+
+        if (sync.pCondition)
+            sync.pCondition->notify_all();
+
+        return decodeRes;
+    }
+    #endif
+
+    //! Декодирует данные файла, если установлен декодер и файл ещё не декодирован. true - декодирование выполнено этим вызовом
+    /*! Запись должна быть заблокирована вызывающим (lock), иначе декодированные данные могут быть сброшены.
+     */
+    bool decodeFileEntryData(DirectoryEntry *pFileEntry) const
+    {
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        std::vector<std::uint8_t> decodedData;
+        return decodeFileEntryDataOnce(pFileEntry, getDecodeSync(pFileEntry), true, decodedData);
+        #else
+        MARTY_ARG_USED(pFileEntry);
+        return false;
+        #endif
+    }
+
+    //! Размер для декодирования файла сразу в буфер вызывающего (decodeFileEntryDataTo). (std::size_t)-1 - так читать нельзя
+    /*! Только для ещё не декодированных файлов с известным заранее размером - декодированную копию дешевле скопировать.
+     */
+    std::size_t getDirectDecodeSize(const DirectoryEntry *pFileEntry) const
+    {
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        const FileEntryData *pFileData = pFileEntry ? pFileEntry->getFileData() : 0;
+        if (!m_pFileDecoder || !pFileData || !pFileData->pConstFileData || pFileData->decodedSize==0)
+            return (std::size_t)-1;
+
+        if (decode_state_utils::load(pFileData->decodeState)!=FileDecodeState::NotDecoded)
+            return (std::size_t)-1;
+
+        return pFileData->decodedSize;
+        #else
+        MARTY_ARG_USED(pFileEntry);
+        return (std::size_t)-1;
+        #endif
+    }
+
+    //! Декодирует данные файла сразу в pDst (IFileDecoder::decodeFileDataTo), минуя кэш декодированных данных
+    /*! dstSize - getDirectDecodeSize. Если декодирование не требуется - копирует данные как есть.
+        false - pDst не заполнен (файл тем временем декодирован или размер не совпал), читать обычным путём.
+        pDecoded - выполнено ли декодирование.
+     */
+    bool decodeFileEntryDataTo(DirectoryEntry *pFileEntry, std::uint8_t *pDst, std::size_t dstSize, bool *pDecoded = 0) const
+    {
+        if (pDecoded)
+            *pDecoded = false;
+
+        if (dstSize==(std::size_t)-1 || getDirectDecodeSize(pFileEntry)!=dstSize)
+            return false;
+
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        FileEntryData *pFileData = pFileEntry->getFileData();
+
+        // Исходные данные не меняются после запечатывания - блокировка записи не нужна
+        if (m_pFileDecoder->decodeFileDataTo( pDst, dstSize
+                                            , pFileData->pConstFileData
+                                            , pFileData->fileSize
+                                            , pFileData->codecChain
+                                            , pFileData->decryptKeySize
+                                            , pFileData->decryptKeySeed
+                                            , pFileData->decryptKeyInc
+                                            ))
+        {
+            if (pDecoded)
+                *pDecoded = true;
+            return true;
+        }
+
+        // Не требуется - запоминаем, как это сделало бы открытие
+        decode_state_utils::compareExchange(pFileData->decodeState, FileDecodeState::NotDecoded, FileDecodeState::NotRequired);
+
+        if (pFileData->fileSize!=dstSize)
+            return false;
+
+        std::memcpy(pDst, pFileData->pConstFileData, dstSize);
+        return true;
+        #else
+        MARTY_ARG_USED(pDst);
+        return false;
+        #endif
+    }
+
+    //! Режим копирования readBatch: ещё не декодированный файл декодируется сразу в буфер пакета
+    bool readBatchItemDirect(DirectoryEntry *pFileEntry, std::vector<std::uint8_t> &data, BatchReadStats &stats) const
+    {
+        const std::size_t dataSize = getDirectDecodeSize(pFileEntry);
+        if (dataSize==(std::size_t)-1)
+            return false;
+
+        data.resize(dataSize);
+
+        bool decoded = false;
+        if (!decodeFileEntryDataTo(pFileEntry, data.data(), dataSize, &decoded))
+            return false;
+
+        ++stats.numFound;
+        ++stats.numCopied;
+        if (decoded)
+            ++stats.numDecoded;
+        stats.bytesFound  += dataSize;
+        stats.bytesCopied += dataSize;
+
+        return true;
+    }
+
+    #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+    //! Запоминает в записи размер декодированных данных, если декодер сообщает его заранее
+    void updateDecodedSize(DirectoryEntry *pFileEntry) const
+    {
+        FileEntryData *pFileData = pFileEntry->getFileData();
+        if (!pFileData)
+            return;
+
+        pFileData->decodedSize = (std::size_t)-1;
+
+        // Новый декодер может счесть декодирование нужным
+        decode_state_utils::compareExchange(pFileData->decodeState, FileDecodeState::NotRequired, FileDecodeState::NotDecoded);
+
+        if (m_pFileDecoder && pFileData->pConstFileData)
+            pFileData->decodedSize = m_pFileDecoder->getDecodedSizeChain( pFileData->pConstFileData
+                                                                        , pFileData->fileSize
+                                                                        , pFileData->codecChain
+                                                                        , pFileData->decryptKeySize
+                                                                        , pFileData->decryptKeySeed
+                                                                        , pFileData->decryptKeyInc
+                                                                        );
+    }
+
+    //! Декодер диапазонов для файла, если включён режим декодирования диапазонов и декодер может декодировать этот файл по частям
+    const IRangeFileDecoder* getFileRangeDecoder(const DirectoryEntry *pFileEntry) const
+    {
+        if (!m_rangeDecode || !m_pFileDecoder)
+            return 0;
+
+        const FileEntryData *pFileData = pFileEntry->getFileData();
+        if (!pFileData || !pFileData->pConstFileData)
+            return 0;
+
+        // Размер файла при чтении диапазонов - размер декодированных данных, он должен быть известен без декодирования
+        if (pFileData->decodedSize==(std::size_t)-1)
+            return 0;
+
+        const IRangeFileDecoder *pRangeDecoder = m_pFileDecoder->getRangeDecoder();
+        if (!pRangeDecoder || !pRangeDecoder->canDecodeRangeChain(pFileData->codecChain, pFileData->decryptKeySize, pFileData->decryptKeySeed, pFileData->decryptKeyInc))
+            return 0;
+
+        return pRangeDecoder;
+    }
+    #endif
+
+public:
+
+    //! Разрешает путь в идентификатор ресурса. Недействительный идентификатор - файл не найден
+    ResourceId resolve(std::string_view fullName) const
+    {
+        const StaticFileEntry *pStaticEntry = findStaticFileEntry(fullName);
+        if (pStaticEntry)
+            return ResourceId(0, pStaticEntry);
+
+        return ResourceId(findFileEntry(fullName), 0);
+    }
+
+    int openFile(std::string_view fullName) const
+    {
+        return openFile(resolve(fullName));
+    }
+
+    int openFile(const ResourceId &resourceId) const
+    {
+        if (resourceId.pStaticEntry)
+        {
+            OpenedFileInfo fileInfo;
+            fileInfo.pStaticEntry = resourceId.pStaticEntry;
+            return m_openedFiles.allocate(fileInfo);
+        }
+
+        DirectoryEntry* pFileEntry = resourceId.pFileEntry;
+        if (!pFileEntry) // file not found
+            return -1;
+
+        OpenedFileInfo fileInfo;
+        fileInfo.pFileEntry    = pFileEntry;
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        fileInfo.pRangeDecoder = getFileRangeDecoder(pFileEntry);
+        if (fileInfo.pRangeDecoder)
+            fileInfo.pRangeState.reset(fileInfo.pRangeDecoder->createRangeDecodeState(pFileEntry->getFileData()->codecChain));
+        #endif
+
+        int fileId = m_openedFiles.allocate(fileInfo);
+        if (fileId<0) // Кончились дескрипторы
+            return -1;
+
+        pFileEntry->lock();
+
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        if (fileInfo.pRangeDecoder)
+            return fileId; // Декодирование - при чтении, по диапазонам
+        #endif
+
+        // Decode/decrypt on demand
+        // Теперь нужно декодировать файл, если нужно
+        decodeFileEntryData(pFileEntry);
+
+        return fileId;
+    }
+
+    bool closeFile(int iFile) const
+    {
+        OpenedFileInfo releasedInfo;
+        if (!m_openedFiles.release(iFile, &releasedInfo))
+            return false;
+
+        if (releasedInfo.pFileEntry)
+            releasedInfo.pFileEntry->unlock();
+
+        return true;
+    }
+
+    std::size_t getFileSize(int iFile) const
+    {
+        const OpenedFileInfo *pInfo = m_openedFiles.find(iFile);
+        if (!pInfo)
+            return (std::size_t)-1;
+
+        if (pInfo->pStaticEntry)
+            return pInfo->pStaticEntry->size;
+
+        if (!pInfo->pFileEntry)
+            return (std::size_t)-1;
+
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        if (pInfo->pRangeDecoder)
+            return pInfo->pFileEntry->getFileData()->decodedSize; // Известен при открытии (см. getFileRangeDecoder)
+        #endif
+
+        return pInfo->pFileEntry->getFileDataSize();
+    }
+
+    std::size_t getFileSize(std::string_view fullName) const
+    {
+        return getFileSize(resolve(fullName));
+    }
+
+    //! Размер по метаданным - без открытия и декодирования
+    /*! Декодирует, только если декодер не сообщает размер декодированных данных заранее.
+     */
+    std::size_t getFileSize(const ResourceId &resourceId) const
+    {
+        FileStat fileStat;
+        if (!statFile(resourceId, fileStat))
+            return (std::size_t)-1;
+
+        if (fileStat.size!=(std::size_t)-1)
+            return fileStat.size;
+
+        // Размер известен только после декодирования
+        int iFile = openFile(resourceId);
         if (iFile<0)
             return (std::size_t)-1;
 
@@ -530,88 +1364,289 @@ public:
         return fileSize;
     }
 
+    //! Сведения о файле только по метаданным - без открытия и декодирования. false - файл не найден
+    bool statFile(const ResourceId &resourceId, FileStat &fileStat) const
+    {
+        fileStat = FileStat();
+
+        if (resourceId.pStaticEntry)
+        {
+            fileStat.size        = resourceId.pStaticEntry->size;
+            fileStat.storedSize  = resourceId.pStaticEntry->size;
+            fileStat.staticEntry = true;
+            return true;
+        }
+
+        const FileEntryData *pFileData = resourceId.pFileEntry ? resourceId.pFileEntry->getFileData() : 0;
+        if (!pFileData)
+            return false;
+
+        if (!pFileData->pConstFileData || !pFileData->fileSize)
+            return true; // Данные не установлены - пустой файл
+
+        fileStat.size       = pFileData->fileSize;
+        fileStat.storedSize = pFileData->fileSize;
+
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        fileStat.encoded = pFileData->decryptKeySize!=0 || pFileData->codecChain!=codecChainDefault;
+
+        if (m_pFileDecoder)
+            fileStat.size = pFileData->decodedSize; // Сообщён декодером при регистрации (или установке декодера)
+        #endif
+
+        return true;
+    }
+
+    bool statFile(std::string_view fullName, FileStat &fileStat) const
+    {
+        return statFile(resolve(fullName), fileStat);
+    }
+
 
 protected:
 
-    const std::uint8_t* getOpenedFileReadParams(int iFile, std::size_t &fileSize, std::size_t &curPos) const
+    //! Данные и размер открытого файла. Позицию чтения не трогает - для pread*, которые идут параллельно с readFile/seekFile
+    const std::uint8_t* getOpenedFileDataParams(int iFile, std::size_t &fileSize, OpenedFileInfo **ppInfo = 0) const
     {
-        OpenedFileInfoMapType::iterator ofit = m_openedFiles.find(iFile);
-        if (ofit==m_openedFiles.end())
+        OpenedFileInfo *pInfo = m_openedFiles.find(iFile);
+        if (!pInfo)
             return 0;
 
-        if (!ofit->second.pFileEntry)
+        if (ppInfo)
+            *ppInfo = pInfo;
+
+        if (pInfo->pStaticEntry)
+        {
+            fileSize = pInfo->pStaticEntry->size;
+            return pInfo->pStaticEntry->getFileDataPtr();
+        }
+
+        if (!pInfo->pFileEntry)
         {
             fileSize = 0;
-            curPos   = 0;
             return 0;
         }
 
-        curPos = ofit->second.readPos;
-
-        #if 0
         #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
-        if (!ofit->second.pFileEntry->m_fileDataDecrypted.empty())
+        if (pInfo->pRangeDecoder)
         {
-            fileSize = ofit->second.pFileEntry->m_fileDataDecrypted.size();
-            return ofit->second.pFileEntry->m_fileDataDecrypted.data();
+            // Исходные (закодированные) данные - декодирует copyFileData; размер и позиции - в декодированных данных
+            const FileEntryData *pFileData = pInfo->pFileEntry->getFileData();
+            fileSize = pFileData->decodedSize;
+            return pFileData->pConstFileData;
         }
         #endif
 
-        fileSize = ofit->second.pFileEntry->m_fileSize;
-        return m_pConstFileData;
+        fileSize = pInfo->pFileEntry->getFileDataSize();
+
+        return pInfo->pFileEntry->getFileDataPtr();
+    }
+
+    //! Данные, размер и текущая позиция открытого файла - для операций, которые читают/сдвигают позицию
+    const std::uint8_t* getOpenedFileReadParams(int iFile, std::size_t &fileSize, std::size_t &curPos, OpenedFileInfo **ppInfo = 0) const
+    {
+        OpenedFileInfo *pInfo = 0;
+        const std::uint8_t* pFileData = getOpenedFileDataParams(iFile, fileSize, &pInfo);
+
+        curPos = pInfo ? pInfo->readPos : 0;
+
+        if (ppInfo)
+            *ppInfo = pInfo;
+
+        return pFileData;
+    }
+
+    //! Копирует nBytes данных открытого файла с позиции pos. В режиме декодирования диапазонов - декодирует их
+    bool copyFileData(const OpenedFileInfo *pInfo, std::uint8_t *pDst, const std::uint8_t *pFileData, std::size_t fileSize, std::size_t pos, std::size_t nBytes) const
+    {
+        MARTY_ARG_USED(fileSize);
+
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        if (pInfo->pRangeDecoder)
+        {
+            // fileSize здесь - декодированный размер, декодеру нужен размер закодированных данных
+            const FileEntryData *pEntryData = pInfo->pFileEntry->getFileData();
+            return pInfo->pRangeDecoder->decodeFileDataRangeState( pInfo->pRangeState.get()
+                                                                 , pDst, pFileData, pEntryData->fileSize
+                                                                 , pEntryData->codecChain, pos, nBytes
+                                                                 , pEntryData->decryptKeySize
+                                                                 , pEntryData->decryptKeySeed
+                                                                 , pEntryData->decryptKeyInc
+                                                                 );
+        }
+        #else
+        MARTY_ARG_USED(pInfo);
         #endif
 
-        fileSize = ofit->second.pFileEntry->getFileDataSize();
+        std::memcpy(pDst, pFileData+pos, nBytes);
+        return true;
+    }
+
+    //! Сколько байт можно прочитать с позиции readPos. 0 - конец файла (или позиция за концом)
+    static std::size_t getReadableBytes(std::size_t fileSize, std::size_t readPos, std::size_t nBytesToRead)
+    {
+        if (readPos>=fileSize)
+            return 0;
+
+        return std::min(nBytesToRead, fileSize-readPos);
+    }
+
+    //! Копирует данные с позиции pos по буферам, возвращает число скопированных байт
+    std::size_t preadvImpl(const OpenedFileInfo *pInfo, const std::uint8_t *pFileData, std::size_t fileSize, std::size_t pos, const ReadIoVec *pIoVecs, std::size_t numIoVecs) const
+    {
+        std::size_t totalBytes = 0;
+
+        for(std::size_t i=0; i!=numIoVecs; ++i)
+        {
+            std::size_t nBytes = getReadableBytes(fileSize, pos, pIoVecs[i].size);
+            if (!nBytes)
+            {
+                if (pos>=fileSize)
+                    break;
+                continue; // Пустой буфер
+            }
+
+            if (!copyFileData(pInfo, (std::uint8_t*)pIoVecs[i].pData, pFileData, fileSize, pos, nBytes))
+                break;
 
-        return ofit->second.pFileEntry->getFileDataPtr();
+            pos        += nBytes;
+            totalBytes += nBytes;
+        }
+
+        return totalBytes;
     }
 
+    //! Читает с текущей позиции и сдвигает её. Ёмкость buf переиспользуется; если append - данные дописываются в конец
     template<typename ContainerType>
-    bool readFileToContainerImpl(int iFile, ContainerType &buf, std::size_t nBytesToRead) const
+    bool readFileToContainerImpl(int iFile, ContainerType &buf, std::size_t nBytesToRead, bool append = false) const
     {
         std::size_t fileSize=0, readPos=0;
-        const std::uint8_t* pFileData = getOpenedFileReadParams(iFile, fileSize, readPos);
+        OpenedFileInfo *pInfo = 0;
+        const std::uint8_t* pFileData = getOpenedFileReadParams(iFile, fileSize, readPos, &pInfo);
 
         if (!pFileData)
             return false;
 
-        std::size_t requestedReadEnd = readPos + nBytesToRead;
-        std::size_t readEnd = std::min(requestedReadEnd, fileSize);
-
-        if (readPos>=readEnd)
+        std::size_t actualBytesToRead = getReadableBytes(fileSize, readPos, nBytesToRead);
+        if (!actualBytesToRead)
             return false;
 
-        std::size_t actualBytesToRead = readEnd - readPos;
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        if (pInfo->pRangeDecoder)
+        {
+            // Декодируем прямо в buf
+            const std::size_t oldSize = append ? buf.size() : 0;
+            buf.resize(oldSize+actualBytesToRead);
+            if (!copyFileData(pInfo, (std::uint8_t*)&buf[oldSize], pFileData, fileSize, readPos, actualBytesToRead))
+            {
+                buf.resize(oldSize);
+                return false;
+            }
+
+            pInfo->readPos = readPos + actualBytesToRead;
+            return true;
+        }
+        #endif
 
-        typename ContainerType::value_type *pStart = (typename ContainerType::value_type*)(pFileData+readPos);
-        typename ContainerType::value_type *pEnd   = (typename ContainerType::value_type*)(pStart+actualBytesToRead);
+        const typename ContainerType::value_type *pStart = (const typename ContainerType::value_type*)(pFileData+readPos);
+        const typename ContainerType::value_type *pEnd   = pStart+actualBytesToRead;
 
-        auto tmp = ContainerType(pStart, pEnd);
-        std::swap(buf, tmp);
+        // assign/insert не выделяют память, если ёмкости buf хватает
+        if (append)
+            buf.insert(buf.end(), pStart, pEnd);
+        else
+            buf.assign(pStart, pEnd);
+
+        pInfo->readPos = readPos + actualBytesToRead;
 
         return true;
     }
 
+    //! Открывает, читает целиком и закрывает
+    template<typename ContainerType>
+    bool readResourceToContainerImpl(const ResourceId &resourceId, ContainerType &buf) const
+    {
+        int iFile = openFile(resourceId);
+        if (iFile<0)
+            return false;
+
+        bool res = readFileToContainerImpl(iFile, buf, getFileSize(iFile));
+
+        closeFile(iFile);
+
+        return res;
+    }
+
 
 public:
 
+    //! Данные открытого файла без копирования. Действительны, пока файл не закрыт
+    /*! Пустое - неверный дескриптор, нет данных, или файл открыт в режиме декодирования
+        диапазонов (декодированной копии целиком нет).
+     */
+    FileView getFileView(int iFile) const
+    {
+        std::size_t fileSize=0;
+        OpenedFileInfo *pInfo = 0;
+        const std::uint8_t* pFileData = getOpenedFileDataParams(iFile, fileSize, &pInfo);
+
+        if (!pFileData)
+            return FileView();
+
+        #if !defined(MARTY_RCFS_DISABLE_DECRYPT)
+        if (pInfo->pRangeDecoder)
+            return FileView();
+        #endif
+
+        return FileView(pFileData, fileSize);
+    }
+
+    //! Читает с текущей позиции и сдвигает её. false - ошибка или конец файла
     bool readFile(int iFile, std::uint8_t *pBuf, std::size_t nBytesToRead, std::size_t *pBytesReaded) const
     {
         std::size_t fileSize=0, readPos=0;
-        const std::uint8_t* pFileData = getOpenedFileReadParams(iFile, fileSize, readPos);
+        OpenedFileInfo *pInfo = 0;
+        const std::uint8_t* pFileData = getOpenedFileReadParams(iFile, fileSize, readPos, &pInfo);
 
         if (!pFileData)
             return false;
 
-        std::size_t requestedReadEnd = readPos + nBytesToRead;
-        std::size_t readEnd = std::min(requestedReadEnd, fileSize);
+        std::size_t actualBytesToRead = getReadableBytes(fileSize, readPos, nBytesToRead);
+        if (!actualBytesToRead)
+            return false;
+
+        if (!copyFileData(pInfo, pBuf, pFileData, fileSize, readPos, actualBytesToRead))
+            return false;
+
+        pInfo->readPos = readPos + actualBytesToRead;
+
+        if (pBytesReaded)
+           *pBytesReaded = actualBytesToRead;
+
+        return true;
+    }
+
+    //! Читает с заданной позиции, текущую позицию не трогает
+    /*! Можно вызывать одновременно из разных потоков для одного дескриптора,
+        в том числе параллельно с readFile/seekFile - позицию чтения pread не читает.
+        Сами readFile/seekFile/tellFile для одного дескриптора из разных потоков
+        нужно упорядочивать снаружи, как и для обычного файла.
+     */
+    bool preadFile(int iFile, std::size_t offset, std::uint8_t *pBuf, std::size_t nBytesToRead, std::size_t *pBytesReaded) const
+    {
+        std::size_t fileSize=0;
+        OpenedFileInfo *pInfo = 0;
+        const std::uint8_t* pFileData = getOpenedFileDataParams(iFile, fileSize, &pInfo);
 
-        if (readPos>=readEnd)
+        if (!pFileData)
             return false;
 
-        std::size_t actualBytesToRead = readEnd - readPos;
+        std::size_t actualBytesToRead = getReadableBytes(fileSize, offset, nBytesToRead);
+        if (!actualBytesToRead)
+            return false;
 
-        std::memcpy( (void*)pBuf, (const void*)&pFileData[readPos], actualBytesToRead );
+        if (!copyFileData(pInfo, pBuf, pFileData, fileSize, offset, actualBytesToRead))
+            return false;
 
         if (pBytesReaded)
            *pBytesReaded = actualBytesToRead;
@@ -619,6 +1654,80 @@ public:
         return true;
     }
 
+    //! Читает вразброс в несколько буферов, заполняя их по порядку, с текущей позиции и сдвигает её
+    bool readvFile(int iFile, const ReadIoVec *pIoVecs, std::size_t numIoVecs, std::size_t *pBytesReaded) const
+    {
+        std::size_t fileSize=0, readPos=0;
+        OpenedFileInfo *pInfo = 0;
+        const std::uint8_t* pFileData = getOpenedFileReadParams(iFile, fileSize, readPos, &pInfo);
+
+        if (!pFileData)
+            return false;
+
+        std::size_t totalBytesReaded = preadvImpl(pInfo, pFileData, fileSize, readPos, pIoVecs, numIoVecs);
+        if (!totalBytesReaded)
+            return false;
+
+        pInfo->readPos = readPos + totalBytesReaded;
+
+        if (pBytesReaded)
+           *pBytesReaded = totalBytesReaded;
+
+        return true;
+    }
+
+    //! Читает вразброс с заданной позиции, текущую позицию не трогает. Параллельные вызовы - как у preadFile
+    bool preadvFile(int iFile, std::size_t offset, const ReadIoVec *pIoVecs, std::size_t numIoVecs, std::size_t *pBytesReaded) const
+    {
+        std::size_t fileSize=0;
+        OpenedFileInfo *pInfo = 0;
+        const std::uint8_t* pFileData = getOpenedFileDataParams(iFile, fileSize, &pInfo);
+
+        if (!pFileData)
+            return false;
+
+        std::size_t totalBytesReaded = preadvImpl(pInfo, pFileData, fileSize, offset, pIoVecs, numIoVecs);
+        if (!totalBytesReaded)
+            return false;
+
+        if (pBytesReaded)
+           *pBytesReaded = totalBytesReaded;
+
+        return true;
+    }
+
+    //! Устанавливает позицию чтения. За конец файла - нельзя
+    bool seekFile(int iFile, std::ptrdiff_t offset, SeekOrigin origin = SeekOrigin::Begin) const
+    {
+        std::size_t fileSize=0, readPos=0;
+        OpenedFileInfo *pInfo = 0;
+        getOpenedFileReadParams(iFile, fileSize, readPos, &pInfo); // Для файла без данных fileSize==0
+
+        if (!pInfo)
+            return false;
+
+        std::size_t basePos = origin==SeekOrigin::Begin   ? 0
+                            : origin==SeekOrigin::Current ? readPos
+                                                          : fileSize;
+
+        if (offset<0 ? (std::size_t)0-(std::size_t)offset>basePos : (std::size_t)offset>fileSize-basePos)
+            return false;
+
+        pInfo->readPos = basePos + (std::size_t)offset;
+
+        return true;
+    }
+
+    //! Текущая позиция чтения, (std::size_t)-1 - неверный дескриптор
+    std::size_t tellFile(int iFile) const
+    {
+        const OpenedFileInfo *pInfo = m_openedFiles.find(iFile);
+        if (!pInfo)
+            return (std::size_t)-1;
+
+        return pInfo->readPos;
+    }
+
 
 public:
 
@@ -654,6 +1763,323 @@ public:
     }
 
 
+    // Дописывают прочитанное в конец buf
+
+    bool readFileAppend(int iFile, std::vector<std::uint8_t> &buf, std::size_t nBytesToRead) const
+    {
+        return readFileToContainerImpl(iFile, buf, nBytesToRead, true /* append */);
+    }
+
+    bool readFileAppend(int iFile, std::vector<char> &buf, std::size_t nBytesToRead) const
+    {
+        return readFileToContainerImpl(iFile, buf, nBytesToRead, true /* append */);
+    }
+
+    bool readFileAppend(int iFile, std::string &buf, std::size_t nBytesToRead) const
+    {
+        return readFileToContainerImpl(iFile, buf, nBytesToRead, true /* append */);
+    }
+
+
+    // Чтение целиком по идентификатору ресурса - без открытого дескриптора у вызывающего
+
+    bool readFile(const ResourceId &resourceId, std::vector<std::uint8_t> &buf) const
+    {
+        return readResourceToContainerImpl(resourceId, buf);
+    }
+
+    bool readFile(const ResourceId &resourceId, std::vector<char> &buf) const
+    {
+        return readResourceToContainerImpl(resourceId, buf);
+    }
+
+    bool readFile(const ResourceId &resourceId, std::string &buf) const
+    {
+        return readResourceToContainerImpl(resourceId, buf);
+    }
+
+    //! Читает файл целиком в буфер вызывающего (пул, арену, буфер чтения). bufSize - не меньше getFileSize
+    /*! Если декодированной копии файла нет, а размер известен заранее, данные декодируются
+        сразу в pBuf (IFileDecoder::decodeFileDataTo), кэш декодированных данных не заполняется.
+        Иначе - обычное чтение через открытие файла.
+     */
+    bool readFileTo(const ResourceId &resourceId, std::uint8_t *pBuf, std::size_t bufSize, std::size_t *pBytesReaded = 0) const
+    {
+        if (pBytesReaded)
+           *pBytesReaded = 0;
+
+        if (resourceId.pStaticEntry)
+        {
+            const std::size_t fileSize = resourceId.pStaticEntry->size;
+            if (fileSize>bufSize)
+                return false;
+
+            if (fileSize)
+                std::memcpy(pBuf, resourceId.pStaticEntry->getFileDataPtr(), fileSize);
+
+            if (pBytesReaded)
+               *pBytesReaded = fileSize;
+            return true;
+        }
+
+        DirectoryEntry *pFileEntry = resourceId.pFileEntry;
+        if (!pFileEntry)
+            return false;
+
+        // Заведомо малый буфер - без открытия и декодирования
+        FileStat fileStat;
+        if (!statFile(resourceId, fileStat) || (fileStat.size!=(std::size_t)-1 && fileStat.size>bufSize))
+            return false;
+
+        const std::size_t directSize = getDirectDecodeSize(pFileEntry);
+        if (directSize!=(std::size_t)-1 && decodeFileEntryDataTo(pFileEntry, pBuf, directSize))
+        {
+            if (pBytesReaded)
+               *pBytesReaded = directSize;
+            return true;
+        }
+
+        int iFile = openFile(resourceId);
+        if (iFile<0)
+            return false;
+
+        const std::size_t fileSize = getFileSize(iFile);
+
+        bool res = fileSize<=bufSize;
+        if (res && fileSize)
+            res = readFile(iFile, pBuf, fileSize, pBytesReaded);
+
+        closeFile(iFile);
+
+        return res;
+    }
+
+
+protected:
+
+    //! Поиск непосредственного потомка с учётом m_caseSens
+    DirectoryEntry* findChildEntry(const DirectoryEntry *pDirEntry, std::string_view name, bool findDirectory) const
+    {
+        return m_caseSens ? pDirEntry->findExactChildEntry      (name, findDirectory)
+                          : pDirEntry->findExactChildEntryNoCase(name, findDirectory);
+    }
+
+    //! Разрешает пути за один проход по отсортированному списку
+    /*! Соседние пути после сортировки обычно имеют общий префикс каталогов -
+        уже найденные каталоги префикса повторно не ищутся.
+     */
+    std::size_t resolveBatchImpl(const std::string_view *pPaths, std::size_t numPaths, ResourceId *pIds, std::vector<std::uint32_t> &order) const
+    {
+        checkRoot();
+
+        order.resize(numPaths);
+        for(std::size_t i=0; i!=numPaths; ++i)
+            order[i] = (std::uint32_t)i;
+
+        std::sort(order.begin(), order.end(), [&](std::uint32_t i1, std::uint32_t i2) { return pPaths[i1]<pPaths[i2]; });
+
+        PathPartsView    parts[2];
+        DirectoryEntry  *dirStack[MARTY_RCFS_MAX_PATH_DEPTH]; // dirStack[i] - каталог для компонентов [0, i] предыдущего пути
+        std::size_t      dirStackSize = 0;
+        std::size_t      numFound     = 0;
+
+        for(std::size_t k=0; k!=numPaths; ++k)
+        {
+            const std::uint32_t  idx  = order[k];
+            const std::string_view path = pPaths[idx];
+
+            PathPartsView &curParts  = parts[k&1];
+            PathPartsView &prevParts = parts[(k+1)&1];
+
+            pIds[idx] = ResourceId();
+
+            const StaticFileEntry *pStaticEntry = findStaticFileEntry(path);
+            if (pStaticEntry)
+            {
+                pIds[idx] = ResourceId(0, pStaticEntry);
+                ++numFound;
+                dirStackSize = 0;
+                continue;
+            }
+
+            if (!splitPathNoAlloc(path, curParts))
+            {
+                pIds[idx] = ResourceId(findDirectoryEntrySlow(path, false /* findDirectory */), 0);
+                numFound += pIds[idx].valid() ? 1 : 0;
+                dirStackSize = 0;
+                continue;
+            }
+
+            if (curParts.empty())
+            {
+                dirStackSize = 0;
+                continue;
+            }
+
+            #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+            if (m_pFlatIndex)
+            {
+                pIds[idx] = ResourceId(m_pFlatIndex->find(curParts, false /* findDirectory */, m_caseSens), 0);
+                numFound += pIds[idx].valid() ? 1 : 0;
+                continue;
+            }
+            #endif
+
+            // Общий с предыдущим путём префикс каталогов
+            const std::size_t numDirs = curParts.size()-1;
+            std::size_t commonDirs = 0;
+            while(commonDirs<numDirs && commonDirs<dirStackSize && curParts[commonDirs]==prevParts[commonDirs])
+                ++commonDirs;
+
+            dirStackSize = commonDirs;
+
+            DirectoryEntry *pDirEntry = commonDirs ? dirStack[commonDirs-1] : m_pRootDirectory;
+            for(; dirStackSize<numDirs; ++dirStackSize)
+            {
+                pDirEntry = findChildEntry(pDirEntry, curParts[dirStackSize], true /* findDirectory */);
+                if (!pDirEntry)
+                    break;
+                dirStack[dirStackSize] = pDirEntry;
+            }
+
+            if (!pDirEntry)
+                continue;
+
+            pIds[idx] = ResourceId(findChildEntry(pDirEntry, curParts.back(), false /* findDirectory */), 0);
+            numFound += pIds[idx].valid() ? 1 : 0;
+        }
+
+        return numFound;
+    }
+
+    //! Блокирует и при необходимости декодирует файл. Возвращает представление его данных
+    FileView pinResource(const ResourceId &resourceId, BatchReadStats &stats) const
+    {
+        if (resourceId.pStaticEntry)
+        {
+            ++stats.numFound;
+            stats.bytesFound += resourceId.pStaticEntry->size;
+            return FileView(resourceId.pStaticEntry->getFileDataPtr(), resourceId.pStaticEntry->size);
+        }
+
+        DirectoryEntry *pFileEntry = resourceId.pFileEntry;
+        if (!pFileEntry)
+            return FileView();
+
+        pFileEntry->lock();
+
+        if (decodeFileEntryData(pFileEntry))
+            ++stats.numDecoded;
+
+        ++stats.numFound;
+        stats.bytesFound += pFileEntry->getFileDataSize();
+
+        return FileView(pFileEntry->getFileDataPtr(), pFileEntry->getFileDataSize());
+    }
+
+
+public:
+
+    //! Разрешает пачку путей в идентификаторы за один отсортированный проход. Возвращает число найденных
+    std::size_t resolveBatch(const std::string_view *pPaths, std::size_t numPaths, ResourceId *pIds) const
+    {
+        std::vector<std::uint32_t> order;
+        return resolveBatchImpl(pPaths, numPaths, pIds, order);
+    }
+
+    //! Пакетное чтение по идентификаторам. Декодирует то, что требует декодирования
+    /*! Без копирования (copyData==false) представления указывают прямо на данные файлов,
+        файлы заблокированы до освобождения пакета. С копированием данные копируются
+        в буферы пакета (их ёмкость переиспользуется), и файлы сразу разблокируются;
+        ещё не декодированные файлы с известным заранее размером декодируются сразу
+        в буферы пакета, кэш декодированных данных при этом не заполняется.
+        Возвращает true, если найдены все файлы.
+     */
+    bool readBatch(const ResourceId *pIds, std::size_t numIds, ResourceBatch &batch, bool copyData = false) const
+    {
+        batch.release();
+        batch.m_items.resize(numIds);
+        batch.m_stats = BatchReadStats();
+        batch.m_stats.numRequested = numIds;
+
+        for(std::size_t i=0; i!=numIds; ++i)
+        {
+            ResourceBatch::Item &item = batch.m_items[i];
+            item.id = pIds[i];
+
+            DirectoryEntry *pFileEntry = pIds[i].pFileEntry;
+
+            // Ещё не декодированный файл - сразу в буфер пакета, без декодированной копии в дереве
+            if (copyData && readBatchItemDirect(pFileEntry, item.data, batch.m_stats))
+            {
+                item.view = FileView(item.data.data(), item.data.size());
+                continue;
+            }
+
+            item.view = pinResource(pIds[i], batch.m_stats);
+
+            if (copyData)
+            {
+                item.data.assign(item.view.begin(), item.view.end());
+                item.view = FileView(item.data.data(), item.data.size());
+                if (pIds[i].valid())
+                {
+                    ++batch.m_stats.numCopied;
+                    batch.m_stats.bytesCopied += item.data.size();
+                }
+
+                if (pFileEntry)
+                    pFileEntry->unlock();
+            }
+            else
+            {
+                item.data.clear();
+                if (pFileEntry)
+                    batch.m_lockedEntries.push_back(pFileEntry);
+            }
+        }
+
+        return batch.m_stats.numFound==numIds;
+    }
+
+    //! Пакетное чтение по путям - пути разрешаются за один отсортированный проход, затем readBatch по идентификаторам
+    bool readBatch(const std::string_view *pPaths, std::size_t numPaths, ResourceBatch &batch, bool copyData = false) const
+    {
+        std::vector<ResourceId> ids(numPaths);
+        resolveBatchImpl(pPaths, numPaths, ids.data(), batch.m_order);
+        return readBatch(ids.data(), numPaths, batch, copyData);
+    }
+
+    //! Пакетная обработка без копирования: handler(std::size_t idx, const FileView &view) вызывается для каждого найденного файла
+    /*! Файл заблокирован только на время вызова обработчика.
+     */
+    template<typename Handler>
+    BatchReadStats visitBatch(const std::string_view *pPaths, std::size_t numPaths, Handler handler) const
+    {
+        BatchReadStats stats;
+        stats.numRequested = numPaths;
+
+        std::vector<ResourceId>    ids(numPaths);
+        std::vector<std::uint32_t> order;
+        resolveBatchImpl(pPaths, numPaths, ids.data(), order);
+
+        // В порядке обхода дерева - соседние файлы лежат рядом
+        for(std::uint32_t idx : order)
+        {
+            if (!ids[idx].valid())
+                continue;
+
+            FileView view = pinResource(ids[idx], stats);
+            handler((std::size_t)idx, view);
+
+            if (ids[idx].pFileEntry)
+                ids[idx].pFileEntry->unlock();
+        }
+
+        return stats;
+    }
+
+
 }; // class ResourceFileSystem
 
 //----------------------------------------------------------------------------
@@ -663,7 +2089,7 @@ public:
 
 //----------------------------------------------------------------------------
 inline
-bool AutoFileHandle::open (const std::string &fullName)
+bool AutoFileHandle::open (std::string_view fullName)
 {
     MARTY_RCFS_ASSERT(pRcfs);
 
@@ -680,6 +2106,25 @@ bool AutoFileHandle::open (const std::string &fullName)
     return true;
 }
 
+//----------------------------------------------------------------------------
+inline
+bool AutoFileHandle::open (const ResourceId &resourceId)
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+
+    close();
+
+    int handle = pRcfs->openFile(resourceId);
+    if (handle<0)
+    {
+        return false;
+    }
+
+    fileId = handle;
+
+    return true;
+}
+
 //----------------------------------------------------------------------------
 inline
 bool AutoFileHandle::close()
@@ -760,6 +2205,96 @@ bool AutoFileHandle::read(std::string &buf) const
     return pRcfs->readFile(fileId, buf);
 }
 
+//----------------------------------------------------------------------------
+inline
+bool AutoFileHandle::readAppend(std::vector<std::uint8_t> &buf, std::size_t nBytesToRead) const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->readFileAppend(fileId, buf, nBytesToRead);
+}
+
+//----------------------------------------------------------------------------
+inline
+bool AutoFileHandle::readAppend(std::vector<char> &buf, std::size_t nBytesToRead) const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->readFileAppend(fileId, buf, nBytesToRead);
+}
+
+//----------------------------------------------------------------------------
+inline
+bool AutoFileHandle::readAppend(std::string &buf, std::size_t nBytesToRead) const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->readFileAppend(fileId, buf, nBytesToRead);
+}
+
+//----------------------------------------------------------------------------
+inline
+bool AutoFileHandle::readv(const ReadIoVec *pIoVecs, std::size_t numIoVecs, std::size_t *pBytesReaded) const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->readvFile(fileId, pIoVecs, numIoVecs, pBytesReaded);
+}
+
+//----------------------------------------------------------------------------
+inline
+FileView AutoFileHandle::getView() const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->getFileView(fileId);
+}
+
+//----------------------------------------------------------------------------
+inline
+bool AutoFileHandle::read(std::uint8_t *pBuf, std::size_t nBytesToRead, std::size_t *pBytesReaded) const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->readFile(fileId, pBuf, nBytesToRead, pBytesReaded);
+}
+
+//----------------------------------------------------------------------------
+inline
+bool AutoFileHandle::pread(std::size_t offset, std::uint8_t *pBuf, std::size_t nBytesToRead, std::size_t *pBytesReaded) const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->preadFile(fileId, offset, pBuf, nBytesToRead, pBytesReaded);
+}
+
+//----------------------------------------------------------------------------
+inline
+bool AutoFileHandle::seek(std::ptrdiff_t offset, SeekOrigin origin) const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->seekFile(fileId, offset, origin);
+}
+
+//----------------------------------------------------------------------------
+inline
+std::size_t AutoFileHandle::tell() const
+{
+    MARTY_RCFS_ASSERT(pRcfs);
+    MARTY_RCFS_ASSERT(fileId>=0);
+
+    return pRcfs->tellFile(fileId);
+}
+
 
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,161 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Простые арены (пулы) для узлов дерева RCFS
+
+    Объекты и строки только добавляются, по одному не освобождаются - всё
+    освобождается разом вместе с ареной. Адреса выделенных объектов стабильны.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Пул объектов одного типа, выделяемых кусками по ChunkSize штук
+template<typename T, std::size_t ChunkSize = 256>
+class ArenaObjectPool
+{
+    std::vector<T*>     m_chunks;
+    std::size_t         m_lastChunkUsed = ChunkSize;
+    std::size_t         m_size          = 0;
+
+public:
+
+    ArenaObjectPool() {}
+    ~ArenaObjectPool() { clear(); }
+
+    ArenaObjectPool(const ArenaObjectPool&) = delete;
+    ArenaObjectPool& operator=(const ArenaObjectPool&) = delete;
+
+    template<typename... Args>
+    T* create(Args&&... args)
+    {
+        if (m_lastChunkUsed==ChunkSize)
+        {
+            m_chunks.reserve(m_chunks.size()+1);
+            m_chunks.push_back((T*)::operator new(sizeof(T)*ChunkSize));
+            m_lastChunkUsed = 0;
+        }
+
+        T *p = new ((void*)(m_chunks.back()+m_lastChunkUsed)) T(std::forward<Args>(args)...);
+        ++m_lastChunkUsed;
+        ++m_size;
+        return p;
+    }
+
+    template<typename Handler>
+    void forEach(Handler handler) const
+    {
+        for(std::size_t chunkIdx=0; chunkIdx!=m_chunks.size(); ++chunkIdx)
+        {
+            std::size_t chunkUsed = (chunkIdx+1==m_chunks.size()) ? m_lastChunkUsed : ChunkSize;
+            for(std::size_t i=0; i!=chunkUsed; ++i)
+                handler((const T&)m_chunks[chunkIdx][i]);
+        }
+    }
+
+    template<typename Handler>
+    void forEachMutable(Handler handler)
+    {
+        for(std::size_t chunkIdx=0; chunkIdx!=m_chunks.size(); ++chunkIdx)
+        {
+            std::size_t chunkUsed = (chunkIdx+1==m_chunks.size()) ? m_lastChunkUsed : ChunkSize;
+            for(std::size_t i=0; i!=chunkUsed; ++i)
+                handler(m_chunks[chunkIdx][i]);
+        }
+    }
+
+    //! Разрушает все объекты в порядке, обратном созданию
+    void clear()
+    {
+        while(!m_chunks.empty())
+        {
+            T *pChunk = m_chunks.back();
+            while(m_lastChunkUsed)
+                pChunk[--m_lastChunkUsed].~T();
+
+            ::operator delete((void*)pChunk);
+            m_chunks.pop_back();
+            m_lastChunkUsed = ChunkSize;
+        }
+
+        m_size = 0;
+    }
+
+    std::size_t size() const { return m_size; }
+    std::size_t bytesReserved() const { return m_chunks.size()*ChunkSize*sizeof(T) + m_chunks.capacity()*sizeof(T*); }
+
+}; // class ArenaObjectPool
+
+//----------------------------------------------------------------------------
+//! Пул строк. Возвращаемые std::string_view действительны, пока жив пул
+class ArenaStringPool
+{
+    static const std::size_t chunkSize = 16384;
+
+    std::vector< std::unique_ptr<char[]> >   m_chunks;
+    std::size_t                              m_lastChunkSize = 0;
+    std::size_t                              m_lastChunkUsed = 0;
+    std::size_t                              m_bytesReserved = 0;
+    std::size_t                              m_bytesUsed     = 0;
+
+public:
+
+    //! Выделяет size байт (без выравнивания)
+    char* allocate(std::size_t size)
+    {
+        if (m_chunks.empty() || m_lastChunkSize-m_lastChunkUsed<size)
+        {
+            std::size_t newChunkSize = size>chunkSize ? size : chunkSize;
+            m_chunks.emplace_back(new char[newChunkSize]);
+            m_lastChunkSize  = newChunkSize;
+            m_lastChunkUsed  = 0;
+            m_bytesReserved += newChunkSize;
+        }
+
+        char *p = m_chunks.back().get() + m_lastChunkUsed;
+        m_lastChunkUsed += size;
+        m_bytesUsed     += size;
+
+        return p;
+    }
+
+    std::string_view store(std::string_view str)
+    {
+        if (str.empty())
+            return std::string_view();
+
+        char *p = allocate(str.size());
+        std::memcpy(p, str.data(), str.size());
+
+        return std::string_view(p, str.size());
+    }
+
+    std::size_t bytesReserved() const { return m_bytesReserved + m_chunks.capacity()*sizeof(m_chunks[0]); }
+    std::size_t bytesUsed    () const { return m_bytesUsed; }
+
+}; // class ArenaStringPool
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
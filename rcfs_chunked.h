@@ -0,0 +1,479 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Контейнер из независимо декодируемых кусков - чтение с произвольной позиции без декодирования файла целиком
+
+    Цепочка кодеков записи начинается со стадии CodecStage::Chunked, остальные
+    стадии - цепочка каждого куска (getChunkCodecChain), например
+    codecChainChunkedXorLz - куски сжаты LZ и зашифрованы XOR.
+
+    Формат:
+    - заголовок, 24 байта: "RCCK", версия (1 байт), 3 резервных байта (0),
+      размер куска в декодированных данных (4 байта), число кусков (4 байта),
+      размер декодированных данных (8 байт); все числа - little endian;
+    - таблица смещений: число кусков + 1 смещений (8 байт, little endian) от
+      начала контейнера; кусок i занимает [offset[i], offset[i+1]);
+    - закодированные куски подряд.
+
+    Все куски, кроме последнего, декодируются ровно в размер куска. Заголовок и
+    таблица не шифруются; ключевой поток XOR каждого куска начинается со
+    смещения куска в контейнере, так что куски с одним ключом не повторяют
+    одну и ту же гамму.
+
+    Чтение диапазона (decodeChunkedRange) декодирует только покрывающие его
+    куски: полностью покрытые - сразу в результат, крайние - в кэш открытого
+    файла (ChunkCache, последний декодированный кусок дескриптора), поэтому
+    последовательное чтение мелкими порциями декодирует каждый кусок один раз. Декодирование
+    целиком (decodeChunkedData) может идти в несколько потоков.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcfs_codec_chain.h"
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_RCFS_CHUNKED_DEFAULT_CHUNK_SIZE
+
+    //! Размер куска по умолчанию, байт. Меньше - дешевле случайное чтение, больше - лучше сжатие
+    #define MARTY_RCFS_CHUNKED_DEFAULT_CHUNK_SIZE     65536
+
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+namespace chunked_utils {
+
+const std::size_t   headerSize    = 24;
+const std::uint8_t  formatVersion = 1;
+const std::size_t   offsetSize    = 8;
+
+inline std::uint64_t readLe(const std::uint8_t *p, unsigned numBytes)
+{
+    std::uint64_t res = 0;
+    for(unsigned i=0; i!=numBytes; ++i)
+        res |= (std::uint64_t)p[i] << (i*8);
+    return res;
+}
+
+inline void writeLe(std::uint8_t *p, std::uint64_t v, unsigned numBytes)
+{
+    for(unsigned i=0; i!=numBytes; ++i)
+        p[i] = (std::uint8_t)(v >> (i*8));
+}
+
+//! Разобранный заголовок контейнера
+struct ChunkedHeader
+{
+    std::size_t   chunkSize   = 0;
+    std::size_t   numChunks   = 0;
+    std::size_t   decodedSize = 0;
+};
+
+//! Разбирает и проверяет заголовок. false - не контейнер, другая версия или заголовок повреждён
+inline
+bool readHeader(const std::uint8_t *pData, std::size_t size, ChunkedHeader &header)
+{
+    if (size<headerSize || std::memcmp(pData, "RCCK", 4)!=0 || pData[4]!=formatVersion)
+        return false;
+
+    const std::uint64_t chunkSize   = readLe(pData+ 8, 4);
+    const std::uint64_t numChunks   = readLe(pData+12, 4);
+    const std::uint64_t decodedSize = readLe(pData+16, 8);
+
+    if (chunkSize==0 || decodedSize>=(std::uint64_t)(std::size_t)-1)
+        return false;
+
+    // Число кусков однозначно задаётся размерами (без переполнения при decodedSize около 2^64),
+    // куски покрывают все данные, таблица должна помещаться в данные
+    if (numChunks!=decodedSize/chunkSize + (decodedSize%chunkSize!=0 ? 1 : 0))
+        return false;
+
+    if (decodedSize>numChunks*chunkSize) // Оба множителя 32-битные - произведение не переполняется
+        return false;
+
+    if (numChunks+1>(size-headerSize)/offsetSize)
+        return false;
+
+    header.chunkSize   = (std::size_t)chunkSize;
+    header.numChunks   = (std::size_t)numChunks;
+    header.decodedSize = (std::size_t)decodedSize;
+    return true;
+}
+
+//! Границы закодированного куска в контейнере. false - номер куска за таблицей или таблица смещений повреждена
+inline
+bool getChunkBounds(const std::uint8_t *pData, std::size_t size, const ChunkedHeader &header, std::size_t chunkIdx, std::size_t &begin, std::size_t &end)
+{
+    if (chunkIdx>=header.numChunks)
+        return false;
+
+    const std::uint8_t *pOffsets   = pData+headerSize;
+    const std::uint64_t tableEnd   = headerSize + (header.numChunks+1)*offsetSize;
+    const std::uint64_t chunkBegin = readLe(pOffsets+ chunkIdx   *offsetSize, 8);
+    const std::uint64_t chunkEnd   = readLe(pOffsets+(chunkIdx+1)*offsetSize, 8);
+
+    if (chunkBegin<tableEnd || chunkBegin>chunkEnd || chunkEnd>size)
+        return false;
+
+    begin = (std::size_t)chunkBegin;
+    end   = (std::size_t)chunkEnd;
+    return true;
+}
+
+//! Размер куска после декодирования (последний может быть короче)
+inline
+std::size_t getChunkDecodedSize(const ChunkedHeader &header, std::size_t chunkIdx)
+{
+    return std::min(header.chunkSize, header.decodedSize-chunkIdx*header.chunkSize);
+}
+
+//! Декодирует кусок целиком в pDst (getChunkDecodedSize байт). false - данные повреждены
+inline
+bool decodeChunk( std::uint8_t         *pDst
+                , const std::uint8_t   *pData
+                , std::size_t           size
+                , const ChunkedHeader  &header
+                , std::size_t           chunkIdx
+                , unsigned              chunkCodecChain
+                , unsigned              decryptKeySize
+                , unsigned              decryptKeySeed
+                , unsigned              decryptKeyInc
+                )
+{
+    std::size_t begin = 0, end = 0;
+    if (!getChunkBounds(pData, size, header, chunkIdx, begin, end)) // Проверяет и номер куска
+        return false;
+
+    return decodeCodecChainTo( pDst, getChunkDecodedSize(header, chunkIdx), pData+begin, end-begin
+                             , chunkCodecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, begin
+                             );
+}
+
+//! Последний декодированный кусок открытого файла - для чтения мелкими порциями
+/*! Принадлежит одному открытому файлу (дескриптору) и освобождается вместе с ним,
+    поэтому ключ - только номер куска. Параллельные чтения одного дескриптора
+    захватывают кэш через try_lock, при занятом кэше кусок декодируется во временный буфер.
+ */
+struct ChunkCache
+{
+    std::mutex                  mutex;
+    std::size_t                 chunkIdx = (std::size_t)-1;
+    std::vector<std::uint8_t>   decoded;
+};
+
+} // namespace chunked_utils
+
+//----------------------------------------------------------------------------
+//! Цепочка начинается с контейнера кусков
+inline
+bool isChunkedCodecChain(unsigned codecChain)
+{
+    return codec_chain_utils::getStage(codecChain, 0)==CodecStage::Chunked;
+}
+
+//! Цепочка кодеков каждого куска контейнера
+inline
+unsigned getChunkCodecChain(unsigned codecChain)
+{
+    return codecChain >> codecChainStageBits;
+}
+
+//----------------------------------------------------------------------------
+//! Размер декодированных данных из заголовка контейнера. (std::size_t)-1 - не контейнер или заголовок повреждён
+inline
+std::size_t chunkedGetDecodedSize(const std::uint8_t *pData, std::size_t size)
+{
+    chunked_utils::ChunkedHeader header;
+    if (!chunked_utils::readHeader(pData, size, header))
+        return (std::size_t)-1;
+
+    return header.decodedSize;
+}
+
+//----------------------------------------------------------------------------
+//! Кодирование при генерации ресурсов: данные режутся на куски по chunkSize, каждый кодируется цепочкой getChunkCodecChain(codecChain)
+/*! codecChain должна начинаться со стадии CodecStage::Chunked. maxChain - для стадии Lz (см. lzCompress).
+ */
+inline
+void encodeChunkedData( std::vector<std::uint8_t> &encoded
+                      , const std::uint8_t        *pData
+                      , std::size_t                size
+                      , unsigned                   codecChain
+                      , unsigned                   decryptKeySize
+                      , unsigned                   decryptKeySeed
+                      , unsigned                   decryptKeyInc
+                      , std::size_t                chunkSize = MARTY_RCFS_CHUNKED_DEFAULT_CHUNK_SIZE
+                      , unsigned                   maxChain  = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN
+                      )
+{
+    using namespace chunked_utils;
+
+    if (!isChunkedCodecChain(codecChain))
+        throw std::runtime_error("marty_rcfs::encodeChunkedData: codec chain must start with CodecStage::Chunked");
+
+    if (chunkSize==0 || (std::uint64_t)chunkSize>0xFFFFFFFFu)
+        throw std::runtime_error("marty_rcfs::encodeChunkedData: invalid chunk size");
+
+    const std::size_t numChunks = (size+chunkSize-1)/chunkSize;
+    if ((std::uint64_t)numChunks>0xFFFFFFFFu)
+        throw std::runtime_error("marty_rcfs::encodeChunkedData: too many chunks");
+
+    const unsigned chunkCodecChain = getChunkCodecChain(codecChain);
+
+    encoded.assign(headerSize + (numChunks+1)*offsetSize, 0);
+    std::memcpy(encoded.data(), "RCCK", 4);
+    encoded[4] = formatVersion;
+    writeLe(&encoded[ 8], chunkSize, 4);
+    writeLe(&encoded[12], numChunks, 4);
+    writeLe(&encoded[16], size     , 8);
+
+    std::vector<std::uint8_t> chunkData;
+    for(std::size_t chunkIdx=0; chunkIdx!=numChunks; ++chunkIdx)
+    {
+        const std::size_t chunkOffset = encoded.size();
+        const std::size_t chunkStart  = chunkIdx*chunkSize;
+
+        encodeCodecChain( chunkData, pData+chunkStart, std::min(chunkSize, size-chunkStart)
+                        , chunkCodecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, maxChain, chunkOffset
+                        );
+
+        writeLe(&encoded[headerSize+chunkIdx*offsetSize], chunkOffset, 8);
+        encoded.insert(encoded.end(), chunkData.begin(), chunkData.end());
+    }
+
+    writeLe(&encoded[headerSize+numChunks*offsetSize], encoded.size(), 8);
+}
+
+inline
+void encodeChunkedData(std::vector<std::uint8_t> &encoded, const std::vector<std::uint8_t> &data, unsigned codecChain, unsigned decryptKeySize, unsigned decryptKeySeed, unsigned decryptKeyInc, std::size_t chunkSize = MARTY_RCFS_CHUNKED_DEFAULT_CHUNK_SIZE, unsigned maxChain = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN)
+{
+    encodeChunkedData(encoded, data.data(), data.size(), codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, chunkSize, maxChain);
+}
+
+inline
+void encodeChunkedData(std::vector<std::uint8_t> &encoded, const std::vector<char> &data, unsigned codecChain, unsigned decryptKeySize, unsigned decryptKeySeed, unsigned decryptKeyInc, std::size_t chunkSize = MARTY_RCFS_CHUNKED_DEFAULT_CHUNK_SIZE, unsigned maxChain = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN)
+{
+    encodeChunkedData(encoded, (const std::uint8_t*)data.data(), data.size(), codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, chunkSize, maxChain);
+}
+
+inline
+void encodeChunkedData(std::vector<std::uint8_t> &encoded, const std::string &data, unsigned codecChain, unsigned decryptKeySize, unsigned decryptKeySeed, unsigned decryptKeyInc, std::size_t chunkSize = MARTY_RCFS_CHUNKED_DEFAULT_CHUNK_SIZE, unsigned maxChain = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN)
+{
+    encodeChunkedData(encoded, (const std::uint8_t*)data.data(), data.size(), codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, chunkSize, maxChain);
+}
+
+//----------------------------------------------------------------------------
+//! Декодирует контейнер целиком в pDst, ровно dstSize байт. false - данные повреждены или другого размера
+/*! numThreads>1 - куски декодируются параллельно (потоки создаются на время вызова,
+    их не больше, чем кусков). Исключение из любого потока пробрасывается вызывающему.
+ */
+inline
+bool decodeChunkedData( std::uint8_t              *pDst
+                      , std::size_t                dstSize
+                      , const std::uint8_t        *pData
+                      , std::size_t                size
+                      , unsigned                   codecChain
+                      , unsigned                   decryptKeySize
+                      , unsigned                   decryptKeySeed
+                      , unsigned                   decryptKeyInc
+                      , unsigned                   numThreads = 1
+                      )
+{
+    using namespace chunked_utils;
+
+    ChunkedHeader header;
+    if (!isChunkedCodecChain(codecChain) || !readHeader(pData, size, header) || header.decodedSize!=dstSize)
+        return false;
+
+    const unsigned chunkCodecChain = getChunkCodecChain(codecChain);
+
+    if (numThreads<=1 || header.numChunks<=1)
+    {
+        for(std::size_t chunkIdx=0; chunkIdx!=header.numChunks; ++chunkIdx)
+        {
+            if (!decodeChunk(pDst+chunkIdx*header.chunkSize, pData, size, header, chunkIdx, chunkCodecChain, decryptKeySize, decryptKeySeed, decryptKeyInc))
+                return false;
+        }
+        return true;
+    }
+
+    std::atomic<std::size_t>  nextChunk{0};
+    std::atomic<bool>         failed{false};
+    std::exception_ptr        firstException;
+    std::atomic_flag          exceptionTaken = ATOMIC_FLAG_INIT;
+
+    auto worker = [&]()
+    {
+        try
+        {
+            for(;;)
+            {
+                if (failed.load(std::memory_order_relaxed))
+                    return;
+
+                const std::size_t chunkIdx = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                if (chunkIdx>=header.numChunks)
+                    return;
+
+                if (!decodeChunk(pDst+chunkIdx*header.chunkSize, pData, size, header, chunkIdx, chunkCodecChain, decryptKeySize, decryptKeySeed, decryptKeyInc))
+                    failed.store(true, std::memory_order_relaxed);
+            }
+        }
+        catch(...)
+        {
+            if (!exceptionTaken.test_and_set())
+                firstException = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    const std::size_t numWorkers = std::min((std::size_t)numThreads, header.numChunks);
+
+    // Вызывающий поток - тоже рабочий
+    std::vector<std::thread> threads;
+    threads.reserve(numWorkers-1);
+    for(std::size_t i=1; i<numWorkers; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for(auto &t : threads)
+        t.join();
+
+    if (firstException)
+        std::rethrow_exception(firstException);
+
+    return !failed.load();
+}
+
+//! Декодирует контейнер целиком в decoded. Ёмкость decoded переиспользуется
+inline
+bool decodeChunkedData( std::vector<std::uint8_t> &decoded
+                      , const std::uint8_t        *pData
+                      , std::size_t                size
+                      , unsigned                   codecChain
+                      , unsigned                   decryptKeySize
+                      , unsigned                   decryptKeySeed
+                      , unsigned                   decryptKeyInc
+                      , unsigned                   numThreads = 1
+                      )
+{
+    const std::size_t decodedSize = chunkedGetDecodedSize(pData, size);
+    if (decodedSize==(std::size_t)-1)
+        return false;
+
+    decoded.resize(decodedSize);
+    return decodeChunkedData(decoded.data(), decodedSize, pData, size, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, numThreads);
+}
+
+//----------------------------------------------------------------------------
+//! Декодирует rangeSize байт декодированных данных, начиная с offset, в pDst. false - выход за конец или данные повреждены
+/*! Декодируются только куски, покрывающие диапазон. Крайние куски декодируются в pCache
+    (кэш открытого файла), без кэша - во временный буфер.
+ */
+inline
+bool decodeChunkedRange( std::uint8_t              *pDst
+                       , const std::uint8_t        *pData
+                       , std::size_t                size
+                       , unsigned                   codecChain
+                       , std::size_t                offset
+                       , std::size_t                rangeSize
+                       , unsigned                   decryptKeySize
+                       , unsigned                   decryptKeySeed
+                       , unsigned                   decryptKeyInc
+                       , chunked_utils::ChunkCache *pCache = 0
+                       )
+{
+    using namespace chunked_utils;
+
+    ChunkedHeader header;
+    if (!isChunkedCodecChain(codecChain) || !readHeader(pData, size, header))
+        return false;
+
+    if (offset>header.decodedSize || rangeSize>header.decodedSize-offset)
+        return false;
+
+    const unsigned chunkCodecChain = getChunkCodecChain(codecChain);
+
+    while(rangeSize)
+    {
+        const std::size_t chunkIdx       = offset/header.chunkSize;
+        const std::size_t chunkStart     = chunkIdx*header.chunkSize;
+        const std::size_t chunkDecSize   = getChunkDecodedSize(header, chunkIdx);
+        const std::size_t posInChunk     = offset-chunkStart;
+        const std::size_t bytesFromChunk = std::min(rangeSize, chunkDecSize-posInChunk);
+
+        if (bytesFromChunk==chunkDecSize)
+        {
+            // Кусок покрыт целиком - сразу в результат
+            if (!decodeChunk(pDst, pData, size, header, chunkIdx, chunkCodecChain, decryptKeySize, decryptKeySeed, decryptKeyInc))
+                return false;
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock;
+            if (pCache)
+                lock = std::unique_lock<std::mutex>(pCache->mutex, std::try_to_lock);
+
+            if (lock.owns_lock())
+            {
+                if (pCache->chunkIdx!=chunkIdx)
+                {
+                    pCache->chunkIdx = (std::size_t)-1;
+                    pCache->decoded.resize(chunkDecSize);
+                    if (!decodeChunk(pCache->decoded.data(), pData, size, header, chunkIdx, chunkCodecChain, decryptKeySize, decryptKeySeed, decryptKeyInc))
+                        return false;
+                    pCache->chunkIdx = chunkIdx;
+                }
+
+                std::memcpy(pDst, pCache->decoded.data()+posInChunk, bytesFromChunk);
+            }
+            else
+            {
+                std::vector<std::uint8_t> decoded(chunkDecSize);
+                if (!decodeChunk(decoded.data(), pData, size, header, chunkIdx, chunkCodecChain, decryptKeySize, decryptKeySeed, decryptKeyInc))
+                    return false;
+
+                std::memcpy(pDst, decoded.data()+posInChunk, bytesFromChunk);
+            }
+        }
+
+        pDst      += bytesFromChunk;
+        offset    += bytesFromChunk;
+        rangeSize -= bytesFromChunk;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
@@ -0,0 +1,426 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Цепочки кодеков данных файлов: XOR-шифрование и LZ-сжатие в одной записи
+
+    Цепочка кодеков записи - число, в котором по 4 бита записаны стадии
+    (CodecStage) в порядке декодирования, начиная с младших бит; 0 - цепочка
+    не задана (декодер решает сам, обычно по decryptKeySize).
+    Например, codecChainXorLz - данные сначала расшифровываются, потом
+    распаковываются; при генерации - сжимаются, потом шифруются (encodeCodecChain).
+
+    Цепочка XOR -> LZ декодируется за один проход: распаковщик читает сжатые
+    данные через небольшое окно (MARTY_RCFS_CODEC_WINDOW_SIZE), которое
+    расшифровывается по мере чтения, а длинные литералы расшифровываются сразу
+    в результат. Промежуточный буфер на весь файл не создаётся.
+    Остальные цепочки декодируются по стадиям.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "rcfs_codec_chain_defs.h"
+#include "rcfs_xor_decode.h"
+#include "rcfs_lz_codec.h"
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_RCFS_CODEC_WINDOW_SIZE
+
+    //! Окно расшифровки при совмещённом декодировании XOR -> LZ, байт. Должно помещаться в L1
+    #define MARTY_RCFS_CODEC_WINDOW_SIZE         4096
+
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+namespace codec_chain_utils {
+
+inline
+CodecStage getStage(unsigned codecChain, unsigned stageIdx)
+{
+    return (CodecStage)((codecChain>>(stageIdx*codecChainStageBits)) & ((1u<<codecChainStageBits)-1));
+}
+
+inline
+unsigned getNumStages(unsigned codecChain)
+{
+    unsigned numStages = 0;
+    while(numStages!=codecChainMaxStages && getStage(codecChain, numStages)!=CodecStage::End)
+        ++numStages;
+    return numStages;
+}
+
+inline
+bool isValidXorKeySize(unsigned decryptKeySize)
+{
+    return decryptKeySize==1 || decryptKeySize==2 || decryptKeySize==4;
+}
+
+inline
+void checkXorKeySize(unsigned decryptKeySize)
+{
+    if (!isValidXorKeySize(decryptKeySize))
+        throw std::runtime_error("marty_rcfs::decodeCodecChain: invalid decryptKeySize");
+}
+
+//! Источник для lzDecompressStream: расшифровывает данные окнами по мере чтения
+class XorWindowInput
+{
+    const std::uint8_t         *m_pSrc;
+    std::size_t                 m_srcSize;
+    std::size_t                 m_srcPos = 0; //!< Позиция в источнике за концом окна
+    std::size_t                 m_streamOffset;  //!< Смещение начала источника в ключевом потоке
+
+    unsigned                    m_keySize;
+    std::uint32_t               m_keySeed;
+    std::uint32_t               m_keyInc;
+
+    std::uint8_t                m_window[MARTY_RCFS_CODEC_WINDOW_SIZE];
+    std::size_t                 m_windowPos = 0;
+    std::size_t                 m_windowEnd = 0;
+
+
+    //! Сдвигает остаток окна в начало и дочитывает окно. false - источник кончился
+    bool refill()
+    {
+        if (m_srcPos==m_srcSize)
+            return false;
+
+        const std::size_t rest = m_windowEnd-m_windowPos;
+        std::memmove(m_window, m_window+m_windowPos, rest);
+
+        std::size_t size = m_srcSize-m_srcPos;
+        if (size>sizeof(m_window)-rest)
+            size = sizeof(m_window)-rest;
+
+        xorDecodeData(m_window+rest, m_pSrc+m_srcPos, size, m_keySize, m_keySeed, m_keyInc, m_streamOffset+m_srcPos);
+
+        m_srcPos   += size;
+        m_windowPos = 0;
+        m_windowEnd = rest+size;
+
+        return true;
+    }
+
+public:
+
+    XorWindowInput(const std::uint8_t *pSrc, std::size_t srcSize, unsigned keySize, std::uint32_t keySeed, std::uint32_t keyInc, std::size_t streamOffset = 0)
+    : m_pSrc(pSrc), m_srcSize(srcSize), m_streamOffset(streamOffset), m_keySize(keySize), m_keySeed(keySeed), m_keyInc(keyInc)
+    {}
+
+    bool atEnd() const
+    {
+        return m_windowPos==m_windowEnd && m_srcPos==m_srcSize;
+    }
+
+    const std::uint8_t* peek(std::size_t &size)
+    {
+        if (m_windowEnd-m_windowPos<lz_codec_utils::wildCopyMargin)
+            refill();
+
+        size = m_windowEnd-m_windowPos;
+        return m_window+m_windowPos;
+    }
+
+    void skip(std::size_t size)
+    {
+        m_windowPos += size;
+    }
+
+    bool readByte(std::uint8_t &b)
+    {
+        if (m_windowPos==m_windowEnd && !refill())
+            return false;
+
+        b = m_window[m_windowPos++];
+        return true;
+    }
+
+    bool copyTo(std::uint8_t *pDst, std::size_t size)
+    {
+        if (!size)
+            return true; // Последовательность без литералов; у пустого результата pDst может быть нулевым
+
+        if (size>(m_windowEnd-m_windowPos)+(m_srcSize-m_srcPos))
+            return false;
+
+        std::size_t nCopy = m_windowEnd-m_windowPos;
+        if (nCopy>size)
+            nCopy = size;
+
+        std::memcpy(pDst, m_window+m_windowPos, nCopy);
+        m_windowPos += nCopy;
+        pDst        += nCopy;
+        size        -= nCopy;
+
+        if (!size)
+            return true;
+
+        if (size>=sizeof(m_window))
+        {
+            // Длинные литералы - сразу в результат, минуя окно
+            xorDecodeData(pDst, m_pSrc+m_srcPos, size, m_keySize, m_keySeed, m_keyInc, m_streamOffset+m_srcPos);
+            m_srcPos += size;
+            return true;
+        }
+
+        refill();
+        std::memcpy(pDst, m_window, size);
+        m_windowPos = size;
+
+        return true;
+    }
+
+}; // class XorWindowInput
+
+//! Размер распакованных данных из зашифрованного заголовка RCLZ. (std::size_t)-1 - не сжаты
+inline
+std::size_t getXorLzDecompressedSize(const std::uint8_t *pData, std::size_t size, unsigned keySize, std::uint32_t keySeed, std::uint32_t keyInc, std::size_t streamOffset)
+{
+    if (size<lz_codec_utils::headerSize || !isValidXorKeySize(keySize))
+        return (std::size_t)-1;
+
+    std::uint8_t header[lz_codec_utils::headerSize];
+    xorDecodeData(header, pData, sizeof(header), keySize, keySeed, keyInc, streamOffset);
+
+    const std::size_t decompressedSize = lzGetDecompressedSize(header, sizeof(header));
+    if (decompressedSize!=(std::size_t)-1 && decompressedSize/255>size-sizeof(header))
+        return (std::size_t)-1; // Заведомо неверный размер
+
+    return decompressedSize;
+}
+
+//! Расшифровка XOR и распаковка за один проход в pDst ровно dstSize байт. false - данные повреждены или другого размера
+inline
+bool decodeXorLzTo(std::uint8_t *pDst, std::size_t dstSize, const std::uint8_t *pData, std::size_t size, unsigned keySize, std::uint32_t keySeed, std::uint32_t keyInc, std::size_t streamOffset)
+{
+    if (getXorLzDecompressedSize(pData, size, keySize, keySeed, keyInc, streamOffset)!=dstSize)
+        return false;
+
+    XorWindowInput input(pData+lz_codec_utils::headerSize, size-lz_codec_utils::headerSize, keySize, keySeed, keyInc, streamOffset+lz_codec_utils::headerSize);
+    return lzDecompressStream(pDst, dstSize, input);
+}
+
+//! Одна стадия декодирования из pData в decoded
+inline
+void decodeStage(std::vector<std::uint8_t> &decoded, const std::uint8_t *pData, std::size_t size, CodecStage stage, unsigned keySize, std::uint32_t keySeed, std::uint32_t keyInc, std::size_t xorStreamOffset)
+{
+    switch(stage)
+    {
+        case CodecStage::Xor:
+            checkXorKeySize(keySize);
+            decoded.resize(size);
+            xorDecodeData(decoded.data(), pData, size, keySize, keySeed, keyInc, xorStreamOffset);
+            return;
+
+        case CodecStage::Lz:
+            if (!lzDecompress(decoded, pData, size))
+                throw std::runtime_error("marty_rcfs::decodeCodecChain: corrupted compressed data");
+            return;
+
+        default:
+            throw std::runtime_error("marty_rcfs::decodeCodecChain: unknown codec stage");
+    }
+}
+
+} // namespace codec_chain_utils
+
+//----------------------------------------------------------------------------
+//! Декодирует данные цепочкой кодеков в decoded. false - цепочка пустая (декодирование не требуется)
+/*! Ёмкость decoded переиспользуется. При повреждённых данных или неизвестной стадии - исключение.
+    xorStreamOffset - смещение данных в ключевом потоке стадии Xor (для кусков, см. rcfs_chunked.h).
+ */
+inline
+bool decodeCodecChain( std::vector<std::uint8_t> &decoded
+                     , const std::uint8_t        *pData
+                     , std::size_t                size
+                     , unsigned                   codecChain
+                     , unsigned                   decryptKeySize
+                     , unsigned                   decryptKeySeed
+                     , unsigned                   decryptKeyInc
+                     , std::size_t                xorStreamOffset = 0
+                     )
+{
+    using namespace codec_chain_utils;
+
+    const unsigned numStages = getNumStages(codecChain);
+    if (!numStages)
+        return false;
+
+    if (codecChain==codecChainXorLz)
+    {
+        checkXorKeySize(decryptKeySize);
+
+        const std::size_t decompressedSize = getXorLzDecompressedSize(pData, size, decryptKeySize, decryptKeySeed, decryptKeyInc, xorStreamOffset);
+        if (decompressedSize==(std::size_t)-1)
+            throw std::runtime_error("marty_rcfs::decodeCodecChain: corrupted compressed data");
+
+        decoded.resize(decompressedSize);
+        if (!decodeXorLzTo(decoded.data(), decompressedSize, pData, size, decryptKeySize, decryptKeySeed, decryptKeyInc, xorStreamOffset))
+            throw std::runtime_error("marty_rcfs::decodeCodecChain: corrupted compressed data");
+        return true;
+    }
+
+    decodeStage(decoded, pData, size, getStage(codecChain, 0), decryptKeySize, decryptKeySeed, decryptKeyInc, xorStreamOffset);
+
+    // Редкие цепочки - по стадиям, через промежуточный буфер
+    std::vector<std::uint8_t> stageData;
+    for(unsigned stageIdx=1; stageIdx!=numStages; ++stageIdx)
+    {
+        std::swap(stageData, decoded);
+        decodeStage(decoded, stageData.data(), stageData.size(), getStage(codecChain, stageIdx), decryptKeySize, decryptKeySeed, decryptKeyInc, xorStreamOffset);
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//! Декодирует данные цепочкой кодеков прямо в pDst, ровно dstSize байт
+/*! false - данные повреждены или декодируются в другое число байт. Пустая цепочка - копирование.
+    Цепочки Xor, Lz и Xor -> Lz декодируются без промежуточных буферов, остальные - через decodeCodecChain.
+    При недопустимом ключе или неизвестной стадии - исключение.
+ */
+inline
+bool decodeCodecChainTo( std::uint8_t              *pDst
+                       , std::size_t                dstSize
+                       , const std::uint8_t        *pData
+                       , std::size_t                size
+                       , unsigned                   codecChain
+                       , unsigned                   decryptKeySize
+                       , unsigned                   decryptKeySeed
+                       , unsigned                   decryptKeyInc
+                       , std::size_t                xorStreamOffset = 0
+                       )
+{
+    using namespace codec_chain_utils;
+
+    if (codecChain==codecChainDefault)
+    {
+        if (size!=dstSize)
+            return false;
+        if (size)
+            std::memcpy(pDst, pData, size);
+        return true;
+    }
+
+    if (codecChain==codecChainXor)
+    {
+        checkXorKeySize(decryptKeySize);
+        if (size!=dstSize)
+            return false;
+        return xorDecodeData(pDst, pData, size, decryptKeySize, decryptKeySeed, decryptKeyInc, xorStreamOffset);
+    }
+
+    if (codecChain==codecChainLz)
+    {
+        if (lzGetDecompressedSize(pData, size)!=dstSize || dstSize/255>size-lz_codec_utils::headerSize)
+            return false;
+        return lzDecompressBlock(pDst, dstSize, pData+lz_codec_utils::headerSize, size-lz_codec_utils::headerSize);
+    }
+
+    if (codecChain==codecChainXorLz)
+    {
+        checkXorKeySize(decryptKeySize);
+        return decodeXorLzTo(pDst, dstSize, pData, size, decryptKeySize, decryptKeySeed, decryptKeyInc, xorStreamOffset);
+    }
+
+    std::vector<std::uint8_t> decoded;
+    decodeCodecChain(decoded, pData, size, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, xorStreamOffset);
+    if (decoded.size()!=dstSize)
+        return false;
+
+    if (dstSize)
+        std::memcpy(pDst, decoded.data(), dstSize);
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//! Размер данных после декодирования цепочкой, без декодирования. (std::size_t)-1 - неизвестен
+inline
+std::size_t getCodecChainDecodedSize( const std::uint8_t *pData
+                                    , std::size_t         size
+                                    , unsigned            codecChain
+                                    , unsigned            decryptKeySize
+                                    , unsigned            decryptKeySeed
+                                    , unsigned            decryptKeyInc
+                                    )
+{
+    using namespace codec_chain_utils;
+
+    if (codecChain==codecChainDefault || codecChain==codecChainXor)
+        return size;
+
+    if (codecChain==codecChainLz)
+        return lzGetDecompressedSize(pData, size);
+
+    if (codecChain==codecChainXorLz)
+        return getXorLzDecompressedSize(pData, size, decryptKeySize, decryptKeySeed, decryptKeyInc, 0);
+
+    return (std::size_t)-1;
+}
+
+//----------------------------------------------------------------------------
+//! Кодирование при генерации ресурсов: стадии применяются в обратном порядке
+/*! Для стадии Lz - lzCompress с maxChain.
+ */
+inline
+void encodeCodecChain( std::vector<std::uint8_t> &encoded
+                     , const std::uint8_t        *pData
+                     , std::size_t                size
+                     , unsigned                   codecChain
+                     , unsigned                   decryptKeySize
+                     , unsigned                   decryptKeySeed
+                     , unsigned                   decryptKeyInc
+                     , unsigned                   maxChain = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN
+                     , std::size_t                xorStreamOffset = 0
+                     )
+{
+    using namespace codec_chain_utils;
+
+    encoded.assign(pData, pData+size);
+
+    std::vector<std::uint8_t> stageData;
+    for(unsigned stageIdx=getNumStages(codecChain); stageIdx--; )
+    {
+        switch(getStage(codecChain, stageIdx))
+        {
+            case CodecStage::Xor:
+                checkXorKeySize(decryptKeySize);
+                xorEncodeData(encoded.data(), encoded.data(), encoded.size(), decryptKeySize, decryptKeySeed, decryptKeyInc, xorStreamOffset);
+                break;
+
+            case CodecStage::Lz:
+                std::swap(stageData, encoded);
+                lzCompress(encoded, stageData.data(), stageData.size(), maxChain);
+                break;
+
+            default:
+                throw std::runtime_error("marty_rcfs::encodeCodecChain: unknown codec stage");
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
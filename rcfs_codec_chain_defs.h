@@ -0,0 +1,54 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Стадии и константы цепочек кодеков - без самих кодеков
+
+    Нужны интерфейсу декодера (i_file_decoder.h) и коду, который только
+    задаёт цепочку записи. Декодирование цепочек - rcfs_codec_chain.h.
+*/
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Стадия цепочки кодеков
+enum class CodecStage : unsigned
+{
+    End = 0, //!< Конец цепочки
+    Xor = 1, //!< XOR-шифрование ключом записи (decryptKeySize/Seed/Inc)
+    Lz  = 2, //!< LZ-сжатие (rcfs_lz_codec.h)
+    Chunked = 3 //!< Контейнер из независимых кусков (rcfs_chunked.h), только первой стадией; остальные стадии - цепочка кусков
+
+}; // enum class CodecStage
+
+//----------------------------------------------------------------------------
+const unsigned codecChainStageBits = 4;
+const unsigned codecChainMaxStages = 8;
+
+//! Цепочка из стадий в порядке декодирования
+constexpr
+unsigned makeCodecChain(CodecStage s0, CodecStage s1 = CodecStage::End, CodecStage s2 = CodecStage::End)
+{
+    return (unsigned)s0 | ((unsigned)s1<<codecChainStageBits) | ((unsigned)s2<<(2*codecChainStageBits));
+}
+
+const unsigned codecChainDefault = 0;
+const unsigned codecChainXor     = makeCodecChain(CodecStage::Xor);
+const unsigned codecChainLz      = makeCodecChain(CodecStage::Lz);
+const unsigned codecChainXorLz   = makeCodecChain(CodecStage::Xor, CodecStage::Lz);
+const unsigned codecChainChunkedLz    = makeCodecChain(CodecStage::Chunked, CodecStage::Lz);
+const unsigned codecChainChunkedXorLz = makeCodecChain(CodecStage::Chunked, CodecStage::Xor, CodecStage::Lz);
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
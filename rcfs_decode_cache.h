@@ -0,0 +1,301 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Кэш декодированных данных файлов с ограничением по объёму и вытеснением LRU
+
+    Декодированные данные файлов дерева учитываются в одном списке LRU
+    (интрузивном - ссылки лежат в FileEntryData). Когда суммарный объём
+    превышает бюджет, данные давно не открывавшихся и не открытых сейчас
+    (незаблокированных) файлов освобождаются; при следующем открытии файл
+    будет декодирован заново.
+
+    Повторное открытие декодированного файла не берёт блокировок - только
+    отмечает файл как использованный. Такие файлы при вытеснении получают
+    второй шанс и переносятся в начало списка (как в CLOCK).
+
+    Состояние декодирования файла (FileDecodeState) атомарное в любой сборке -
+    и без MARTY_RCFS_THREAD_SAFE его параллельно читают и вытесняют потоки
+    warmUp. Вытеснение переводит файл в Evicting и только
+    потом проверяет блокировку - открывающий поток, наоборот, блокирует
+    запись и потом читает состояние, поэтому данные открываемого файла
+    никогда не освобождаются.
+
+    Остальная синхронизация - на вызывающей стороне (при MARTY_RCFS_THREAD_SAFE -
+    мьютекс декодирования арены дерева).
+*/
+
+//----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_RCFS_DECODE_CACHE_BUDGET
+
+    //! Бюджет кэша декодированных данных по умолчанию, байт. По умолчанию не ограничен
+    #define MARTY_RCFS_DECODE_CACHE_BUDGET       ((std::size_t)-1)
+
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Состояние декодирования данных файла
+enum class FileDecodeState : std::uint8_t
+{
+    NotDecoded  = 0,
+    Decoding    = 1, //!< Декодируется - остальные ждут результата
+    Decoded     = 2, //!< Декодированные данные - в fileDataDecrypted
+    NotRequired = 3, //!< Декодер сообщил, что декодирование не требуется
+    Evicting    = 4  //!< Данные освобождаются кэшем
+
+}; // enum class FileDecodeState
+
+//----------------------------------------------------------------------------
+namespace decode_state_utils {
+
+// Атомарные в любой сборке: без MARTY_RCFS_THREAD_SAFE состояние без блокировок читают потоки warmUp,
+// пока другой его поток вытесняет файлы
+
+typedef std::atomic<FileDecodeState>    StateVar;
+typedef std::atomic<bool>               FlagVar;
+typedef std::atomic<std::size_t>        CounterVar;
+
+// Состояние - с последовательной согласованностью: на ней держится порядок "заблокировать, потом прочитать состояние"
+inline FileDecodeState load(const StateVar &var) { return var.load(); }
+inline void store(StateVar &var, FileDecodeState state) { var.store(state); }
+inline bool compareExchange(StateVar &var, FileDecodeState expected, FileDecodeState desired) { return var.compare_exchange_strong(expected, desired); }
+
+inline bool exchangeFlag(FlagVar &var, bool value) { return var.exchange(value, std::memory_order_relaxed); }
+inline void setFlag(FlagVar &var, bool value) { var.store(value, std::memory_order_relaxed); }
+
+inline void increment(CounterVar &var) { var.fetch_add(1, std::memory_order_relaxed); }
+inline std::size_t loadCounter(const CounterVar &var) { return var.load(std::memory_order_relaxed); }
+
+} // namespace decode_state_utils
+
+//----------------------------------------------------------------------------
+//! Статистика кэша декодированных данных
+struct DecodeCacheStats
+{
+    std::size_t     numHits      = 0; //!< Открытий уже декодированного файла
+    std::size_t     numMisses    = 0; //!< Декодирований
+    std::size_t     numWaits     = 0; //!< Открытий, дождавшихся декодирования другим потоком (вместо повторного декодирования)
+    std::size_t     numEvictions = 0; //!< Вытеснений (по бюджету и trim)
+    std::size_t     bytesEvicted = 0;
+    std::size_t     numCached    = 0; //!< Файлов с декодированными данными сейчас
+    std::size_t     bytesCached  = 0;
+    std::size_t     budgetBytes  = 0;
+
+}; // struct DecodeCacheStats
+
+//----------------------------------------------------------------------------
+//! Список LRU декодированных данных
+/*! EntryType - запись дерева (DirectoryEntry): getFileData() со ссылками pCachePrev/pCacheNext,
+    признаком cacheReferenced, состоянием decodeState и буфером fileDataDecrypted, locked().
+ */
+template<typename EntryType>
+class DecodedDataCache
+{
+    EntryType                  *m_pHead  = 0; //!< Использованный последним
+    EntryType                  *m_pTail  = 0; //!< Давно не использованный - вытесняется первым
+    std::size_t                 m_budget = MARTY_RCFS_DECODE_CACHE_BUDGET;
+    DecodeCacheStats            m_stats;
+    decode_state_utils::CounterVar  m_numHits{0}; //!< Считается без блокировок
+
+
+    static std::size_t getEntryBytes(const EntryType *pEntry)
+    {
+        return pEntry->getFileData()->fileDataDecrypted.capacity();
+    }
+
+    bool isLinked(const EntryType *pEntry) const
+    {
+        const auto *pFileData = pEntry->getFileData();
+        return pFileData->pCachePrev || pFileData->pCacheNext || m_pHead==pEntry;
+    }
+
+    void unlink(EntryType *pEntry)
+    {
+        auto *pFileData = pEntry->getFileData();
+
+        if (pFileData->pCachePrev)
+            pFileData->pCachePrev->getFileData()->pCacheNext = pFileData->pCacheNext;
+        else
+            m_pHead = pFileData->pCacheNext;
+
+        if (pFileData->pCacheNext)
+            pFileData->pCacheNext->getFileData()->pCachePrev = pFileData->pCachePrev;
+        else
+            m_pTail = pFileData->pCachePrev;
+
+        pFileData->pCachePrev = 0;
+        pFileData->pCacheNext = 0;
+    }
+
+    void linkFront(EntryType *pEntry)
+    {
+        auto *pFileData = pEntry->getFileData();
+
+        pFileData->pCachePrev = 0;
+        pFileData->pCacheNext = m_pHead;
+
+        if (m_pHead)
+            m_pHead->getFileData()->pCachePrev = pEntry;
+        else
+            m_pTail = pEntry;
+
+        m_pHead = pEntry;
+    }
+
+public:
+
+    DecodedDataCache() {}
+
+    DecodedDataCache(const DecodedDataCache&) = delete;
+    DecodedDataCache& operator=(const DecodedDataCache&) = delete;
+
+    //! Файл уже декодирован и снова открывается. Без блокировок - только отмечает использование
+    void touch(EntryType *pEntry)
+    {
+        decode_state_utils::increment(m_numHits);
+        decode_state_utils::setFlag(pEntry->getFileData()->cacheReferenced, true);
+    }
+
+    //! Открывающий поток дождался чужого декодирования
+    void countWait()
+    {
+        ++m_stats.numWaits;
+    }
+
+    //! Файл только что декодирован (состояние уже Decoded). Если бюджет превышен, вытесняет незаблокированные файлы
+    void insert(EntryType *pEntry)
+    {
+        ++m_stats.numMisses;
+
+        decode_state_utils::setFlag(pEntry->getFileData()->cacheReferenced, false);
+
+        if (isLinked(pEntry))
+            unlink(pEntry);
+        else
+        {
+            ++m_stats.numCached;
+            m_stats.bytesCached += getEntryBytes(pEntry);
+        }
+
+        linkFront(pEntry);
+
+        if (m_stats.bytesCached>m_budget)
+            trim(m_budget);
+    }
+
+    //! Декодированные данные файла сбрасываются вне кэша (переустановка данных файла)
+    void remove(EntryType *pEntry)
+    {
+        if (!isLinked(pEntry))
+            return;
+
+        --m_stats.numCached;
+        m_stats.bytesCached -= getEntryBytes(pEntry);
+
+        unlink(pEntry);
+    }
+
+    //! Освобождает декодированные данные незаблокированных файлов, начиная с давно не использованных, пока объём больше targetBytes
+    /*! Использованные с прошлого прохода файлы получают второй шанс. Возвращает число освобождённых байт.
+     */
+    std::size_t trim(std::size_t targetBytes = 0)
+    {
+        std::size_t bytesFreed = 0;
+
+        // Каждый файл переносится в начало не больше одного раза - проход конечен
+        std::size_t numVisitsLeft = 2*m_stats.numCached;
+
+        EntryType *pEntry = m_pTail;
+        while(pEntry && m_stats.bytesCached>targetBytes && numVisitsLeft--)
+        {
+            auto *pFileData = pEntry->getFileData();
+            EntryType *pPrev = pFileData->pCachePrev;
+
+            if (decode_state_utils::exchangeFlag(pFileData->cacheReferenced, false))
+            {
+                // Второй шанс
+                if (m_pHead!=pEntry)
+                {
+                    unlink(pEntry);
+                    linkFront(pEntry);
+                }
+                pEntry = pPrev ? pPrev : m_pTail;
+                continue;
+            }
+
+            // Сначала объявляем вытеснение, потом проверяем блокировку (см. описание файла)
+            if (decode_state_utils::compareExchange(pFileData->decodeState, FileDecodeState::Decoded, FileDecodeState::Evicting))
+            {
+                if (!pEntry->locked())
+                {
+                    const std::size_t entryBytes = getEntryBytes(pEntry);
+
+                    unlink(pEntry);
+                    std::vector<std::uint8_t>().swap(pFileData->fileDataDecrypted);
+                    decode_state_utils::store(pFileData->decodeState, FileDecodeState::NotDecoded);
+
+                    --m_stats.numCached;
+                    m_stats.bytesCached  -= entryBytes;
+                    m_stats.bytesEvicted += entryBytes;
+                    ++m_stats.numEvictions;
+
+                    bytesFreed += entryBytes;
+                }
+                else
+                {
+                    decode_state_utils::store(pFileData->decodeState, FileDecodeState::Decoded);
+                }
+            }
+
+            pEntry = pPrev;
+        }
+
+        return bytesFreed;
+    }
+
+    //! Устанавливает бюджет и сразу вытесняет лишнее
+    void setBudget(std::size_t budgetBytes)
+    {
+        m_budget = budgetBytes;
+        if (m_stats.bytesCached>m_budget)
+            trim(m_budget);
+    }
+
+    std::size_t getBudget() const { return m_budget; }
+
+    DecodeCacheStats getStats() const
+    {
+        DecodeCacheStats stats = m_stats;
+        stats.numHits     = decode_state_utils::loadCounter(m_numHits);
+        stats.budgetBytes = m_budget;
+        return stats;
+    }
+
+}; // class DecodedDataCache
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
@@ -0,0 +1,360 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Таблица дескрипторов открытых файлов - слоты со списком свободных и поколениями
+
+    Дескриптор = (поколение << MARTY_RCFS_DESCRIPTOR_INDEX_BITS) | номер слота.
+    Доступ по дескриптору - индекс в массиве. Поколение слота меняется при
+    каждом закрытии, поэтому устаревший (уже закрытый) дескриптор не находит
+    чужой файл. Закрытые слоты переиспользуются, и в установившемся режиме
+    открытие и закрытие ничего не выделяют.
+
+    Слоты выделяются кусками растущего размера (64, 64, 128, 256...) и не
+    перемещаются. Поиск по дескриптору не берёт блокировок - состояние слота
+    (поколение и признак занятости) атомарное.
+    При MARTY_RCFS_THREAD_SAFE таблица делится на шарды, у каждого свой список
+    свободных слотов и свой мьютекс; поток открывает файлы в "своём" шарде,
+    так что потоки не мешают друг другу и при открытии/закрытии. Когда свой
+    шард заполнен, слот берётся в следующих по кругу - ограничение на число
+    открытых файлов общее для таблицы, а не на поток.
+
+    Поколение занимает оставшиеся биты положительного int (при 20 битах номера
+    слота - 2047 значений) и по кругу повторяется. Свободные слоты выдаются в
+    порядке освобождения (FIFO), поэтому устаревший дескриптор может снова
+    стать действительным, только если его слот открывали и закрывали 2047 раз,
+    а с ним - и все остальные свободные слоты шарда. Защита от ошибочного
+    использования закрытых дескрипторов - по возможности, а не гарантия; если
+    нужно больше поколений, уменьшите MARTY_RCFS_DESCRIPTOR_INDEX_BITS.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_RCFS_DESCRIPTOR_INDEX_BITS
+
+    //! Бит под номер слота. Остальные биты положительного int - поколение (при 20 битах - 1M одновременно открытых файлов и 2047 поколений)
+    #define MARTY_RCFS_DESCRIPTOR_INDEX_BITS     20
+
+#endif
+
+#ifndef MARTY_RCFS_DESCRIPTOR_SHARD_BITS
+
+    #if defined(MARTY_RCFS_THREAD_SAFE)
+        //! Бит номера слота под номер шарда (2^bits шардов)
+        #define MARTY_RCFS_DESCRIPTOR_SHARD_BITS     4
+    #else
+        #define MARTY_RCFS_DESCRIPTOR_SHARD_BITS     0
+    #endif
+
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+namespace descriptor_table_utils {
+
+#if defined(MARTY_RCFS_THREAD_SAFE)
+
+    typedef std::mutex     MutexType;
+
+    //! Номер шарда для текущего потока - потоки раздаются по шардам по кругу
+    inline
+    unsigned getThreadShardSeed()
+    {
+        static std::atomic<unsigned> nextSeed{0};
+        thread_local unsigned seed = nextSeed.fetch_add(1, std::memory_order_relaxed);
+        return seed;
+    }
+
+#else
+
+    struct MutexType
+    {
+        void lock() {}
+        void unlock() {}
+    };
+
+    inline
+    unsigned getThreadShardSeed()
+    {
+        return 0;
+    }
+
+#endif
+
+//! Номер старшего единичного бита, v!=0
+inline
+unsigned highestBitIndex(std::uint32_t v)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+        return 31u - (unsigned)__builtin_clz(v);
+    #elif defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse(&idx, (unsigned long)v);
+        return (unsigned)idx;
+    #else
+        unsigned idx = 0;
+        while(v>>=1)
+            ++idx;
+        return idx;
+    #endif
+}
+
+} // namespace descriptor_table_utils
+
+//----------------------------------------------------------------------------
+template<typename InfoType>
+class DescriptorTable
+{
+
+public:
+
+    static const unsigned       indexBits      = MARTY_RCFS_DESCRIPTOR_INDEX_BITS;
+    static const unsigned       shardBits      = MARTY_RCFS_DESCRIPTOR_SHARD_BITS;
+    static const std::uint32_t  indexMask      = (1u<<indexBits)-1;
+    static const std::uint32_t  generationMask = (0x7FFFFFFFu>>indexBits); // Дескриптор всегда неотрицательный
+    static const std::uint32_t  numShards      = 1u<<shardBits;
+    static const std::uint32_t  maxShardSlots  = 1u<<(indexBits-shardBits);
+
+protected:
+
+    static const std::uint32_t  noSlot         = 0xFFFFFFFFu;
+    static const unsigned       baseChunkBits  = 6;
+    static const unsigned       maxChunks      = indexBits-shardBits-baseChunkBits+1;
+
+    //! Кусок 0 - слоты [0, 64), кусок k>0 - слоты [2^(k+5), 2^(k+6))
+    static unsigned chunkIndex(std::uint32_t localIdx)
+    {
+        std::uint32_t v = localIdx>>baseChunkBits;
+        return v ? descriptor_table_utils::highestBitIndex(v)+1 : 0;
+    }
+
+    static std::uint32_t chunkStart(unsigned chunkIdx) { return chunkIdx ? (1u<<(chunkIdx-1+baseChunkBits)) : 0; }
+    static std::uint32_t chunkSize (unsigned chunkIdx) { return chunkIdx ? (1u<<(chunkIdx-1+baseChunkBits)) : (1u<<baseChunkBits); }
+
+    struct Slot
+    {
+        InfoType                    info;
+        std::atomic<std::uint32_t>  state{2};   //!< (generation<<1) | used. Поколение никогда не 0 - дескриптор 0 не выдаётся
+        std::uint32_t               nextFree = noSlot;
+    };
+
+    struct Shard
+    {
+        descriptor_table_utils::MutexType               mutex;
+        std::uint32_t                                   freeHead = noSlot;
+        std::uint32_t                                   freeTail = noSlot;
+        std::uint32_t                                   numSlots = 0;
+        std::uint32_t                                   numUsed  = 0;
+        std::atomic<Slot*>                              chunks[maxChunks];
+
+        Shard()
+        {
+            for(unsigned i=0; i!=maxChunks; ++i)
+                chunks[i].store(0, std::memory_order_relaxed);
+        }
+
+        ~Shard()
+        {
+            for(unsigned i=0; i!=maxChunks; ++i)
+                delete[] chunks[i].load(std::memory_order_relaxed);
+        }
+
+        Slot* getSlot(std::uint32_t localIdx, std::memory_order order) const
+        {
+            const unsigned chunkIdx = chunkIndex(localIdx);
+            Slot *pChunk = chunks[chunkIdx].load(order);
+            return pChunk ? pChunk + (localIdx-chunkStart(chunkIdx)) : 0;
+        }
+    };
+
+    mutable Shard                       m_shards[numShards];
+
+
+    static int makeDescriptor(std::uint32_t shardIdx, std::uint32_t localIdx, std::uint32_t generation)
+    {
+        return (int)((generation<<indexBits) | (localIdx<<shardBits) | shardIdx);
+    }
+
+    Slot* findSlot(int descriptor) const
+    {
+        if (descriptor<=0)
+            return 0;
+
+        const std::uint32_t slotIdx  = (std::uint32_t)descriptor & indexMask;
+        const std::uint32_t shardIdx = slotIdx & (numShards-1);
+        const std::uint32_t localIdx = slotIdx >> shardBits;
+
+        Slot *pSlot = m_shards[shardIdx].getSlot(localIdx, std::memory_order_acquire);
+        if (!pSlot)
+            return 0;
+
+        if (pSlot->state.load(std::memory_order_acquire)!=((((std::uint32_t)descriptor>>indexBits)<<1) | 1u))
+            return 0; // Закрыт или устаревший дескриптор
+
+        return pSlot;
+    }
+
+    //! Возвращает -1, если шард заполнен
+    int allocateInShard(std::uint32_t shardIdx, const InfoType &info)
+    {
+        Shard &shard = m_shards[shardIdx];
+
+        std::lock_guard<descriptor_table_utils::MutexType> lock(shard.mutex);
+
+        std::uint32_t localIdx = shard.freeHead;
+        Slot *pSlot = 0;
+
+        if (localIdx!=noSlot)
+        {
+            pSlot = shard.getSlot(localIdx, std::memory_order_relaxed);
+            shard.freeHead = pSlot->nextFree;
+            if (shard.freeHead==noSlot)
+                shard.freeTail = noSlot;
+        }
+        else
+        {
+            if (shard.numSlots>=maxShardSlots)
+                return -1;
+
+            localIdx = shard.numSlots++;
+
+            const unsigned chunkIdx = chunkIndex(localIdx);
+            if (!shard.chunks[chunkIdx].load(std::memory_order_relaxed))
+                shard.chunks[chunkIdx].store(new Slot[chunkSize(chunkIdx)], std::memory_order_release);
+
+            pSlot = shard.getSlot(localIdx, std::memory_order_relaxed);
+        }
+
+        pSlot->info     = info;
+        pSlot->nextFree = noSlot;
+
+        const std::uint32_t generation = pSlot->state.load(std::memory_order_relaxed)>>1;
+        pSlot->state.store((generation<<1) | 1u, std::memory_order_release); // Публикуем info
+
+        ++shard.numUsed;
+
+        return makeDescriptor(shardIdx, localIdx, generation);
+    }
+
+public:
+
+    DescriptorTable() {}
+
+    //! Открытые файлы не копируются - копия начинает с пустой таблицы
+    DescriptorTable(const DescriptorTable&) : DescriptorTable() {}
+    DescriptorTable& operator=(const DescriptorTable&) { return *this; }
+
+    //! Возвращает -1, если слоты кончились во всех шардах
+    /*! Сначала - шард текущего потока, при его заполнении - остальные по кругу.
+     */
+    int allocate(const InfoType &info)
+    {
+        const std::uint32_t homeShardIdx = descriptor_table_utils::getThreadShardSeed() & (numShards-1);
+
+        for(std::uint32_t i=0; i!=numShards; ++i)
+        {
+            int descriptor = allocateInShard((homeShardIdx+i) & (numShards-1), info);
+            if (descriptor>=0)
+                return descriptor;
+        }
+
+        return -1;
+    }
+
+    //! Без блокировок. Результат действителен до закрытия дескриптора
+    InfoType* find(int descriptor)
+    {
+        Slot *pSlot = findSlot(descriptor);
+        return pSlot ? &pSlot->info : 0;
+    }
+
+    const InfoType* find(int descriptor) const
+    {
+        const Slot *pSlot = findSlot(descriptor);
+        return pSlot ? &pSlot->info : 0;
+    }
+
+    //! Освобождает слот. Дескриптор и все его копии становятся недействительными
+    /*! Информация слота возвращается через pReleasedInfo - при одновременном
+        закрытии одного дескриптора её получает только один поток.
+     */
+    bool release(int descriptor, InfoType *pReleasedInfo = 0)
+    {
+        if (descriptor<=0)
+            return false;
+
+        const std::uint32_t slotIdx  = (std::uint32_t)descriptor & indexMask;
+        const std::uint32_t shardIdx = slotIdx & (numShards-1);
+        const std::uint32_t localIdx = slotIdx >> shardBits;
+        Shard &shard = m_shards[shardIdx];
+
+        std::lock_guard<descriptor_table_utils::MutexType> lock(shard.mutex);
+
+        Slot *pSlot = findSlot(descriptor);
+        if (!pSlot)
+            return false;
+
+        std::uint32_t generation = ((std::uint32_t)descriptor>>indexBits);
+        generation = generation==generationMask ? 1 : generation+1;
+
+        pSlot->state.store(generation<<1, std::memory_order_release);
+
+        if (pReleasedInfo)
+            *pReleasedInfo = pSlot->info;
+
+        // В конец списка свободных - слот переиспользуется как можно позже (см. описание поколений выше)
+        pSlot->info     = InfoType();
+        pSlot->nextFree = noSlot;
+        if (shard.freeTail==noSlot)
+            shard.freeHead = localIdx;
+        else
+            shard.getSlot(shard.freeTail, std::memory_order_relaxed)->nextFree = localIdx;
+        shard.freeTail  = localIdx;
+
+        --shard.numUsed;
+
+        return true;
+    }
+
+    //! Число открытых дескрипторов
+    std::size_t size() const
+    {
+        std::size_t numUsed = 0;
+        for(auto &shard : m_shards)
+        {
+            std::lock_guard<descriptor_table_utils::MutexType> lock(shard.mutex);
+            numUsed += shard.numUsed;
+        }
+        return numUsed;
+    }
+
+}; // class DescriptorTable
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
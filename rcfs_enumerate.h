@@ -7,6 +7,8 @@
 #include <exception>
 #include <stdexcept>
 #include <filesystem>
+#include <algorithm>
+#include <iterator>
 
 #include "rcfs_flags.h"
 #include "rcfs.h"
@@ -109,6 +111,49 @@ std::vector<FileInfo> enumerateDirectoryItems( const std::string &dirPath )
     return info;
 }
 
+namespace enumerate_utils {
+
+//! Передаёт обработчику элементы каталога [it, itEnd), имена подкаталогов собирает в subDirs. false - обработчик прервал перебор
+template<typename Iterator, typename GetName, typename ItemHandler> inline
+bool handleItems( Iterator it, Iterator itEnd, GetName getName, const std::string &dirPath, ItemHandler &handler
+                , bool recurse, std::vector<std::string> &subDirs
+                )
+{
+    #if defined(MARTY_RCFS_ORDERED)
+    // Элементы каталога хранятся в порядке добавления, при отладке выдаём их отсортированными
+    using ItemType = typename std::iterator_traits<Iterator>::value_type;
+    std::vector<ItemType> sortedItems(it, itEnd);
+    std::sort( sortedItems.begin(), sortedItems.end()
+             , [&](const ItemType &i1, const ItemType &i2) { return getName(i1)<getName(i2); }
+             );
+    auto sortedIt    = sortedItems.cbegin();
+    auto sortedItEnd = sortedItems.cend();
+    #else
+    auto sortedIt    = it;
+    auto sortedItEnd = itEnd;
+    #endif
+
+    for(; sortedIt!=sortedItEnd; ++sortedIt)
+    {
+        FileInfo info;
+        info.attrs = sortedIt->pEntry->attrs();
+        info.name  = std::string(getName(*sortedIt));
+        if (!handler(dirPath, info))
+        {
+            return false;
+        }
+
+        if (recurse && (info.attrs&FileAttrs::FlagDirectory)!=0)
+        {
+            subDirs.emplace_back(info.name);
+        }
+    }
+
+    return true;
+}
+
+} // namespace enumerate_utils
+
 template<typename ItemHandler> inline
 bool enumerateDirectoryItems( ResourceFileSystem *pRcfs, const std::string &dirPath, ItemHandler handler, bool recurse=false )
 {
@@ -117,24 +162,40 @@ bool enumerateDirectoryItems( ResourceFileSystem *pRcfs, const std::string &dirP
 
     std::vector<std::string > subDirs;
 
-    DirectoryEntry* pde = pRcfs->findDirectoryEntry(dirPath);
-    if (!pde)
-        return false;
+    bool handled = false;
 
-    auto it = pde->itemsBegin();
-    for(; it!=pde->itemsEnd(); ++it)
+    #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+    // Запечатанная ФС: элементы каталога - непрерывный диапазон записей плоского индекса, дерево не обходим
+    const FlatIndex::Record *pRecBegin = 0, *pRecEnd = 0;
+    if (pRcfs->findFlatIndexChildren(dirPath, pRecBegin, pRecEnd))
     {
-        FileInfo info;
-        info.attrs = it->second.attrs();
-        info.name  = it->first;
-        if (!handler(dirPath, info))
+        const FlatIndex *pFlatIndex = pRcfs->getFlatIndex();
+        if (!enumerate_utils::handleItems( pRecBegin, pRecEnd
+                                         , [&](const FlatIndex::Record &rec) { return pFlatIndex->getRecordName(rec); }
+                                         , dirPath, handler, recurse, subDirs
+                                         )
+           )
         {
             return true;
         }
 
-        if (recurse && (info.attrs&FileAttrs::FlagDirectory)!=0)
+        handled = true;
+    }
+    #endif
+
+    if (!handled)
+    {
+        DirectoryEntry* pde = pRcfs->findDirectoryEntry(dirPath);
+        if (!pde)
+            return false;
+
+        if (!enumerate_utils::handleItems( pde->itemsBegin(), pde->itemsEnd()
+                                         , [](const DirectoryEntryChild &child) { return child.name.str(); }
+                                         , dirPath, handler, recurse, subDirs
+                                         )
+           )
         {
-            subDirs.emplace_back(info.name);
+            return true;
         }
     }
 
@@ -0,0 +1,423 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Встроенные декодеры данных файлов: XOR, LZ и цепочки кодеков (с контейнерами кусков)
+
+    Подключается отдельно от rcfs.h - там только интерфейс декодера (i_file_decoder.h):
+
+        #include "rcfs.h"
+        #include "rcfs_file_decoders.h"
+
+        marty_rcfs::DirectoryEntry     root; // Корень не принадлежит ResourceFileSystem и должен её пережить
+        marty_rcfs::ResourceFileSystem rcfs(false, &root, marty_rcfs::getDefaultCodecChainFileDecoder());
+
+    XorFileDecoder заменяет декодер из MARTY_RCFS_IMPLEMENT_XOR_DECRYPT_FILE_DECODER (i_file_decoder.h):
+    данные, подготовленные утилитами _2c, декодируются так же, как _2c::xorDecrypt
+    (сверка - tests/test_xor_decode.cpp), но сразу в приёмник и без _2c.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "i_file_decoder.h"
+#include "rcfs_xor_decode.h"
+#include "rcfs_lz_codec.h"
+#include "rcfs_codec_chain.h"
+#include "rcfs_chunked.h"
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Встроенный XOR-декодер (см. rcfs_xor_decode.h) - декодирует сразу в decodedData, без промежуточной копии
+/*! Ёмкость decodedData переиспользуется. Умеет декодировать диапазоны.
+ */
+struct XorFileDecoder : public IFileDecoder
+                      , public IRangeFileDecoder
+{
+    virtual ~XorFileDecoder() {}
+    virtual
+    bool decodeFileData( std::vector<std::uint8_t> &decodedData
+                       , const std::uint8_t *pFileData
+                       , std::size_t          fileSize
+                       , unsigned decryptKeySize
+                       , unsigned decryptKeySeed
+                       , unsigned decryptKeyInc
+                       ) const override
+    {
+        if (decryptKeySize==0)
+            return false; // Декодирование не требуется
+
+        if (decryptKeySize!=1 && decryptKeySize!=2 && decryptKeySize!=4)
+            throw std::runtime_error("XorFileDecoder::decodeFileData: invalid decryptKeySize");
+
+        decodedData.resize(fileSize);
+        return xorDecodeData(decodedData.data(), pFileData, fileSize, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    virtual
+    bool decodeFileDataTo( std::uint8_t        *pDst
+                         , std::size_t          dstSize
+                         , const std::uint8_t  *pFileData
+                         , std::size_t          fileSize
+                         , unsigned codecChain
+                         , unsigned decryptKeySize
+                         , unsigned decryptKeySeed
+                         , unsigned decryptKeyInc
+                         ) const override
+    {
+        if (codecChain!=codecChainDefault)
+            return IFileDecoder::decodeFileDataTo(pDst, dstSize, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc);
+
+        if (decryptKeySize==0)
+            return false; // Декодирование не требуется
+
+        if (decryptKeySize!=1 && decryptKeySize!=2 && decryptKeySize!=4)
+            throw std::runtime_error("XorFileDecoder::decodeFileDataTo: invalid decryptKeySize");
+
+        if (dstSize!=fileSize)
+            throw std::runtime_error("XorFileDecoder::decodeFileDataTo: decoded size mismatch");
+
+        return xorDecodeData(pDst, pFileData, fileSize, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    virtual
+    const IRangeFileDecoder* getRangeDecoder() const override
+    {
+        return this;
+    }
+
+    //! XOR не меняет размер
+    virtual
+    std::size_t getDecodedSize( const std::uint8_t *pFileData
+                              , std::size_t          fileSize
+                              , unsigned decryptKeySize
+                              , unsigned decryptKeySeed
+                              , unsigned decryptKeyInc
+                              ) const override
+    {
+        MARTY_ARG_USED(pFileData);
+        MARTY_ARG_USED(decryptKeySize);
+        MARTY_ARG_USED(decryptKeySeed);
+        MARTY_ARG_USED(decryptKeyInc );
+
+        return fileSize;
+    }
+
+    virtual
+    bool canDecodeRange( unsigned decryptKeySize
+                       , unsigned decryptKeySeed
+                       , unsigned decryptKeyInc
+                       ) const override
+    {
+        MARTY_ARG_USED(decryptKeySeed);
+        MARTY_ARG_USED(decryptKeyInc );
+
+        return decryptKeySize==1 || decryptKeySize==2 || decryptKeySize==4;
+    }
+
+    virtual
+    bool decodeFileDataRange( std::uint8_t        *pDst
+                            , const std::uint8_t  *pFileData
+                            , std::size_t          fileSize
+                            , std::size_t          offset
+                            , std::size_t          size
+                            , unsigned decryptKeySize
+                            , unsigned decryptKeySeed
+                            , unsigned decryptKeyInc
+                            ) const override
+    {
+        if (offset>fileSize || size>fileSize-offset)
+            return false;
+
+        return xorDecodeData(pDst, pFileData+offset, size, decryptKeySize, decryptKeySeed, decryptKeyInc, offset);
+    }
+};
+
+//----------------------------------------------------------------------------
+inline
+IFileDecoder* getDefaultXorFileDecoder()
+{
+    static XorFileDecoder decoder;
+    return &decoder;
+}
+
+//----------------------------------------------------------------------------
+//! Встроенный декодер цепочек кодеков (XOR, LZ и XOR -> LZ за один проход, см. rcfs_codec_chain.h)
+/*! Файлы без цепочки (codecChainDefault) декодируются как XorFileDecoder - по decryptKeySize.
+    Диапазоны декодируются для файлов без цепочки, с цепочкой codecChainXor и для контейнеров
+    кусков (rcfs_chunked.h) - у них декодируются только куски, покрывающие диапазон.
+    Контейнер кусков целиком декодируется в chunkedDecodeThreads потоков.
+ */
+struct CodecChainFileDecoder : public XorFileDecoder
+{
+    unsigned m_chunkedDecodeThreads;
+
+    explicit CodecChainFileDecoder(unsigned chunkedDecodeThreads = 1)
+    : m_chunkedDecodeThreads(chunkedDecodeThreads)
+    {}
+
+    virtual ~CodecChainFileDecoder() {}
+
+    virtual
+    bool decodeFileDataChain( std::vector<std::uint8_t> &decodedData
+                            , const std::uint8_t *pFileData
+                            , std::size_t          fileSize
+                            , unsigned codecChain
+                            , unsigned decryptKeySize
+                            , unsigned decryptKeySeed
+                            , unsigned decryptKeyInc
+                            ) const override
+    {
+        if (codecChain==codecChainDefault)
+            return decodeFileData(decodedData, pFileData, fileSize, decryptKeySize, decryptKeySeed, decryptKeyInc);
+
+        if (isChunkedCodecChain(codecChain))
+        {
+            if (!decodeChunkedData(decodedData, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, m_chunkedDecodeThreads))
+                throw std::runtime_error("CodecChainFileDecoder::decodeFileDataChain: corrupted chunked data");
+            return true;
+        }
+
+        return decodeCodecChain(decodedData, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    //! Xor, Lz, Xor -> Lz и контейнеры кусков декодируются сразу в pDst
+    virtual
+    bool decodeFileDataTo( std::uint8_t        *pDst
+                         , std::size_t          dstSize
+                         , const std::uint8_t  *pFileData
+                         , std::size_t          fileSize
+                         , unsigned codecChain
+                         , unsigned decryptKeySize
+                         , unsigned decryptKeySeed
+                         , unsigned decryptKeyInc
+                         ) const override
+    {
+        if (codecChain==codecChainDefault)
+            return XorFileDecoder::decodeFileDataTo(pDst, dstSize, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc);
+
+        if (isChunkedCodecChain(codecChain))
+        {
+            if (!decodeChunkedData(pDst, dstSize, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc, m_chunkedDecodeThreads))
+                throw std::runtime_error("CodecChainFileDecoder::decodeFileDataTo: corrupted chunked data or decoded size mismatch");
+            return true;
+        }
+
+        if (!decodeCodecChainTo(pDst, dstSize, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc))
+            throw std::runtime_error("CodecChainFileDecoder::decodeFileDataTo: corrupted data or decoded size mismatch");
+
+        return true;
+    }
+
+    virtual
+    std::size_t getDecodedSizeChain( const std::uint8_t *pFileData
+                                   , std::size_t          fileSize
+                                   , unsigned codecChain
+                                   , unsigned decryptKeySize
+                                   , unsigned decryptKeySeed
+                                   , unsigned decryptKeyInc
+                                   ) const override
+    {
+        if (isChunkedCodecChain(codecChain))
+            return chunkedGetDecodedSize(pFileData, fileSize);
+
+        return getCodecChainDecodedSize(pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    virtual
+    bool canDecodeRangeChain( unsigned codecChain
+                            , unsigned decryptKeySize
+                            , unsigned decryptKeySeed
+                            , unsigned decryptKeyInc
+                            ) const override
+    {
+        if (!isChunkedCodecChain(codecChain))
+            return XorFileDecoder::canDecodeRangeChain(codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc);
+
+        // Куски декодируются только известными стадиями
+        const unsigned chunkCodecChain = getChunkCodecChain(codecChain);
+        for(unsigned stageIdx=0; stageIdx!=codec_chain_utils::getNumStages(chunkCodecChain); ++stageIdx)
+        {
+            const CodecStage stage = codec_chain_utils::getStage(chunkCodecChain, stageIdx);
+            if (stage==CodecStage::Xor && !codec_chain_utils::isValidXorKeySize(decryptKeySize))
+                return false;
+            if (stage!=CodecStage::Xor && stage!=CodecStage::Lz)
+                return false;
+        }
+
+        return true;
+    }
+
+    virtual
+    bool decodeFileDataRangeChain( std::uint8_t        *pDst
+                                 , const std::uint8_t  *pFileData
+                                 , std::size_t          fileSize
+                                 , unsigned             codecChain
+                                 , std::size_t          offset
+                                 , std::size_t          size
+                                 , unsigned decryptKeySize
+                                 , unsigned decryptKeySeed
+                                 , unsigned decryptKeyInc
+                                 ) const override
+    {
+        return decodeFileDataRangeState(0, pDst, pFileData, fileSize, codecChain, offset, size, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+    //! Открытому контейнеру кусков - кэш последнего декодированного куска
+    virtual
+    IRangeDecodeState* createRangeDecodeState(unsigned codecChain) const override
+    {
+        if (!isChunkedCodecChain(codecChain))
+            return 0;
+
+        return new ChunkedRangeDecodeState();
+    }
+
+    virtual
+    bool decodeFileDataRangeState( IRangeDecodeState   *pState
+                                 , std::uint8_t        *pDst
+                                 , const std::uint8_t  *pFileData
+                                 , std::size_t          fileSize
+                                 , unsigned             codecChain
+                                 , std::size_t          offset
+                                 , std::size_t          size
+                                 , unsigned decryptKeySize
+                                 , unsigned decryptKeySeed
+                                 , unsigned decryptKeyInc
+                                 ) const override
+    {
+        if (isChunkedCodecChain(codecChain))
+        {
+            ChunkedRangeDecodeState *pChunkedState = static_cast<ChunkedRangeDecodeState*>(pState);
+            return decodeChunkedRange( pDst, pFileData, fileSize, codecChain, offset, size, decryptKeySize, decryptKeySeed, decryptKeyInc
+                                     , pChunkedState ? &pChunkedState->cache : 0
+                                     );
+        }
+
+        return decodeFileDataRange(pDst, pFileData, fileSize, offset, size, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+
+protected:
+
+    struct ChunkedRangeDecodeState : public IRangeDecodeState
+    {
+        chunked_utils::ChunkCache   cache;
+    };
+};
+
+//----------------------------------------------------------------------------
+inline
+IFileDecoder* getDefaultCodecChainFileDecoder()
+{
+    static CodecChainFileDecoder decoder;
+    return &decoder;
+}
+
+//----------------------------------------------------------------------------
+//! Встроенный LZ-декодер (см. rcfs_lz_codec.h) - распаковывает данные, сжатые lzCompress
+/*! Данные без заголовка RCLZ не декодируются (decodeFileData возвращает false) -
+    несжатые и сжатые файлы можно смешивать в одной ФС. Размер распакованных
+    данных берётся из заголовка без распаковки. Зашифрованные (decryptKeySize!=0)
+    данные этот декодер не поддерживает.
+ */
+struct LzFileDecoder : public IFileDecoder
+{
+    virtual ~LzFileDecoder() {}
+    virtual
+    bool decodeFileData( std::vector<std::uint8_t> &decodedData
+                       , const std::uint8_t *pFileData
+                       , std::size_t          fileSize
+                       , unsigned decryptKeySize
+                       , unsigned decryptKeySeed
+                       , unsigned decryptKeyInc
+                       ) const override
+    {
+        MARTY_ARG_USED(decryptKeySeed);
+        MARTY_ARG_USED(decryptKeyInc );
+
+        if (decryptKeySize!=0)
+            throw std::runtime_error("LzFileDecoder::decodeFileData: encrypted data is not supported");
+
+        if (!lzIsCompressed(pFileData, fileSize))
+            return false; // Декодирование не требуется
+
+        if (!lzDecompress(decodedData, pFileData, fileSize))
+            throw std::runtime_error("LzFileDecoder::decodeFileData: corrupted compressed data");
+
+        return true;
+    }
+
+    virtual
+    bool decodeFileDataTo( std::uint8_t        *pDst
+                         , std::size_t          dstSize
+                         , const std::uint8_t  *pFileData
+                         , std::size_t          fileSize
+                         , unsigned codecChain
+                         , unsigned decryptKeySize
+                         , unsigned decryptKeySeed
+                         , unsigned decryptKeyInc
+                         ) const override
+    {
+        if (codecChain!=codecChainDefault)
+            return IFileDecoder::decodeFileDataTo(pDst, dstSize, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc);
+
+        if (decryptKeySize!=0)
+            throw std::runtime_error("LzFileDecoder::decodeFileDataTo: encrypted data is not supported");
+
+        if (!lzIsCompressed(pFileData, fileSize))
+            return false; // Декодирование не требуется
+
+        if (!decodeCodecChainTo(pDst, dstSize, pFileData, fileSize, codecChainLz, 0, 0, 0))
+            throw std::runtime_error("LzFileDecoder::decodeFileDataTo: corrupted compressed data or decoded size mismatch");
+
+        return true;
+    }
+
+    //! Размер из заголовка RCLZ
+    virtual
+    std::size_t getDecodedSize( const std::uint8_t *pFileData
+                              , std::size_t          fileSize
+                              , unsigned decryptKeySize
+                              , unsigned decryptKeySeed
+                              , unsigned decryptKeyInc
+                              ) const override
+    {
+        MARTY_ARG_USED(decryptKeySeed);
+        MARTY_ARG_USED(decryptKeyInc );
+
+        if (decryptKeySize!=0)
+            return (std::size_t)-1;
+
+        if (!lzIsCompressed(pFileData, fileSize))
+            return fileSize;
+
+        return lzGetDecompressedSize(pFileData, fileSize);
+    }
+};
+
+//----------------------------------------------------------------------------
+inline
+IFileDecoder* getDefaultLzFileDecoder()
+{
+    static LzFileDecoder decoder;
+    return &decoder;
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
@@ -0,0 +1,299 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Плоский неизменяемый индекс RCFS, строится при запечатывании (ResourceFileSystem::seal)
+
+    Вместо прохода по дереву мап (по одному поиску на каждый компонент пути)
+    поиск по полному пути - это один хэш и, как правило, одна проба в open addressing таблице.
+    Содержимое каждого каталога - непрерывный диапазон записей, по нему идёт перечисление
+    запечатанной ФС (rcfs_enumerate.h).
+*/
+
+//----------------------------------------------------------------------------
+
+#include "directory_entry.h"
+#include "rcfs_path.h"
+#include "rcfs_normalize.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Статистика построения плоского индекса
+struct FlatIndexStats
+{
+    std::size_t      numEntries   = 0; //!< Количество записей (файлы и каталоги, без корня)
+    std::size_t      numSlots     = 0; //!< Размер хэш-таблицы
+    std::size_t      memoryBytes  = 0; //!< Память, занимаемая индексом
+    std::uint64_t    buildTimeUs  = 0; //!< Время построения, микросекунды
+};
+
+//----------------------------------------------------------------------------
+class FlatIndex
+{
+
+public:
+
+    //! Запись индекса. Дочерние записи каталога лежат в массиве записей непрерывным диапазоном [childFirst, childFirst+childCount)
+    struct Record
+    {
+        std::uint64_t    hash       = 0;
+        DirectoryEntry  *pEntry     = 0;
+        std::uint32_t    pathOffset = 0;
+        std::uint32_t    pathLen    = 0;
+        std::uint32_t    childFirst = 0;
+        std::uint32_t    childCount = 0;
+    };
+
+    static constexpr std::uint64_t hashBasis = 14695981039346656037ull; // FNV-1a 64
+    static constexpr std::uint64_t hashPrime = 1099511628211ull;
+
+protected:
+
+    std::vector<Record>          m_records;
+    std::vector<std::uint32_t>   m_slots;          //!< Индекс записи + 1, 0 - пустой слот
+    std::string                  m_pathPool;       //!< Все полные пути подряд, без разделителей между ними
+    std::uint32_t                m_rootChildCount = 0; //!< Дочерние записи корня - это [0, m_rootChildCount)
+    FlatIndexStats               m_stats;
+
+
+    // Хэш без учёта регистра ASCII - так нормализованный путь не нужен, подходят сырые компоненты
+
+    static std::uint64_t hashAppend(std::uint64_t h, std::string_view str)
+    {
+        for(auto ch : str)
+        {
+            h ^= (std::uint64_t)(unsigned char)asciiToLower(ch);
+            h *= hashPrime;
+        }
+        return h;
+    }
+
+    static std::uint64_t hashAppend(std::uint64_t h, char ch)
+    {
+        h ^= (std::uint64_t)(unsigned char)asciiToLower(ch);
+        h *= hashPrime;
+        return h;
+    }
+
+    static bool pathEquals(std::string_view path, const PathPartsView &parts, bool caseSens)
+    {
+        std::size_t pos = 0;
+
+        for(std::size_t i=0; i!=parts.size(); ++i)
+        {
+            if (i)
+            {
+                if (pos>=path.size() || path[pos]!='/')
+                    return false;
+                ++pos;
+            }
+
+            const std::string_view &part = parts[i];
+            if (path.size()-pos<part.size())
+                return false;
+
+            if (caseSens)
+            {
+                if (path.compare(pos, part.size(), part)!=0)
+                    return false;
+            }
+            else
+            {
+                if (!equalFolded(path.substr(pos, part.size()), part))
+                    return false;
+            }
+
+            pos += part.size();
+        }
+
+        return pos==path.size();
+    }
+
+    void appendChildren(const DirectoryEntry *pDir, std::string_view parentPath)
+    {
+        auto it = pDir->itemsBegin();
+        for(; it!=pDir->itemsEnd(); ++it)
+        {
+            Record rec;
+            rec.pEntry     = it->pEntry;
+            rec.pathOffset = (std::uint32_t)m_pathPool.size();
+
+            std::uint64_t h = hashBasis;
+            if (!parentPath.empty())
+            {
+                h = hashAppend(h, parentPath);
+                h = hashAppend(h, '/');
+                m_pathPool.append(parentPath.data(), parentPath.size());
+                m_pathPool.append(1, '/');
+            }
+
+            rec.hash = hashAppend(h, it->name.str());
+            m_pathPool.append(it->name.str().data(), it->name.size());
+            rec.pathLen = (std::uint32_t)(m_pathPool.size()-rec.pathOffset);
+
+            m_records.emplace_back(rec);
+        }
+    }
+
+    void insertSlot(std::uint32_t recIdx)
+    {
+        const std::size_t mask = m_slots.size()-1;
+        std::size_t slotIdx = (std::size_t)m_records[recIdx].hash & mask;
+        while(m_slots[slotIdx]!=0)
+            slotIdx = (slotIdx+1) & mask;
+        m_slots[slotIdx] = recIdx+1;
+    }
+
+
+public:
+
+    static std::uint64_t hashPath(const PathPartsView &parts)
+    {
+        std::uint64_t h = hashBasis;
+        for(std::size_t i=0; i!=parts.size(); ++i)
+        {
+            if (i)
+                h = hashAppend(h, '/');
+            h = hashAppend(h, parts[i]);
+        }
+        return h;
+    }
+
+    //! Строит индекс по дереву каталогов. Дерево после этого меняться не должно
+    void build(const DirectoryEntry *pRoot)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+
+        m_records.clear();
+        m_slots.clear();
+        m_pathPool.clear();
+
+        // Обход в ширину - дочерние записи каждого каталога добавляются подряд
+        appendChildren(pRoot, std::string_view());
+        m_rootChildCount = (std::uint32_t)m_records.size();
+
+        for(std::size_t recIdx=0; recIdx!=m_records.size(); ++recIdx)
+        {
+            if (!m_records[recIdx].pEntry->isDirectoryEntry())
+                continue;
+
+            std::size_t childFirst = m_records.size();
+
+            // Путь копируем - m_pathPool может переаллоцироваться
+            std::string parentPath = std::string(getRecordPath(m_records[recIdx]));
+            appendChildren(m_records[recIdx].pEntry, parentPath);
+
+            m_records[recIdx].childFirst = (std::uint32_t)childFirst;
+            m_records[recIdx].childCount = (std::uint32_t)(m_records.size()-childFirst);
+        }
+
+        // Заполнение таблицы не больше 50%
+        std::size_t numSlots = 16;
+        while(numSlots<m_records.size()*2)
+            numSlots *= 2;
+
+        m_slots.assign(numSlots, 0);
+        for(std::size_t recIdx=0; recIdx!=m_records.size(); ++recIdx)
+            insertSlot((std::uint32_t)recIdx);
+
+        m_records.shrink_to_fit();
+        m_pathPool.shrink_to_fit();
+
+        m_stats.numEntries  = m_records.size();
+        m_stats.numSlots    = m_slots.size();
+        m_stats.memoryBytes = sizeof(*this)
+                            + m_records.capacity()*sizeof(Record)
+                            + m_slots.capacity()*sizeof(std::uint32_t)
+                            + m_pathPool.capacity();
+        m_stats.buildTimeUs = (std::uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-startTime).count();
+    }
+
+    const FlatIndexStats& getStats() const { return m_stats; }
+
+    std::string_view getRecordPath(const Record &rec) const
+    {
+        return std::string_view(m_pathPool.data()+rec.pathOffset, rec.pathLen);
+    }
+
+    //! Имя записи - последний компонент её полного пути
+    std::string_view getRecordName(const Record &rec) const
+    {
+        std::string_view path = getRecordPath(rec);
+        const std::size_t sepPos = path.rfind('/');
+        return sepPos==path.npos ? path : path.substr(sepPos+1);
+    }
+
+    //! Ищет запись по компонентам пути. Для пустого пути (корень) возвращает 0
+    const Record* findRecord(const PathPartsView &parts, bool caseSens) const
+    {
+        if (parts.empty() || m_slots.empty())
+            return 0;
+
+        const std::uint64_t h    = hashPath(parts);
+        const std::size_t   mask = m_slots.size()-1;
+        std::size_t slotIdx = (std::size_t)h & mask;
+
+        for(; m_slots[slotIdx]!=0; slotIdx=(slotIdx+1)&mask)
+        {
+            const Record &rec = m_records[m_slots[slotIdx]-1];
+            if (rec.hash==h && pathEquals(getRecordPath(rec), parts, caseSens))
+                return &rec;
+        }
+
+        return 0;
+    }
+
+    //! Дочерние записи каталога - диапазон [pBegin, pEnd) в массиве записей. Пустой путь - корень. false - каталог не найден
+    bool findChildren(const PathPartsView &parts, bool caseSens, const Record *&pBegin, const Record *&pEnd) const
+    {
+        std::uint32_t childFirst = 0, childCount = m_rootChildCount;
+
+        if (!parts.empty())
+        {
+            const Record *pRec = findRecord(parts, caseSens);
+            if (!pRec || !pRec->pEntry->isDirectoryEntry())
+                return false;
+
+            childFirst = pRec->childFirst;
+            childCount = pRec->childCount;
+        }
+
+        pBegin = m_records.data()+childFirst;
+        pEnd   = pBegin+childCount;
+        return true;
+    }
+
+    DirectoryEntry* find(const PathPartsView &parts, bool findDirectory, bool caseSens) const
+    {
+        const Record *pRec = findRecord(parts, caseSens);
+        if (!pRec)
+            return 0;
+
+        if (pRec->pEntry->isDirectoryEntry()!=findDirectory)
+            return 0;
+
+        return pRec->pEntry;
+    }
+
+}; // class FlatIndex
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
@@ -55,6 +55,33 @@ do
 
 
 
+// filename - std::string or char*
+// codecChain - see rcfs_codec_chain.h (data encoded with encodeCodecChain)
+#define MARTY_RCFS_ADD_FILE_ARRAY_CODEC_CHAIN_EX(pRcfs, fileName, fileDataPtr, fileDataSize, codecChain, xorSize, xorSeed, xorInc)       \
+                                                                                                                                         \
+do                                                                                                                                       \
+{                                                                                                                                        \
+    bool fsRes = (pRcfs)->createFile( fileName, true /* createPath */, true /* failOnExist */ );                                         \
+    if (!fsRes)                                                                                                                          \
+        throw std::runtime_error("RCFS::createFile: failed to create file '" #fileDataPtr "': file already exist?" );                    \
+                                                                                                                                         \
+    fsRes = (pRcfs)->setFileData( fileName, (const std::uint8_t*)(fileDataPtr), (std::size_t)(fileDataSize), xorSize, xorSeed, xorInc, codecChain); \
+    if (!fsRes)                                                                                                                          \
+        throw std::runtime_error("RCFS::setFileData: failed to set file data for file '" #fileDataPtr "': something goes wrong" );       \
+                                                                                                                                         \
+} while(0)
+
+
+// filename must be  char* only
+// data must be array only
+#define MARTY_RCFS_ADD_FILE_ARRAY_CODEC_CHAIN_SIMPLE(pRcfs, fileDataArrayName )                                                         \
+    MARTY_RCFS_ADD_FILE_ARRAY_CODEC_CHAIN_EX(pRcfs, fileDataArrayName##_filename, fileDataArrayName, fileDataArrayName##_size            \
+                                                  , fileDataArrayName##_codec_chain                                                      \
+                                                  , fileDataArrayName##_xor_size, fileDataArrayName##_xor_seed, fileDataArrayName##_xor_inc)
+
+
+
+
 // #define MARTY_RCFS_ADD_FILE_ARRAY(pRcfs, fileDataArrayName) \
 //         MARTY_RCFS_ADD_FILE_ARRAY_EX(pRcfs, fileDataArrayName, (sizeof(fileDataArrayName)/sizeof(fileDataArrayName[0])) )
 //
@@ -0,0 +1,180 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Таблица интернированных имён компонентов путей
+
+    Каждое различное имя хранится в таблице ровно один раз. Имена
+    сравниваются по указателю. Поиск по дереву сначала один раз
+    пробует таблицу, а дальше сравнивает только указатели. Если имени
+    нет в таблице, то его нет и в дереве.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "rcfs_arena.h"
+#include "rcfs_normalize.h"
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Интернированное имя - указатель на единственную копию строки в таблице
+/*! Память: [uint32 hash][uint32 size][символы]. Хэш - foldCaseHash, то есть не зависит от регистра ASCII.
+ */
+class InternedName
+{
+    const char *m_p = 0;
+
+public:
+
+    static const std::size_t headerSize = 2*sizeof(std::uint32_t);
+
+    InternedName() {}
+    explicit InternedName(const char *p) : m_p(p) {}
+
+    bool empty() const { return m_p==0; }
+
+    std::uint32_t hash() const
+    {
+        std::uint32_t h;
+        std::memcpy(&h, m_p, sizeof(h));
+        return h;
+    }
+
+    std::size_t size() const
+    {
+        std::uint32_t sz;
+        std::memcpy(&sz, m_p+sizeof(std::uint32_t), sizeof(sz));
+        return sz;
+    }
+
+    std::string_view str() const
+    {
+        if (!m_p)
+            return std::string_view();
+        return std::string_view(m_p+headerSize, size());
+    }
+
+    const char* rawPtr() const { return m_p; }
+
+    bool operator==(InternedName other) const { return m_p==other.m_p; }
+    bool operator!=(InternedName other) const { return m_p!=other.m_p; }
+
+}; // class InternedName
+
+//----------------------------------------------------------------------------
+//! Таблица интернированных имён - open addressing, линейное пробирование, заполнение не выше 50%
+class NameInternTable
+{
+    ArenaStringPool                 m_pool ;
+    std::vector<const char*>        m_slots;
+    std::size_t                     m_size = 0;
+
+    static std::uint32_t hashName(std::string_view name) { return (std::uint32_t)foldCaseHash(name); }
+
+    void insertSlot(const char *p, std::uint32_t h)
+    {
+        const std::size_t mask = m_slots.size()-1;
+        std::size_t slotIdx = h & mask;
+        while(m_slots[slotIdx])
+            slotIdx = (slotIdx+1) & mask;
+        m_slots[slotIdx] = p;
+    }
+
+    void grow()
+    {
+        std::vector<const char*> oldSlots(m_slots.empty() ? 64 : m_slots.size()*2, (const char*)0);
+        std::swap(oldSlots, m_slots);
+
+        for(const char *p : oldSlots)
+        {
+            if (p)
+                insertSlot(p, InternedName(p).hash());
+        }
+    }
+
+    template<typename Equal>
+    InternedName findImpl(std::string_view name, std::uint32_t h, Equal equal) const
+    {
+        if (m_slots.empty())
+            return InternedName();
+
+        const std::size_t mask = m_slots.size()-1;
+        for(std::size_t slotIdx=h&mask; m_slots[slotIdx]; slotIdx=(slotIdx+1)&mask)
+        {
+            InternedName interned(m_slots[slotIdx]);
+            if (interned.hash()==h && interned.size()==name.size() && equal(name, interned.str()))
+                return interned;
+        }
+
+        return InternedName();
+    }
+
+public:
+
+    NameInternTable() {}
+
+    NameInternTable(const NameInternTable&) = delete;
+    NameInternTable& operator=(const NameInternTable&) = delete;
+
+    //! Ищет имя побайтно. Пустой результат - такого имени нет
+    InternedName find(std::string_view name) const
+    {
+        return findImpl(name, hashName(name), [](std::string_view a, std::string_view b) { return a==b; });
+    }
+
+    //! Ищет имя без учёта регистра ASCII. Находятся только имена, хранящиеся в нижнем регистре
+    InternedName findNoCase(std::string_view name) const
+    {
+        return findImpl(name, hashName(name), [](std::string_view a, std::string_view b) { return compareFolded(a, b)==0; });
+    }
+
+    //! Возвращает интернированное имя, при необходимости добавляя его в таблицу
+    InternedName intern(std::string_view name)
+    {
+        const std::uint32_t h = hashName(name);
+
+        InternedName interned = findImpl(name, h, [](std::string_view a, std::string_view b) { return a==b; });
+        if (!interned.empty())
+            return interned;
+
+        if ((m_size+1)*2>m_slots.size())
+            grow();
+
+        char *p = m_pool.allocate(InternedName::headerSize+name.size());
+        std::uint32_t sz = (std::uint32_t)name.size();
+        std::memcpy(p, &h, sizeof(h));
+        std::memcpy(p+sizeof(h), &sz, sizeof(sz));
+        if (!name.empty())
+            std::memcpy(p+InternedName::headerSize, name.data(), name.size());
+
+        insertSlot(p, h);
+        ++m_size;
+
+        return InternedName(p);
+    }
+
+    std::size_t size() const { return m_size; }
+    std::size_t bytesReserved() const { return m_pool.bytesReserved() + m_slots.capacity()*sizeof(const char*); }
+
+}; // class NameInternTable
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
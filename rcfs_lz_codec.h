@@ -0,0 +1,614 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Встроенный LZ-кодек данных ресурсов (семейство LZ77, формат последовательностей как у LZ4)
+
+    Формат:
+    - заголовок, 16 байт: "RCLZ", версия (1 байт), 3 резервных байта (0),
+      размер распакованных данных (8 байт, little endian);
+    - последовательности до конца данных. Последовательность: токен (старшие
+      4 бита - число литералов, младшие - длина совпадения минус 4), добавочные
+      байты числа литералов, литералы, смещение совпадения (2 байта, little endian,
+      1..65535), добавочные байты длины совпадения. Значение 15 в поле токена
+      означает, что дальше идут добавочные байты: каждый прибавляет своё значение,
+      байт 255 означает, что будет ещё один.
+    - последняя последовательность содержит только литералы - данные кончаются
+      сразу после них.
+
+    Распаковка проверяет все границы - повреждённые данные дают ошибку, а не
+    выход за буфер. Размер распакованных данных известен из заголовка, поэтому
+    буфер выделяется один раз и распаковка идёт прямо в него.
+
+    Сжатие - жадный поиск по хэш-цепочкам в окне 64 Кб; используется при
+    генерации ресурсов, скорость сжатия не критична. Если сжатие не дало
+    выигрыша, генератору имеет смысл сохранить данные как есть - данные без
+    заголовка "RCLZ" декодер не трогает.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN
+
+    //! Число проверяемых кандидатов при поиске совпадения по умолчанию. 1 - самое быстрое сжатие
+    #define MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN      32
+
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+namespace lz_codec_utils {
+
+const std::size_t       headerSize     = 16;
+const std::uint8_t      formatVersion  = 1;
+const std::size_t       minMatch       = 4;
+const std::size_t       maxOffset      = 65535;
+const unsigned          hashBits       = 16;
+const std::size_t       windowSize     = 65536; //!< Размер таблицы цепочек - степень двойки больше maxOffset
+
+//! Последние байты всегда литералы, и совпадение не начинается ближе к концу - как в LZ4
+const std::size_t       lastLiterals   = 5;
+const std::size_t       matchStartLimit = 12;
+
+inline std::uint32_t read32(const std::uint8_t *p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline std::uint32_t hash4(std::uint32_t v)
+{
+    return (v*2654435761u) >> (32-hashBits);
+}
+
+//! Длина совпадения p1 и p2, p2<p1, не дальше pLimit
+inline std::size_t countMatch(const std::uint8_t *p1, const std::uint8_t *p2, const std::uint8_t *pLimit)
+{
+    const std::uint8_t *pStart = p1;
+
+    while(p1+8<=pLimit)
+    {
+        std::uint64_t a, b;
+        std::memcpy(&a, p1, 8);
+        std::memcpy(&b, p2, 8);
+        if (a!=b)
+        {
+            std::uint64_t diff = a^b; // Little endian - первый различающийся байт в младших битах
+            #if defined(__GNUC__) || defined(__clang__)
+                return (std::size_t)(p1-pStart) + (std::size_t)(__builtin_ctzll(diff)>>3);
+            #else
+                while(!(diff&0xFF)) { diff>>=8; ++p1; }
+                return (std::size_t)(p1-pStart);
+            #endif
+        }
+        p1 += 8;
+        p2 += 8;
+    }
+
+    while(p1<pLimit && *p1==*p2)
+    {
+        ++p1;
+        ++p2;
+    }
+
+    return (std::size_t)(p1-pStart);
+}
+
+//! Записывает добавочные байты длины (len - уже за вычетом 15)
+inline void writeLengthExt(std::vector<std::uint8_t> &out, std::size_t len)
+{
+    for(; len>=255; len-=255)
+        out.push_back(255);
+    out.push_back((std::uint8_t)len);
+}
+
+//! Читает добавочные байты длины. false - данные кончились
+inline bool readLengthExt(const std::uint8_t *&ip, const std::uint8_t *pEnd, std::size_t &len)
+{
+    std::uint8_t b;
+    do
+    {
+        if (ip==pEnd)
+            return false;
+        b = *ip++;
+        len += b;
+    }
+    while(b==255);
+
+    return true;
+}
+
+inline void writeSequence(std::vector<std::uint8_t> &out, const std::uint8_t *pLiterals, std::size_t numLiterals, std::size_t offset, std::size_t matchLen)
+{
+    const std::size_t matchCode = matchLen-minMatch;
+
+    out.push_back((std::uint8_t)(((numLiterals<15 ? numLiterals : 15)<<4) | (matchCode<15 ? matchCode : 15)));
+    if (numLiterals>=15)
+        writeLengthExt(out, numLiterals-15);
+
+    out.insert(out.end(), pLiterals, pLiterals+numLiterals);
+
+    out.push_back((std::uint8_t)(offset));
+    out.push_back((std::uint8_t)(offset>>8));
+
+    if (matchCode>=15)
+        writeLengthExt(out, matchCode-15);
+}
+
+inline void writeLastLiterals(std::vector<std::uint8_t> &out, const std::uint8_t *pLiterals, std::size_t numLiterals)
+{
+    out.push_back((std::uint8_t)((numLiterals<15 ? numLiterals : 15)<<4));
+    if (numLiterals>=15)
+        writeLengthExt(out, numLiterals-15);
+
+    out.insert(out.end(), pLiterals, pLiterals+numLiterals);
+}
+
+//! Запас в конце приёмника, при котором копирование идёт кусками с перезаписью за концом копии
+const std::size_t       wildCopyMargin = 32;
+
+//! Копирование кусками по 8 байт, может записать до 7 байт сверх size. Источник не ближе 8 байт позади приёмника
+inline void wildCopy8(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size)
+{
+    std::uint8_t *pDstEnd = pDst+size;
+    do
+    {
+        std::memcpy(pDst, pSrc, 8);
+        pDst += 8;
+        pSrc += 8;
+    }
+    while(pDst<pDstEnd);
+}
+
+//! Копирование кусками по 16 байт, может записать до 15 байт сверх size. Источник не ближе 16 байт позади приёмника
+inline void wildCopy16(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size)
+{
+    std::uint8_t *pDstEnd = pDst+size;
+    do
+    {
+        std::memcpy(pDst, pSrc, 16);
+        pDst += 16;
+        pSrc += 16;
+    }
+    while(pDst<pDstEnd);
+}
+
+//! Копирование совпадения: источник на offset байт позади приёмника, области могут перекрываться
+inline void copyMatch(std::uint8_t *pDst, std::size_t offset, std::size_t size, const std::uint8_t *pDstLimit)
+{
+    const std::uint8_t *pSrc = pDst-offset;
+
+    if (size+wildCopyMargin<=(std::size_t)(pDstLimit-pDst))
+    {
+        if (offset>=16)
+        {
+            wildCopy16(pDst, pSrc, size);
+            return;
+        }
+
+        if (offset<8)
+        {
+            // Короткий период: первые 8 байт - так, чтобы дальше источник был не ближе 8 байт (как в LZ4)
+            static const unsigned srcInc[8] = { 0, 1, 2, 1, 0, 4, 4, 4 };
+            static const int      srcDec[8] = { 0, 0, 0, -1, -4, 1, 2, 3 };
+
+            pDst[0] = pSrc[0];
+            pDst[1] = pSrc[1];
+            pDst[2] = pSrc[2];
+            pDst[3] = pSrc[3];
+            pSrc += srcInc[offset];
+            std::memcpy(pDst+4, pSrc, 4);
+            pSrc -= srcDec[offset];
+
+            if (size>8)
+                wildCopy8(pDst+8, pSrc, size-8);
+            return;
+        }
+
+        wildCopy8(pDst, pSrc, size);
+        return;
+    }
+
+    // У конца приёмника - точно по байтам, каждый байт берётся уже записанным
+    for(std::size_t i=0; i!=size; ++i)
+        pDst[i] = pSrc[i];
+}
+
+} // namespace lz_codec_utils
+
+//----------------------------------------------------------------------------
+//! Данные начинаются с заголовка RCLZ поддерживаемой версии
+inline
+bool lzIsCompressed(const std::uint8_t *pData, std::size_t size)
+{
+    return size>=lz_codec_utils::headerSize
+        && std::memcmp(pData, "RCLZ", 4)==0
+        && pData[4]==lz_codec_utils::formatVersion;
+}
+
+//----------------------------------------------------------------------------
+//! Размер распакованных данных из заголовка. (std::size_t)-1 - данные не сжаты или размер не помещается в size_t
+inline
+std::size_t lzGetDecompressedSize(const std::uint8_t *pData, std::size_t size)
+{
+    if (!lzIsCompressed(pData, size))
+        return (std::size_t)-1;
+
+    std::uint64_t decompressedSize = 0;
+    for(unsigned i=0; i!=8; ++i)
+        decompressedSize |= (std::uint64_t)pData[8+i] << (i*8);
+
+    if (decompressedSize>=(std::uint64_t)(std::size_t)-1)
+        return (std::size_t)-1;
+
+    return (std::size_t)decompressedSize;
+}
+
+//----------------------------------------------------------------------------
+//! Распаковывает последовательности (данные без заголовка) в pDst ровно dstSize байт. false - данные повреждены
+inline
+bool lzDecompressBlock(std::uint8_t *pDst, std::size_t dstSize, const std::uint8_t *pSrc, std::size_t srcSize)
+{
+    using namespace lz_codec_utils;
+
+    const std::uint8_t *ip   = pSrc;
+    const std::uint8_t *iEnd = pSrc+srcSize;
+    std::uint8_t       *op   = pDst;
+    std::uint8_t       *oEnd = pDst+dstSize;
+
+    while(ip!=iEnd)
+    {
+        const unsigned token = *ip++;
+
+        std::size_t numLiterals = token>>4;
+
+        if (numLiterals!=15 && (std::size_t)(iEnd-ip)>=wildCopyMargin && (std::size_t)(oEnd-op)>=2*wildCopyMargin)
+        {
+            // Частый случай вдали от концов: короткие литералы - одной операцией. Последовательность точно не последняя
+            std::memcpy(op, ip, 16);
+            op += numLiterals;
+            ip += numLiterals;
+        }
+        else
+        {
+            if (numLiterals==15 && !readLengthExt(ip, iEnd, numLiterals))
+                return false;
+
+            if (numLiterals>(std::size_t)(iEnd-ip) || numLiterals>(std::size_t)(oEnd-op))
+                return false;
+
+            if (numLiterals+wildCopyMargin<=(std::size_t)(iEnd-ip) && numLiterals+wildCopyMargin<=(std::size_t)(oEnd-op))
+                wildCopy16(op, ip, numLiterals);
+            else if (numLiterals) // Пустые данные - op может быть нулевым
+                std::memcpy(op, ip, numLiterals);
+
+            op += numLiterals;
+            ip += numLiterals;
+
+            if (ip==iEnd)
+                break; // Последняя последовательность - только литералы
+
+            if (iEnd-ip<2)
+                return false;
+        }
+
+        const std::size_t offset = (std::size_t)ip[0] | ((std::size_t)ip[1]<<8);
+        ip += 2;
+
+        if (!offset || offset>(std::size_t)(op-pDst))
+            return false;
+
+        std::size_t matchLen = token&15;
+
+        if (matchLen!=15 && offset>=8 && (std::size_t)(oEnd-op)>=wildCopyMargin)
+        {
+            // Короткое совпадение (до 18 байт) - тремя операциями, источник не ближе 8 байт
+            const std::uint8_t *pSrc = op-offset;
+            std::memcpy(op   , pSrc   , 8);
+            std::memcpy(op+8 , pSrc+8 , 8);
+            std::memcpy(op+16, pSrc+16, 2);
+            op += matchLen+minMatch;
+            continue;
+        }
+
+        if (matchLen==15 && !readLengthExt(ip, iEnd, matchLen))
+            return false;
+        matchLen += minMatch;
+
+        if (matchLen>(std::size_t)(oEnd-op))
+            return false;
+
+        copyMatch(op, offset, matchLen, oEnd);
+        op += matchLen;
+    }
+
+    return op==oEnd;
+}
+
+//----------------------------------------------------------------------------
+//! Распаковывает последовательности из потокового источника в pDst ровно dstSize байт. false - данные повреждены
+/*! Источник (InputType) даёт данные по мере чтения - так распаковка совмещается
+    с предыдущей стадией декодирования (см. rcfs_codec_chain.h):
+    - bool atEnd() const;
+    - bool readByte(std::uint8_t &b);
+    - bool copyTo(std::uint8_t *pDst, std::size_t size) - false, если данных меньше size;
+    - const std::uint8_t* peek(std::size_t &size) - уже готовые данные, по возможности
+      не меньше lz_codec_utils::wildCopyMargin байт;
+    - void skip(std::size_t size) - пропуск готовых данных.
+    Короткие последовательности разбираются прямо из готовых данных, как в lzDecompressBlock.
+ */
+template<typename InputType>
+bool lzDecompressStream(std::uint8_t *pDst, std::size_t dstSize, InputType &input)
+{
+    using namespace lz_codec_utils;
+
+    std::uint8_t *op   = pDst;
+    std::uint8_t *oEnd = pDst+dstSize;
+
+    auto readLength = [&](std::size_t &len) -> bool
+    {
+        std::uint8_t b;
+        do
+        {
+            if (!input.readByte(b))
+                return false;
+            len += b;
+        }
+        while(b==255);
+
+        return true;
+    };
+
+    while(!input.atEnd())
+    {
+        std::size_t avail = 0;
+        const std::uint8_t *ip = input.peek(avail);
+
+        if (avail>=wildCopyMargin)
+        {
+            // Последовательности, целиком лежащие в готовых данных (с запасом на копирование кусками)
+            const std::uint8_t *ipStart = ip;
+            const std::uint8_t *ipEnd   = ip+avail;
+
+            while((std::size_t)(ipEnd-ip)>=wildCopyMargin && (std::size_t)(oEnd-op)>=wildCopyMargin)
+            {
+                const std::uint8_t *p = ip;
+                const unsigned token = *p++;
+
+                std::size_t numLiterals = token>>4;
+                if (numLiterals==15 && !readLengthExt(p, ipEnd, numLiterals))
+                    break;
+
+                if (numLiterals+wildCopyMargin>(std::size_t)(ipEnd-p) || numLiterals+wildCopyMargin>(std::size_t)(oEnd-op))
+                    break; // В том числе последняя последовательность - за её литералами данных нет
+
+                const std::uint8_t *pLiterals = p;
+                p += numLiterals;
+
+                const std::size_t offset = (std::size_t)p[0] | ((std::size_t)p[1]<<8);
+                p += 2;
+
+                std::size_t matchLen = token&15;
+                if (matchLen==15 && !readLengthExt(p, ipEnd, matchLen))
+                    break;
+                matchLen += minMatch;
+
+                // Последовательность разобрана целиком - выполняем
+                wildCopy16(op, pLiterals, numLiterals);
+                op += numLiterals;
+
+                if (!offset || offset>(std::size_t)(op-pDst) || matchLen>(std::size_t)(oEnd-op))
+                    return false;
+
+                copyMatch(op, offset, matchLen, oEnd);
+                op += matchLen;
+                ip  = p;
+            }
+
+            input.skip((std::size_t)(ip-ipStart));
+
+            if (input.atEnd())
+                break;
+        }
+
+        std::uint8_t token = 0;
+        input.readByte(token);
+
+        std::size_t numLiterals = token>>4;
+        if (numLiterals==15 && !readLength(numLiterals))
+            return false;
+
+        if (numLiterals>(std::size_t)(oEnd-op) || !input.copyTo(op, numLiterals))
+            return false;
+        op += numLiterals;
+
+        if (input.atEnd())
+            break; // Последняя последовательность - только литералы
+
+        std::uint8_t offsetLo, offsetHi;
+        if (!input.readByte(offsetLo) || !input.readByte(offsetHi))
+            return false;
+
+        const std::size_t offset = (std::size_t)offsetLo | ((std::size_t)offsetHi<<8);
+        if (!offset || offset>(std::size_t)(op-pDst))
+            return false;
+
+        std::size_t matchLen = token&15;
+        if (matchLen==15 && !readLength(matchLen))
+            return false;
+        matchLen += minMatch;
+
+        if (matchLen>(std::size_t)(oEnd-op))
+            return false;
+
+        copyMatch(op, offset, matchLen, oEnd);
+        op += matchLen;
+    }
+
+    return op==oEnd;
+}
+
+//----------------------------------------------------------------------------
+//! Распаковывает сжатые данные (с заголовком) в decompressed. false - данные не сжаты или повреждены
+/*! Ёмкость decompressed переиспользуется.
+ */
+inline
+bool lzDecompress(std::vector<std::uint8_t> &decompressed, const std::uint8_t *pData, std::size_t size)
+{
+    const std::size_t decompressedSize = lzGetDecompressedSize(pData, size);
+    if (decompressedSize==(std::size_t)-1)
+        return false;
+
+    // Каждый байт данных дает не больше 255 байт результата - защита от заведомо неверного размера
+    const std::size_t blockSize = size-lz_codec_utils::headerSize;
+    if (decompressedSize/255>blockSize)
+        return false;
+
+    decompressed.resize(decompressedSize);
+    return lzDecompressBlock(decompressed.data(), decompressedSize, pData+lz_codec_utils::headerSize, blockSize);
+}
+
+//----------------------------------------------------------------------------
+//! Сжимает данные, результат (с заголовком) - в compressed
+/*! maxChain - число проверяемых кандидатов при поиске совпадения: больше - лучше сжатие,
+    но медленнее. На скорость распаковки не влияет.
+ */
+inline
+void lzCompress(std::vector<std::uint8_t> &compressed, const std::uint8_t *pData, std::size_t size, unsigned maxChain = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN)
+{
+    using namespace lz_codec_utils;
+
+    compressed.clear();
+    compressed.reserve(headerSize + size + size/255 + 16);
+
+    const std::uint8_t header[8] = { 'R', 'C', 'L', 'Z', formatVersion, 0, 0, 0 };
+    compressed.insert(compressed.end(), header, header+8);
+    for(unsigned i=0; i!=8; ++i)
+        compressed.push_back((std::uint8_t)((std::uint64_t)size >> (i*8)));
+
+    if (!maxChain)
+        maxChain = 1;
+
+    const std::uint8_t *pEnd         = pData+size;
+    const std::uint8_t *pAnchor      = pData; //!< Начало ещё не записанных литералов
+    const std::uint8_t *pMatchLimit  = size>lastLiterals ? pEnd-lastLiterals : pData;
+
+    if (size>=matchStartLimit)
+    {
+        const std::size_t  searchEnd = size-matchStartLimit;
+
+        // Голова цепочки по хэшу и предыдущая позиция с тем же хэшем. Позиции - +1, 0 - пусто
+        std::vector<std::uint32_t> hashHeads(std::size_t(1)<<hashBits, 0);
+        std::vector<std::uint32_t> chainPrev(windowSize, 0);
+
+        std::size_t nextToInsert = 0;
+        auto insertUpTo = [&](std::size_t pos)
+        {
+            for(; nextToInsert<pos; ++nextToInsert)
+            {
+                const std::uint32_t h = hash4(read32(pData+nextToInsert));
+                chainPrev[nextToInsert&(windowSize-1)] = hashHeads[h];
+                hashHeads[h] = (std::uint32_t)(nextToInsert+1);
+            }
+        };
+
+        std::size_t pos = 0;
+        while(pos<=searchEnd)
+        {
+            insertUpTo(pos);
+
+            const std::uint32_t cur = read32(pData+pos);
+            std::size_t bestLen = 0, bestOffset = 0;
+
+            std::uint32_t candidate = hashHeads[hash4(cur)];
+            for(unsigned n=0; candidate && n!=maxChain; ++n)
+            {
+                const std::size_t candPos = candidate-1;
+                if (pos-candPos>maxOffset)
+                    break;
+
+                if (read32(pData+candPos)==cur && pData[candPos+bestLen]==pData[pos+bestLen])
+                {
+                    const std::size_t len = minMatch + countMatch(pData+pos+minMatch, pData+candPos+minMatch, pMatchLimit);
+                    if (len>bestLen)
+                    {
+                        bestLen    = len;
+                        bestOffset = pos-candPos;
+                    }
+                }
+
+                const std::uint32_t prev = chainPrev[candPos&(windowSize-1)];
+                if (prev>=candidate)
+                    break; // Позиция в таблице уже перезаписана более новой
+                candidate = prev;
+            }
+
+            if (bestLen<minMatch)
+            {
+                // Без совпадения шаг растёт - несжимаемые данные проходятся быстро
+                pos += 1 + ((pos-(std::size_t)(pAnchor-pData))>>6);
+                continue;
+            }
+
+            // Продлеваем совпадение назад за счёт литералов
+            while(pos>(std::size_t)(pAnchor-pData) && pos>bestOffset && pData[pos-1]==pData[pos-1-bestOffset])
+            {
+                --pos;
+                ++bestLen;
+            }
+
+            writeSequence(compressed, pAnchor, (std::size_t)(pData+pos-pAnchor), bestOffset, bestLen);
+
+            pos    += bestLen;
+            pAnchor = pData+pos;
+        }
+    }
+
+    writeLastLiterals(compressed, pAnchor, (std::size_t)(pEnd-pAnchor));
+}
+
+//----------------------------------------------------------------------------
+inline
+void lzCompress(std::vector<std::uint8_t> &compressed, const std::vector<std::uint8_t> &data, unsigned maxChain = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN)
+{
+    lzCompress(compressed, data.data(), data.size(), maxChain);
+}
+
+inline
+void lzCompress(std::vector<std::uint8_t> &compressed, const std::vector<char> &data, unsigned maxChain = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN)
+{
+    lzCompress(compressed, (const std::uint8_t*)data.data(), data.size(), maxChain);
+}
+
+inline
+void lzCompress(std::vector<std::uint8_t> &compressed, const std::string &data, unsigned maxChain = MARTY_RCFS_LZ_DEFAULT_MAX_CHAIN)
+{
+    lzCompress(compressed, (const std::uint8_t*)data.data(), data.size(), maxChain);
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
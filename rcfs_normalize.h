@@ -0,0 +1,237 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Нормализация имён RCFS ('\\' -> '/', нижний регистр ASCII) и хэширование без учёта регистра
+
+    Нормализация векторизована (AVX2/SSE2, есть скалярный вариант).
+    Векторный вариант можно запретить макросом MARTY_RCFS_DISABLE_SIMD.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+//----------------------------------------------------------------------------
+#if !defined(MARTY_RCFS_DISABLE_SIMD)
+
+    #if defined(__AVX2__)
+
+        #define MARTY_RCFS_SIMD_AVX2
+        #define MARTY_RCFS_SIMD_SSE2
+
+    #elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+
+        #define MARTY_RCFS_SIMD_SSE2
+
+    #endif
+
+#endif
+
+#if defined(MARTY_RCFS_SIMD_AVX2)
+    #include <immintrin.h>
+#elif defined(MARTY_RCFS_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+constexpr
+char asciiToLower(char ch)
+{
+    if (ch>='A' && ch<='Z')
+        return (char)(ch-'A'+'a');
+
+    return ch;
+}
+
+//----------------------------------------------------------------------------
+namespace normalize_utils {
+
+inline
+void normalizePathSymbolsScalar(char *pDst, const char *pSrc, std::size_t size, bool toLowerCase)
+{
+    for(std::size_t i=0; i!=size; ++i)
+    {
+        char ch = pSrc[i];
+        if (ch=='\\')
+            ch = '/';
+        else if (toLowerCase)
+            ch = asciiToLower(ch);
+        pDst[i] = ch;
+    }
+}
+
+#if defined(MARTY_RCFS_SIMD_SSE2)
+inline
+__m128i normalizePathSymbols16(__m128i v, bool toLowerCase)
+{
+    const __m128i backSlash = _mm_set1_epi8('\\');
+    const __m128i slash     = _mm_set1_epi8('/');
+
+    __m128i isBackSlash = _mm_cmpeq_epi8(v, backSlash);
+    v = _mm_or_si128(_mm_andnot_si128(isBackSlash, v), _mm_and_si128(isBackSlash, slash));
+
+    if (toLowerCase)
+    {
+        // Знаковое сравнение: байты >=0x80 отрицательные и в диапазон 'A'-'Z' не попадают
+        __m128i isUpper = _mm_and_si128( _mm_cmpgt_epi8(v, _mm_set1_epi8('A'-1))
+                                       , _mm_cmpgt_epi8(_mm_set1_epi8('Z'+1), v)
+                                       );
+        v = _mm_or_si128(v, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+    }
+
+    return v;
+}
+#endif
+
+#if defined(MARTY_RCFS_SIMD_AVX2)
+inline
+__m256i normalizePathSymbols32(__m256i v, bool toLowerCase)
+{
+    __m256i isBackSlash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+    v = _mm256_blendv_epi8(v, _mm256_set1_epi8('/'), isBackSlash);
+
+    if (toLowerCase)
+    {
+        __m256i isUpper = _mm256_and_si256( _mm256_cmpgt_epi8(v, _mm256_set1_epi8('A'-1))
+                                          , _mm256_cmpgt_epi8(_mm256_set1_epi8('Z'+1), v)
+                                          );
+        v = _mm256_or_si256(v, _mm256_and_si256(isUpper, _mm256_set1_epi8(0x20)));
+    }
+
+    return v;
+}
+#endif
+
+} // namespace normalize_utils
+
+//----------------------------------------------------------------------------
+//! Заменяет '\\' на '/' и (если toLowerCase) переводит ASCII в нижний регистр. pDst может совпадать с pSrc
+inline
+void normalizePathSymbols(char *pDst, const char *pSrc, std::size_t size, bool toLowerCase)
+{
+    std::size_t pos = 0;
+
+    #if defined(MARTY_RCFS_SIMD_AVX2)
+    for(; pos+32<=size; pos+=32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(pSrc+pos));
+        _mm256_storeu_si256((__m256i*)(pDst+pos), normalize_utils::normalizePathSymbols32(v, toLowerCase));
+    }
+    #endif
+
+    #if defined(MARTY_RCFS_SIMD_SSE2)
+    for(; pos+16<=size; pos+=16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pSrc+pos));
+        _mm_storeu_si128((__m128i*)(pDst+pos), normalize_utils::normalizePathSymbols16(v, toLowerCase));
+    }
+    #endif
+
+    normalize_utils::normalizePathSymbolsScalar(pDst+pos, pSrc+pos, size-pos, toLowerCase);
+}
+
+//----------------------------------------------------------------------------
+//! Переводит в нижний регистр ASCII 8 байт разом (SWAR), байты >=0x80 не трогает
+inline
+std::uint64_t asciiToLower8(std::uint64_t x)
+{
+    const std::uint64_t ones = 0x0101010101010101ull;
+    const std::uint64_t high = 0x8080808080808080ull;
+
+    std::uint64_t low7    = x & ~high;
+    std::uint64_t geA     = low7 + ones*(0x80-'A');
+    std::uint64_t gtZ     = low7 + ones*(0x7F-'Z');
+    std::uint64_t isUpper = (geA ^ gtZ) & ~x & high;
+
+    return x | (isUpper>>2);
+}
+
+//----------------------------------------------------------------------------
+//! Хэш имени без учёта регистра ASCII - одинаков для "Name", "NAME" и "name"
+/*! Обрабатывает по 8 байт за шаг, без копирования и без отдельного перевода в нижний регистр.
+ */
+inline
+std::size_t foldCaseHash(std::string_view name)
+{
+    const std::uint64_t mul = 0x9E3779B97F4A7C15ull;
+
+    std::uint64_t h = 0xCBF29CE484222325ull ^ (std::uint64_t)name.size();
+
+    const char *p = name.data();
+    std::size_t size = name.size();
+
+    for(; size>=8; p+=8, size-=8)
+    {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        h = (h ^ asciiToLower8(w)) * mul;
+        h ^= h>>29;
+    }
+
+    if (size)
+    {
+        std::uint64_t w = 0;
+        std::memcpy(&w, p, size);
+        h = (h ^ asciiToLower8(w)) * mul;
+        h ^= h>>29;
+    }
+
+    h ^= h>>32;
+
+    return (std::size_t)h;
+}
+
+//----------------------------------------------------------------------------
+//! Сравнение без учёта регистра ASCII: a сворачивается, b - ключ (для регистронезависимых деревьев - уже в нижнем регистре)
+inline
+int compareFolded(std::string_view a, std::string_view b)
+{
+    std::size_t n = a.size()<b.size() ? a.size() : b.size();
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        unsigned char ch1 = (unsigned char)asciiToLower(a[i]);
+        unsigned char ch2 = (unsigned char)b[i];
+        if (ch1!=ch2)
+            return ch1<ch2 ? -1 : 1;
+    }
+
+    if (a.size()==b.size())
+        return 0;
+
+    return a.size()<b.size() ? -1 : 1;
+}
+
+inline
+bool equalFolded(std::string_view a, std::string_view b)
+{
+    if (a.size()!=b.size())
+        return false;
+
+    for(std::size_t i=0; i!=a.size(); ++i)
+    {
+        if (asciiToLower(a[i])!=asciiToLower(b[i]))
+            return false;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
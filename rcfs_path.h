@@ -0,0 +1,105 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Разбор путей RCFS без динамических аллокаций
+*/
+
+//----------------------------------------------------------------------------
+
+#include <string_view>
+#include <cstddef>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_RCFS_MAX_PATH_DEPTH
+
+    //! Максимальная глубина пути, разбираемого без аллокаций. Более глубокие пути обрабатываются по старинке, через std::vector
+    #define MARTY_RCFS_MAX_PATH_DEPTH            64
+
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Путь, разбитый на компоненты. Компоненты ссылаются на исходную строку, ничего не копируется
+/*! Разделителями считаются и '/', и '\\', поэтому предварительная замена слешей не нужна.
+    Компоненты "." пропускаются, ".." удаляет предыдущий компонент (выше корня не поднимаемся).
+ */
+class PathPartsView
+{
+    std::string_view    m_parts[MARTY_RCFS_MAX_PATH_DEPTH];
+    std::size_t         m_size = 0;
+
+public:
+
+    static bool isPathSep(char ch) { return ch=='/' || ch=='\\'; }
+
+    std::size_t size () const { return m_size; }
+    bool        empty() const { return m_size==0; }
+
+    const std::string_view& operator[](std::size_t idx) const { return m_parts[idx]; }
+    const std::string_view& back() const { return m_parts[m_size-1]; }
+
+    const std::string_view* begin() const { return &m_parts[0]; }
+    const std::string_view* end  () const { return &m_parts[m_size]; }
+
+    //! Возвращает false, если путь слишком глубокий
+    bool split(std::string_view path)
+    {
+        m_size = 0;
+
+        std::size_t pos = 0;
+        const std::size_t pathSize = path.size();
+
+        while(pos<pathSize)
+        {
+            while(pos<pathSize && isPathSep(path[pos]))
+                ++pos;
+
+            std::size_t partStart = pos;
+
+            while(pos<pathSize && !isPathSep(path[pos]))
+                ++pos;
+
+            std::size_t partLen = pos - partStart;
+            if (!partLen)
+                continue;
+
+            if (partLen==1 && path[partStart]=='.')
+                continue;
+
+            if (partLen==2 && path[partStart]=='.' && path[partStart+1]=='.')
+            {
+                if (m_size)
+                    --m_size;
+                continue;
+            }
+
+            if (m_size>=MARTY_RCFS_MAX_PATH_DEPTH)
+                return false;
+
+            m_parts[m_size++] = path.substr(partStart, partLen);
+        }
+
+        return true;
+    }
+
+}; // class PathPartsView
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
@@ -0,0 +1,451 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Статическая (constexpr) таблица встроенных ресурсов с идеальным хэшированием
+
+    Таблица строится компилятором, лежит в .rodata и не требует ни времени на старте,
+    ни памяти в куче. Подключается к ResourceFileSystem через setStaticIndex и доступна
+    через обычный API чтения (openFile/getFileSize/readFile).
+
+    \code
+    static constexpr marty_rcfs::StaticFileEntry rcEntries[] =
+    { MARTY_RCFS_STATIC_FILE_ARRAY_SIMPLE(_sources_brief_txt)
+    , MARTY_RCFS_STATIC_FILE_ARRAY_EX("images/logo.png", _logo_png, _logo_png_size)
+    };
+
+    static constexpr auto rcIndex = marty_rcfs::makeStaticResourceIndex(rcEntries);
+
+    rcfs.setStaticIndex(rcIndex.view());
+    \endcode
+
+    Для MARTY_RCFS_STATIC_FILE_ARRAY_SIMPLE сгенерированная переменная XXX_filename
+    должна быть constexpr (обычный static const char* нельзя использовать в константном выражении).
+
+    В статической таблице только файлы без шифрования; каталоги - неявные, энумерация
+    по статической таблице не поддерживается.
+
+    Имена, совпадающие после нормализации пути ("a//b" и "a/b") или отличающиеся
+    только регистром ASCII, - один ресурс: такая таблица не собирается с ошибкой
+    "duplicate resource path".
+*/
+
+//----------------------------------------------------------------------------
+
+#include "rcfs_path.h"
+#include "rcfs_normalize.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Описание встроенного файла. pData - const void*, чтобы можно было инициализировать в constexpr указателем на массив любого байтового типа
+struct StaticFileEntry
+{
+    const char     *name  = 0;
+    const void     *pData = 0;
+    std::size_t     size  = 0;
+
+    const std::uint8_t* getFileDataPtr() const { return (const std::uint8_t*)pData; }
+
+}; // struct StaticFileEntry
+
+//----------------------------------------------------------------------------
+#define MARTY_RCFS_STATIC_FILE_ARRAY_EX(fileName, fileDataArray, fileDataSize) \
+    marty_rcfs::StaticFileEntry{ fileName, fileDataArray, (std::size_t)(fileDataSize) }
+
+#define MARTY_RCFS_STATIC_FILE_ARRAY_SIMPLE(fileDataArrayName) \
+    MARTY_RCFS_STATIC_FILE_ARRAY_EX(fileDataArrayName##_filename, fileDataArrayName, fileDataArrayName##_size)
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace static_index_utils {
+
+constexpr bool isPathSep(char ch)
+{
+    return ch=='/' || ch=='\\';
+}
+
+constexpr std::uint64_t hashAppend(std::uint64_t h, char ch)
+{
+    return (h ^ (std::uint64_t)(unsigned char)asciiToLower(ch)) * 1099511628211ull;
+}
+
+//! Хэш (FNV-1a, без учёта регистра ASCII) канонического пути - компоненты через '/', без пустых и "."
+constexpr std::uint64_t hashEntryName(const char *name)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    bool needSep = false;
+
+    std::size_t pos = 0;
+    while(name[pos])
+    {
+        while(name[pos] && isPathSep(name[pos]))
+            ++pos;
+
+        std::size_t partStart = pos;
+        while(name[pos] && !isPathSep(name[pos]))
+            ++pos;
+
+        std::size_t partLen = pos - partStart;
+        if (!partLen)
+            continue;
+
+        if (partLen==1 && name[partStart]=='.')
+            continue;
+
+        if (partLen==2 && name[partStart]=='.' && name[partStart+1]=='.')
+            throw std::logic_error("marty_rcfs::StaticResourceIndex: '..' is not allowed in static entry names");
+
+        if (needSep)
+            h = hashAppend(h, '/');
+        needSep = true;
+
+        for(std::size_t i=partStart; i!=pos; ++i)
+            h = hashAppend(h, name[i]);
+    }
+
+    return h;
+}
+
+inline
+std::uint64_t hashPath(const PathPartsView &parts)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    for(std::size_t i=0; i!=parts.size(); ++i)
+    {
+        if (i)
+            h = hashAppend(h, '/');
+        for(auto ch : parts[i])
+            h = hashAppend(h, ch);
+    }
+    return h;
+}
+
+//! Перемешивание хэша с зерном бакета (финализатор splitmix64)
+constexpr std::uint64_t mixSeed(std::uint64_t h, std::uint32_t seed)
+{
+    std::uint64_t x = h ^ ((std::uint64_t)seed * 0x9E3779B97F4A7C15ull);
+    x = (x ^ (x>>30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x>>27)) * 0x94D049BB133111EBull;
+    return x ^ (x>>31);
+}
+
+constexpr std::size_t nextPow2(std::size_t n)
+{
+    std::size_t res = 1;
+    while(res<n)
+        res *= 2;
+    return res;
+}
+
+constexpr std::size_t bucketIndex(std::uint64_t h, std::size_t numBuckets)
+{
+    return (std::size_t)(h>>32) & (numBuckets-1);
+}
+
+constexpr std::size_t slotIndex(std::uint64_t h, std::uint32_t seed, std::size_t numSlots)
+{
+    return (std::size_t)mixSeed(h, seed) & (numSlots-1);
+}
+
+//! Следующий компонент имени (пустые и "." пропускаются). 0 - компоненты кончились
+constexpr std::size_t nextNamePart(const char *name, std::size_t &pos, std::size_t &partStart)
+{
+    while(name[pos])
+    {
+        while(name[pos] && isPathSep(name[pos]))
+            ++pos;
+
+        partStart = pos;
+        while(name[pos] && !isPathSep(name[pos]))
+            ++pos;
+
+        std::size_t partLen = pos - partStart;
+        if (partLen && !(partLen==1 && name[partStart]=='.'))
+            return partLen;
+    }
+
+    return 0;
+}
+
+//! Имена совпадают после нормализации пути и без учёта регистра ASCII - это один и тот же ресурс для таблицы
+constexpr bool canonicalNamesEqual(const char *a, const char *b)
+{
+    std::size_t posA = 0, posB = 0;
+
+    for(;;)
+    {
+        std::size_t startA = 0, startB = 0;
+        const std::size_t lenA = nextNamePart(a, posA, startA);
+        const std::size_t lenB = nextNamePart(b, posB, startB);
+
+        if (lenA!=lenB)
+            return false;
+
+        if (!lenA)
+            return true;
+
+        for(std::size_t i=0; i!=lenA; ++i)
+        {
+            if (asciiToLower(a[startA+i])!=asciiToLower(b[startB+i]))
+                return false;
+        }
+    }
+}
+
+//! Сравнивает имя статической записи с нормализованными компонентами пути
+inline
+bool entryNameEquals(const char *name, const PathPartsView &parts, bool caseSens)
+{
+    std::size_t partIdx = 0;
+    std::size_t pos     = 0;
+
+    while(name[pos])
+    {
+        while(name[pos] && isPathSep(name[pos]))
+            ++pos;
+
+        std::size_t partStart = pos;
+        while(name[pos] && !isPathSep(name[pos]))
+            ++pos;
+
+        std::size_t partLen = pos - partStart;
+        if (!partLen || (partLen==1 && name[partStart]=='.'))
+            continue;
+
+        if (partIdx>=parts.size() || parts[partIdx].size()!=partLen)
+            return false;
+
+        const std::string_view &part = parts[partIdx++];
+        for(std::size_t i=0; i!=partLen; ++i)
+        {
+            char ch1 = name[partStart+i];
+            char ch2 = part[i];
+            if (!caseSens)
+            {
+                ch1 = asciiToLower(ch1);
+                ch2 = asciiToLower(ch2);
+            }
+            if (ch1!=ch2)
+                return false;
+        }
+    }
+
+    return partIdx==parts.size();
+}
+
+} // namespace static_index_utils
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//! Нешаблонное представление статической таблицы, именно его принимает ResourceFileSystem
+struct StaticIndexView
+{
+    const StaticFileEntry   *pEntries   = 0;
+    std::size_t              numEntries = 0;
+    const std::uint32_t     *pSeeds     = 0;
+    std::size_t              numBuckets = 0;
+    const std::uint32_t     *pSlots     = 0; //!< Индекс записи + 1, 0 - пустой слот
+    std::size_t              numSlots   = 0;
+
+    bool empty() const { return numEntries==0; }
+
+    //! Один хэш и одна проба
+    const StaticFileEntry* find(const PathPartsView &parts, bool caseSens) const
+    {
+        if (empty() || parts.empty())
+            return 0;
+
+        const std::uint64_t h = static_index_utils::hashPath(parts);
+        const std::uint32_t seed = pSeeds[static_index_utils::bucketIndex(h, numBuckets)];
+        const std::uint32_t entryIdx = pSlots[static_index_utils::slotIndex(h, seed, numSlots)];
+        if (!entryIdx)
+            return 0;
+
+        const StaticFileEntry *pEntry = &pEntries[entryIdx-1];
+        if (!static_index_utils::entryNameEquals(pEntry->name, parts, caseSens))
+            return 0;
+
+        return pEntry;
+    }
+
+}; // struct StaticIndexView
+
+//----------------------------------------------------------------------------
+//! Статическая таблица ресурсов, строится в compile time (hash and displace)
+/*! Записи раскладываются по бакетам, для каждого бакета (от больших к меньшим)
+    подбирается зерно, при котором все его записи попадают в свободные слоты.
+    Заполнение таблицы слотов - не больше 50%, поэтому зерна находятся быстро.
+ */
+template<std::size_t N>
+class StaticResourceIndex
+{
+
+public:
+
+    static constexpr std::size_t numSlots   = static_index_utils::nextPow2(N*2);
+    static constexpr std::size_t numBuckets = static_index_utils::nextPow2((N+3)/4);
+
+    static constexpr std::uint32_t maxSeed  = 0x100000;
+
+protected:
+
+    StaticFileEntry     m_entries[N];
+    std::uint32_t       m_seeds[numBuckets];
+    std::uint32_t       m_slots[numSlots];
+
+
+public:
+
+    constexpr StaticResourceIndex(const StaticFileEntry (&entries)[N])
+    : m_entries{}
+    , m_seeds{}
+    , m_slots{}
+    {
+        std::uint64_t hashes[N]           = {};
+        std::size_t   bucketStart[numBuckets+1] = {};
+        std::size_t   bucketMembers[N]    = {};
+        std::size_t   bucketFill[numBuckets] = {};
+        std::size_t   maxBucketSize = 0;
+
+        for(std::size_t i=0; i!=N; ++i)
+        {
+            m_entries[i] = entries[i];
+            hashes[i] = static_index_utils::hashEntryName(entries[i].name);
+            ++bucketStart[static_index_utils::bucketIndex(hashes[i], numBuckets)+1];
+        }
+
+        for(std::size_t b=0; b!=numBuckets; ++b)
+        {
+            std::size_t bucketSize = bucketStart[b+1];
+            if (bucketSize>maxBucketSize)
+                maxBucketSize = bucketSize;
+            bucketStart[b+1] += bucketStart[b];
+        }
+
+        for(std::size_t i=0; i!=N; ++i)
+        {
+            std::size_t b = static_index_utils::bucketIndex(hashes[i], numBuckets);
+            bucketMembers[bucketStart[b]+bucketFill[b]++] = i;
+        }
+
+        // Одинаковые имена попадают в один бакет. Проверяем до подбора зерен,
+        // чтобы дубликат ресурса не выглядел как неудача подбора хэша
+        for(std::size_t b=0; b!=numBuckets; ++b)
+            checkBucketNames(hashes, &bucketMembers[bucketStart[b]], bucketStart[b+1]-bucketStart[b]);
+
+        // Сначала самые большие бакеты - для них свободных слотов найти сложнее всего
+        for(std::size_t bucketSize=maxBucketSize; bucketSize!=0; --bucketSize)
+        {
+            for(std::size_t b=0; b!=numBuckets; ++b)
+            {
+                if (bucketStart[b+1]-bucketStart[b]!=bucketSize)
+                    continue;
+
+                placeBucket(b, hashes, &bucketMembers[bucketStart[b]], bucketSize);
+            }
+        }
+    }
+
+    constexpr StaticIndexView view() const
+    {
+        return StaticIndexView{ &m_entries[0], N, &m_seeds[0], numBuckets, &m_slots[0], numSlots };
+    }
+
+    constexpr std::size_t size() const { return N; }
+
+
+protected:
+
+    //! Дубликаты ресурсов (имена равны после нормализации пути и без учёта регистра) и настоящие коллизии хэша
+    constexpr void checkBucketNames(const std::uint64_t *hashes, const std::size_t *members, std::size_t numMembers) const
+    {
+        for(std::size_t i=0; i!=numMembers; ++i)
+        {
+            for(std::size_t j=0; j!=i; ++j)
+            {
+                if (static_index_utils::canonicalNamesEqual(m_entries[members[i]].name, m_entries[members[j]].name))
+                    throw std::logic_error("marty_rcfs::StaticResourceIndex: duplicate resource path (names are equal after path normalization and ASCII case folding)");
+            }
+        }
+
+        for(std::size_t i=0; i!=numMembers; ++i)
+        {
+            for(std::size_t j=0; j!=i; ++j)
+            {
+                if (hashes[members[i]]==hashes[members[j]])
+                    throw std::logic_error("marty_rcfs::StaticResourceIndex: entry name hash collision");
+            }
+        }
+    }
+
+    constexpr void placeBucket(std::size_t b, const std::uint64_t *hashes, const std::size_t *members, std::size_t numMembers)
+    {
+        for(std::uint32_t seed=0; seed!=maxSeed; ++seed)
+        {
+            bool fits = true;
+
+            for(std::size_t i=0; i!=numMembers && fits; ++i)
+            {
+                std::size_t slot = static_index_utils::slotIndex(hashes[members[i]], seed, numSlots);
+                if (m_slots[slot]!=0)
+                {
+                    fits = false;
+                    break;
+                }
+
+                for(std::size_t j=0; j!=i; ++j)
+                {
+                    if (static_index_utils::slotIndex(hashes[members[j]], seed, numSlots)==slot)
+                    {
+                        fits = false;
+                        break;
+                    }
+                }
+            }
+
+            if (!fits)
+                continue;
+
+            m_seeds[b] = seed;
+            for(std::size_t i=0; i!=numMembers; ++i)
+                m_slots[static_index_utils::slotIndex(hashes[members[i]], seed, numSlots)] = (std::uint32_t)(members[i]+1);
+
+            return;
+        }
+
+        throw std::logic_error("marty_rcfs::StaticResourceIndex: failed to find perfect hash seed");
+    }
+
+}; // class StaticResourceIndex
+
+//----------------------------------------------------------------------------
+template<std::size_t N> constexpr
+StaticResourceIndex<N> makeStaticResourceIndex(const StaticFileEntry (&entries)[N])
+{
+    return StaticResourceIndex<N>(entries);
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
@@ -0,0 +1,309 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief std::streambuf/std::istream поверх файла RCFS
+
+    Если данные файла лежат в памяти целиком (обычный случай), область чтения
+    streambuf устанавливается прямо на них - без копирования. Иначе файл
+    читается кусками через preadFile во внутренний буфер.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstring>
+#include <ios>
+#include <istream>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+#include "rcfs.h"
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_RCFS_STREAMBUF_CHUNK_SIZE
+
+    //! Размер буфера для чтения кусками
+    #define MARTY_RCFS_STREAMBUF_CHUNK_SIZE      65536
+
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+//! Буфер потока только для чтения над файлом RCFS. Владеет открытым дескриптором
+class ResourceStreamBuf : public std::streambuf
+{
+    const ResourceFileSystem   *m_pRcfs    = 0;
+    int                         m_fileId   = -1;
+    std::size_t                 m_fileSize = 0;
+
+    bool                        m_zeroCopy = false;
+    std::vector<char>           m_chunk;             //!< Буфер при чтении кусками
+    std::size_t                 m_chunkPos = 0;      //!< Смещение начала буфера в файле
+
+
+    //! Позиция в файле, соответствующая gptr()
+    std::size_t getCurPos() const
+    {
+        if (m_zeroCopy)
+            return (std::size_t)(gptr()-eback());
+        return m_chunkPos + (std::size_t)(gptr()-eback());
+    }
+
+    //! Устанавливает позицию. pos<=m_fileSize
+    void setCurPos(std::size_t pos)
+    {
+        if (m_zeroCopy)
+        {
+            setg(eback(), eback()+pos, egptr());
+            return;
+        }
+
+        // Внутри текущего куска - просто двигаем указатель
+        if (pos>=m_chunkPos && pos<=m_chunkPos+(std::size_t)(egptr()-eback()) && eback())
+        {
+            setg(eback(), eback()+(pos-m_chunkPos), egptr());
+            return;
+        }
+
+        m_chunkPos = pos;
+        setg(0, 0, 0); // Кусок загрузит underflow
+    }
+
+    bool attach(int fileId)
+    {
+        if (fileId<0)
+            return false;
+
+        m_fileId   = fileId;
+        m_fileSize = m_pRcfs->getFileSize(fileId);
+        if (m_fileSize==(std::size_t)-1)
+        {
+            close();
+            return false;
+        }
+
+        FileView view = m_pRcfs->getFileView(fileId);
+        m_zeroCopy = !view.empty() || m_fileSize==0;
+
+        if (m_zeroCopy)
+        {
+            // Поток только для чтения - запись в область чтения не производится
+            char *pBegin = const_cast<char*>((const char*)view.data());
+            setg(pBegin, pBegin, pBegin+view.size());
+        }
+        else
+        {
+            m_chunkPos = 0;
+            setg(0, 0, 0);
+        }
+
+        return true;
+    }
+
+protected:
+
+    int_type underflow() override
+    {
+        if (gptr()<egptr())
+            return traits_type::to_int_type(*gptr());
+
+        if (m_zeroCopy || m_fileId<0)
+            return traits_type::eof();
+
+        std::size_t pos = getCurPos();
+        if (pos>=m_fileSize)
+            return traits_type::eof();
+
+        m_chunk.resize(MARTY_RCFS_STREAMBUF_CHUNK_SIZE);
+
+        std::size_t nRead = 0;
+        if (!m_pRcfs->preadFile(m_fileId, pos, (std::uint8_t*)m_chunk.data(), m_chunk.size(), &nRead) || !nRead)
+            return traits_type::eof();
+
+        m_chunkPos = pos;
+        setg(m_chunk.data(), m_chunk.data(), m_chunk.data()+nRead);
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::streamsize xsgetn(char *pDst, std::streamsize n) override
+    {
+        if (n<=0)
+            return 0;
+
+        std::size_t nWanted = (std::size_t)n;
+
+        // Сначала - то, что уже есть в области чтения (для zero-copy это весь остаток файла)
+        std::size_t nAvail  = (std::size_t)(egptr()-gptr());
+        std::size_t nCopied = nWanted<nAvail ? nWanted : nAvail;
+        if (nCopied)
+        {
+            std::memcpy(pDst, gptr(), nCopied);
+            setg(eback(), gptr()+nCopied, egptr());
+        }
+
+        if (nCopied==nWanted || m_zeroCopy || m_fileId<0)
+            return (std::streamsize)nCopied;
+
+        // Остаток читаем прямо в буфер вызывающего, минуя внутренний
+        std::size_t pos   = getCurPos();
+        std::size_t nRead = 0;
+        if (pos<m_fileSize)
+            m_pRcfs->preadFile(m_fileId, pos, (std::uint8_t*)pDst+nCopied, nWanted-nCopied, &nRead);
+
+        m_chunkPos = pos + nRead;
+        setg(0, 0, 0);
+
+        return (std::streamsize)(nCopied+nRead);
+    }
+
+    std::streamsize showmanyc() override
+    {
+        std::size_t pos = getCurPos();
+        if (pos>=m_fileSize)
+            return -1;
+        return (std::streamsize)(m_fileSize-pos);
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        if (!(which&std::ios_base::in) || m_fileId<0)
+            return pos_type(off_type(-1));
+
+        std::size_t basePos = dir==std::ios_base::beg ? 0
+                            : dir==std::ios_base::cur ? getCurPos()
+                                                      : m_fileSize;
+
+        if (off<0 ? (std::size_t)0-(std::size_t)off>basePos : (std::size_t)off>m_fileSize-basePos)
+            return pos_type(off_type(-1));
+
+        std::size_t newPos = basePos + (std::size_t)off;
+        setCurPos(newPos);
+
+        return pos_type(off_type(newPos));
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+public:
+
+    explicit ResourceStreamBuf(const ResourceFileSystem *pRcfs) : m_pRcfs(pRcfs) {}
+    ~ResourceStreamBuf() override { close(); }
+
+    ResourceStreamBuf(const ResourceStreamBuf&) = delete;
+    ResourceStreamBuf& operator=(const ResourceStreamBuf&) = delete;
+
+    bool open(std::string_view fullName)
+    {
+        close();
+        return attach(m_pRcfs->openFile(fullName));
+    }
+
+    bool open(const ResourceId &resourceId)
+    {
+        close();
+        return attach(m_pRcfs->openFile(resourceId));
+    }
+
+    void close()
+    {
+        if (m_fileId>=0)
+            m_pRcfs->closeFile(m_fileId);
+
+        m_fileId   = -1;
+        m_fileSize = 0;
+        m_zeroCopy = false;
+        m_chunkPos = 0;
+        setg(0, 0, 0);
+    }
+
+    bool        isOpen    () const { return m_fileId>=0; }
+    bool        isZeroCopy() const { return m_zeroCopy; } //!< Область чтения указывает прямо на данные файла
+    std::size_t getFileSize() const { return m_fileSize; }
+
+}; // class ResourceStreamBuf
+
+//----------------------------------------------------------------------------
+//! Поток чтения файла RCFS. При ошибке открытия поток в состоянии fail
+class ResourceIStream : public std::istream
+{
+    ResourceStreamBuf           m_buf;
+
+public:
+
+    explicit ResourceIStream(const ResourceFileSystem *pRcfs)
+    : std::istream(0)
+    , m_buf(pRcfs)
+    {
+        rdbuf(&m_buf);
+        setstate(std::ios_base::failbit);
+    }
+
+    ResourceIStream(const ResourceFileSystem *pRcfs, std::string_view fullName)
+    : ResourceIStream(pRcfs)
+    {
+        open(fullName);
+    }
+
+    ResourceIStream(const ResourceFileSystem *pRcfs, const ResourceId &resourceId)
+    : ResourceIStream(pRcfs)
+    {
+        open(resourceId);
+    }
+
+    bool open(std::string_view fullName)
+    {
+        return setOpenResult(m_buf.open(fullName));
+    }
+
+    bool open(const ResourceId &resourceId)
+    {
+        return setOpenResult(m_buf.open(resourceId));
+    }
+
+    void close()
+    {
+        m_buf.close();
+        setstate(std::ios_base::failbit);
+    }
+
+    bool isOpen() const { return m_buf.isOpen(); }
+
+    ResourceStreamBuf* getStreamBuf() { return &m_buf; }
+
+protected:
+
+    bool setOpenResult(bool opened)
+    {
+        if (opened)
+            clear();
+        else
+            setstate(std::ios_base::failbit);
+        return opened;
+    }
+
+}; // class ResourceIStream
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
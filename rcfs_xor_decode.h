@@ -0,0 +1,230 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief XOR-декодирование данных ресурсов - SSE2/AVX2 и скалярный вариант
+
+    Ключевой поток: ключ размером 1, 2 или 4 байта накладывается на данные
+    байтами от младшего к старшему (little endian); после каждого полного ключа
+    к ключу прибавляется инкремент (по модулю разрядности ключа).
+    Ключ номер j равен seed + j*inc, поэтому значения ключей для целого
+    вектора вычисляются заранее, и на каждый вектор нужна одна операция
+    сложения.
+
+    Ключевой поток можно начать с любого смещения (streamOffset) - так
+    декодируется произвольный диапазон файла без декодирования предыдущих данных.
+
+    Источник и приёмник могут совпадать (декодирование на месте), но не должны
+    частично перекрываться.
+    Кодирование и декодирование - одна и та же операция.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(MARTY_RCFS_DISABLE_SIMD)
+
+    #if defined(__AVX2__)
+        #define MARTY_RCFS_XOR_DECODE_AVX2
+    #endif
+
+    #if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+        #define MARTY_RCFS_XOR_DECODE_SSE2
+    #endif
+
+#endif
+
+#if defined(MARTY_RCFS_XOR_DECODE_AVX2)
+    #include <immintrin.h>
+#elif defined(MARTY_RCFS_XOR_DECODE_SSE2)
+    #include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs {
+
+
+
+//----------------------------------------------------------------------------
+namespace xor_decode_utils {
+
+//! Ключ номер keyIdx, усечённый до размера ключа
+inline
+std::uint32_t getKey(unsigned keySize, std::uint32_t seed, std::uint32_t inc, std::size_t keyIdx)
+{
+    std::uint32_t key = seed + (std::uint32_t)keyIdx*inc;
+    return keySize==4 ? key : (key & ((1u<<(keySize*8))-1));
+}
+
+template<unsigned KeySize>
+void xorDecodeScalarImpl(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size, std::uint32_t key, std::uint32_t inc)
+{
+    std::size_t i = 0;
+    for(; i+KeySize<=size; i+=KeySize, key+=inc)
+    {
+        for(unsigned b=0; b!=KeySize; ++b)
+            pDst[i+b] = (std::uint8_t)(pSrc[i+b] ^ (std::uint8_t)(key>>(b*8)));
+    }
+
+    for(unsigned b=0; i!=size; ++i, ++b) // Неполный последний ключ
+        pDst[i] = (std::uint8_t)(pSrc[i] ^ (std::uint8_t)(key>>(b*8)));
+}
+
+//! Скалярный вариант. byteOffset - смещение pSrc в потоке (кратно keySize)
+inline
+void xorDecodeScalar(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size, unsigned keySize, std::uint32_t seed, std::uint32_t inc, std::size_t byteOffset = 0)
+{
+    const std::uint32_t key = getKey(keySize, seed, inc, byteOffset/keySize);
+
+    switch(keySize)
+    {
+        case 1 : xorDecodeScalarImpl<1>(pDst, pSrc, size, key, inc); break;
+        case 2 : xorDecodeScalarImpl<2>(pDst, pSrc, size, key, inc); break;
+        default: xorDecodeScalarImpl<4>(pDst, pSrc, size, key, inc);
+    }
+}
+
+//! Байты ключевого потока с начала. size кратен keySize
+inline
+void fillKeyBytes(std::uint8_t *pBytes, std::size_t size, unsigned keySize, std::uint32_t seed, std::uint32_t inc)
+{
+    std::uint32_t key = seed;
+    for(std::size_t i=0; i!=size; i+=keySize)
+    {
+        for(unsigned b=0; b!=keySize; ++b)
+            pBytes[i+b] = (std::uint8_t)(key>>(b*8));
+        key += inc;
+    }
+}
+
+#if defined(MARTY_RCFS_XOR_DECODE_SSE2)
+
+//! Ключи для первых 16 байт: в каждой дорожке размера ключа - seed + laneIdx*inc
+inline
+__m128i makeKeyVector128(unsigned keySize, std::uint32_t seed, std::uint32_t inc)
+{
+    alignas(16) std::uint8_t keyBytes[16];
+    fillKeyBytes(keyBytes, 16, keySize, seed, inc);
+    return _mm_load_si128((const __m128i*)keyBytes);
+}
+
+#endif
+
+#if defined(MARTY_RCFS_XOR_DECODE_AVX2)
+
+inline
+__m256i makeKeyVector256(unsigned keySize, std::uint32_t seed, std::uint32_t inc)
+{
+    alignas(32) std::uint8_t keyBytes[32];
+    fillKeyBytes(keyBytes, 32, keySize, seed, inc);
+    return _mm256_load_si256((const __m256i*)keyBytes);
+}
+
+#endif
+
+//! Декодирование с начала ключа номер 0 (seed). keySize - 1, 2 или 4
+inline
+void xorDecodeFromKeyStart(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size, unsigned keySize, std::uint32_t seed, std::uint32_t inc)
+{
+    std::size_t pos = 0;
+
+    #if defined(MARTY_RCFS_XOR_DECODE_AVX2)
+    if (size>=32)
+    {
+        const std::uint32_t keysPerVector = 32/keySize;
+        const std::uint32_t step          = keysPerVector*inc;
+
+        __m256i keys    = makeKeyVector256(keySize, seed, inc);
+        __m256i keyStep = keySize==1 ? _mm256_set1_epi8 ((char )step)
+                        : keySize==2 ? _mm256_set1_epi16((short)step)
+                        :              _mm256_set1_epi32((int  )step);
+
+        for(; pos+32<=size; pos+=32)
+        {
+            __m256i data = _mm256_loadu_si256((const __m256i*)(pSrc+pos));
+            _mm256_storeu_si256((__m256i*)(pDst+pos), _mm256_xor_si256(data, keys));
+
+            keys = keySize==1 ? _mm256_add_epi8 (keys, keyStep)
+                 : keySize==2 ? _mm256_add_epi16(keys, keyStep)
+                 :              _mm256_add_epi32(keys, keyStep);
+        }
+    }
+    #endif
+
+    #if defined(MARTY_RCFS_XOR_DECODE_SSE2)
+    if (size-pos>=16)
+    {
+        const std::uint32_t keysPerVector = 16/keySize;
+        const std::uint32_t step          = keysPerVector*inc;
+        const std::uint32_t startSeed     = getKey(keySize, seed, inc, pos/keySize);
+
+        __m128i keys    = makeKeyVector128(keySize, startSeed, inc);
+        __m128i keyStep = keySize==1 ? _mm_set1_epi8 ((char )step)
+                        : keySize==2 ? _mm_set1_epi16((short)step)
+                        :              _mm_set1_epi32((int  )step);
+
+        for(; pos+16<=size; pos+=16)
+        {
+            __m128i data = _mm_loadu_si128((const __m128i*)(pSrc+pos));
+            _mm_storeu_si128((__m128i*)(pDst+pos), _mm_xor_si128(data, keys));
+
+            keys = keySize==1 ? _mm_add_epi8 (keys, keyStep)
+                 : keySize==2 ? _mm_add_epi16(keys, keyStep)
+                 :              _mm_add_epi32(keys, keyStep);
+        }
+    }
+    #endif
+
+    xorDecodeScalar(pDst+pos, pSrc+pos, size-pos, keySize, seed, inc, pos);
+}
+
+} // namespace xor_decode_utils
+
+//----------------------------------------------------------------------------
+//! XOR-декодирование pSrc в pDst. false - недопустимый размер ключа (допустимы 1, 2, 4)
+/*! streamOffset - смещение pSrc от начала ключевого потока (файла).
+ */
+inline
+bool xorDecodeData(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size, unsigned keySize, std::uint32_t seed, std::uint32_t inc, std::size_t streamOffset = 0)
+{
+    if (keySize!=1 && keySize!=2 && keySize!=4)
+        return false;
+
+    std::size_t keyIdx  = streamOffset/keySize;
+    unsigned    byteIdx = (unsigned)(streamOffset%keySize);
+    std::size_t pos     = 0;
+
+    if (byteIdx)
+    {
+        // Начало внутри ключа - докодируем этот ключ побайтно
+        const std::uint32_t key = xor_decode_utils::getKey(keySize, seed, inc, keyIdx);
+        for(; byteIdx!=keySize && pos!=size; ++byteIdx, ++pos)
+            pDst[pos] = (std::uint8_t)(pSrc[pos] ^ (std::uint8_t)(key>>(byteIdx*8)));
+        ++keyIdx;
+    }
+
+    xor_decode_utils::xorDecodeFromKeyStart(pDst+pos, pSrc+pos, size-pos, keySize, xor_decode_utils::getKey(keySize, seed, inc, keyIdx), inc);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//! XOR-кодирование - та же операция, что и декодирование
+inline
+bool xorEncodeData(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size, unsigned keySize, std::uint32_t seed, std::uint32_t inc, std::size_t streamOffset = 0)
+{
+    return xorDecodeData(pDst, pSrc, size, keySize, seed, inc, streamOffset);
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs
+
@@ -0,0 +1,72 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Минимальные средства проверки для тестов marty_rcfs - без внешних фреймворков
+
+    Каждый тест - отдельная программа; код возврата 0 - все проверки прошли.
+    Собирается так же, как любой код с marty_rcfs (marty_cpp и umba - в путях
+    включения, каталог common - рядом с каталогом библиотеки), например:
+
+        g++ -std=c++17 -O2 -DNDEBUG -I<каталог с marty_cpp и umba> -pthread tests/test_lookup.cpp -o test_lookup
+
+    -DNDEBUG обязателен для gcc/clang: без него MARTY_RCFS_ASSERT (assert.h) не компилируется.
+    Тесты многопоточного режима дополнительно собираются с -DMARTY_RCFS_THREAD_SAFE.
+    test_xor_decode сверяется с _2c::xorDecrypt - ему нужен ещё каталог с _2c_xor_encrypt.h.
+*/
+
+//----------------------------------------------------------------------------
+
+#include <cstdio>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs_test {
+
+
+
+//----------------------------------------------------------------------------
+inline
+int& getFailCount()
+{
+    static int failCount = 0;
+    return failCount;
+}
+
+inline
+void checkFailed(const char *expr, const char *file, int line)
+{
+    std::printf("%s:%d: check failed: %s\n", file, line, expr);
+    ++getFailCount();
+}
+
+//! Итог теста - для return из main
+inline
+int report(const char *testName)
+{
+    if (getFailCount())
+        std::printf("%s: %d check(s) failed\n", testName, getFailCount());
+    else
+        std::printf("%s: OK\n", testName);
+
+    return getFailCount() ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs_test
+
+//----------------------------------------------------------------------------
+#define RCFS_CHECK(expr)                                                       \
+            do { if (!(expr)) marty_rcfs_test::checkFailed(#expr, __FILE__, __LINE__); } while(0)
+
+#define RCFS_CHECK_THROWS(expr)                                                \
+            do { bool rcfsThrown_ = false;                                     \
+                 try { (void)(expr); } catch(...) { rcfsThrown_ = true; }      \
+                 if (!rcfsThrown_) marty_rcfs_test::checkFailed("throws: " #expr, __FILE__, __LINE__); } while(0)
+
@@ -0,0 +1,133 @@
+#pragma once
+
+//----------------------------------------------------------------------------
+
+/*! \file
+    \brief Наборы закодированных файлов для тестов декодирования marty_rcfs
+
+    Файлы со всеми видами кодирования: без кодирования, XOR без цепочки (по decryptKeySize),
+    цепочки Xor, Lz, Xor -> Lz, контейнер кусков и пустой закодированный файл.
+*/
+
+//----------------------------------------------------------------------------
+
+#include "../rcfs.h"
+#include "../rcfs_file_decoders.h"
+#include "rcfs_test.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace marty_rcfs_test {
+
+
+
+//----------------------------------------------------------------------------
+static const unsigned testKeySeed = 0x13572468;
+static const unsigned testKeyInc  = 0x01020304;
+
+//----------------------------------------------------------------------------
+struct TestFile
+{
+    std::string                 name;
+    unsigned                    codecChain = 0;
+    unsigned                    keySize    = 0;
+    std::vector<std::uint8_t>   plain;
+    std::vector<std::uint8_t>   stored; //!< Данные, как они лежат в ресурсах
+
+    //! Декодирование требуется
+    bool encoded() const { return codecChain!=marty_rcfs::codecChainDefault || keySize!=0; }
+};
+
+//----------------------------------------------------------------------------
+//! Сжимаемые данные - текст с медленно меняющимися символами
+inline
+std::vector<std::uint8_t> makeTestData(std::size_t size)
+{
+    std::vector<std::uint8_t> data(size);
+    for(std::size_t i=0; i!=size; ++i)
+        data[i] = (std::uint8_t)("resource data "[i%14] + (i/1000)%3);
+    return data;
+}
+
+//----------------------------------------------------------------------------
+inline
+TestFile makeTestFile(const std::string &name, unsigned codecChain, unsigned keySize, std::size_t size)
+{
+    using namespace marty_rcfs;
+
+    TestFile f;
+    f.name       = name;
+    f.codecChain = codecChain;
+    f.keySize    = keySize;
+    f.plain      = makeTestData(size);
+
+    if (codecChain==codecChainDefault)
+    {
+        f.stored = f.plain;
+        if (keySize)
+            xorEncodeData(f.stored.data(), f.plain.data(), f.plain.size(), keySize, testKeySeed, testKeyInc);
+    }
+    else if (isChunkedCodecChain(codecChain))
+        encodeChunkedData(f.stored, f.plain, codecChain, keySize, testKeySeed, testKeyInc, 16384);
+    else
+        encodeCodecChain(f.stored, f.plain.data(), f.plain.size(), codecChain, keySize, testKeySeed, testKeyInc);
+
+    return f;
+}
+
+//----------------------------------------------------------------------------
+//! Набор файлов со всеми видами кодирования. Закодированных непустых - 5
+inline
+std::vector<TestFile> makeTestFiles()
+{
+    using namespace marty_rcfs;
+
+    std::vector<TestFile> files;
+    files.push_back(makeTestFile("data/plain.txt"    , codecChainDefault     , 0, 3000 ));
+    files.push_back(makeTestFile("data/xor_key.bin"  , codecChainDefault     , 2, 5000 )); // Без цепочки - XOR по decryptKeySize
+    files.push_back(makeTestFile("data/xor.bin"      , codecChainXor         , 4, 7000 ));
+    files.push_back(makeTestFile("data/lz.bin"       , codecChainLz          , 0, 20000));
+    files.push_back(makeTestFile("data/xor_lz.bin"   , codecChainXorLz       , 1, 30000));
+    files.push_back(makeTestFile("data/chunked.bin"  , codecChainChunkedXorLz, 2, 90000));
+    files.push_back(makeTestFile("data/empty_xor.bin", codecChainXor         , 2, 0    ));
+    return files;
+}
+
+//----------------------------------------------------------------------------
+inline
+void addTestFiles(marty_rcfs::ResourceFileSystem &rcfs, const std::vector<TestFile> &files)
+{
+    for(const auto &f : files)
+    {
+        RCFS_CHECK(rcfs.createFile(f.name));
+        RCFS_CHECK(rcfs.setFileData(f.name, f.stored.data(), f.stored.size(), f.keySize, testKeySeed, testKeyInc, f.codecChain));
+    }
+}
+
+//----------------------------------------------------------------------------
+//! Открывает файл, читает целиком и сравнивает с исходными данными
+inline
+bool readAndCompare(const marty_rcfs::ResourceFileSystem &rcfs, const TestFile &f)
+{
+    int iFile = rcfs.openFile(f.name);
+    if (iFile<0)
+        return false;
+
+    std::vector<std::uint8_t> buf;
+    const bool res = (rcfs.readFile(iFile, buf) || f.plain.empty()) && buf==f.plain;
+    rcfs.closeFile(iFile);
+    return res;
+}
+
+//----------------------------------------------------------------------------
+
+
+} // namespace marty_rcfs_test
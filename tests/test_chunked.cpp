@@ -0,0 +1,242 @@
+//----------------------------------------------------------------------------
+//! \file Контейнер кусков: кодирование и декодирование целиком/по диапазонам/в несколько потоков, повреждённые заголовки и таблицы
+
+#include "../rcfs.h"
+#include "../rcfs_file_decoders.h"
+#include "rcfs_test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+//! Заголовок контейнера без данных кусков - для проверки разбора
+static
+std::vector<std::uint8_t> makeHeader(std::uint32_t chunkSize, std::uint32_t numChunks, std::uint64_t decodedSize, std::size_t totalSize)
+{
+    std::vector<std::uint8_t> data(totalSize, 0);
+    std::memcpy(data.data(), "RCCK", 4);
+    data[4] = 1;
+    chunked_utils::writeLe(&data[ 8], chunkSize  , 4);
+    chunked_utils::writeLe(&data[12], numChunks  , 4);
+    chunked_utils::writeLe(&data[16], decodedSize, 8);
+    return data;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    std::mt19937 rng(1);
+
+    std::vector<std::uint8_t> data(300000);
+    for(std::size_t i=0; i!=data.size(); ++i)
+        data[i] = (std::uint8_t)(i%251 < 200 ? 'a'+i%13 : rng());
+
+    const unsigned chains[] = { makeCodecChain(CodecStage::Chunked), makeCodecChain(CodecStage::Chunked, CodecStage::Xor), codecChainChunkedLz, codecChainChunkedXorLz };
+
+    // Кругом: разные размеры данных и кусков, все цепочки
+    for(unsigned chain : chains)
+    {
+        for(std::size_t size : { (std::size_t)0, (std::size_t)1, (std::size_t)4095, (std::size_t)4096, (std::size_t)4097, data.size() })
+        {
+            std::vector<std::uint8_t> encoded, decoded;
+            encodeChunkedData(encoded, data.data(), size, chain, 2, 0x1234, 0x5678, 4096);
+
+            RCFS_CHECK(chunkedGetDecodedSize(encoded.data(), encoded.size())==size);
+            RCFS_CHECK(decodeChunkedData(decoded, encoded.data(), encoded.size(), chain, 2, 0x1234, 0x5678));
+            RCFS_CHECK(decoded.size()==size && std::equal(decoded.begin(), decoded.end(), data.begin()));
+
+            RCFS_CHECK(decodeChunkedData(decoded, encoded.data(), encoded.size(), chain, 2, 0x1234, 0x5678, 4));
+            RCFS_CHECK(decoded.size()==size && std::equal(decoded.begin(), decoded.end(), data.begin()));
+
+            // Неверный размер приёмника
+            std::vector<std::uint8_t> wrong(size+1);
+            RCFS_CHECK(!decodeChunkedData(wrong.data(), wrong.size(), encoded.data(), encoded.size(), chain, 2, 0x1234, 0x5678));
+
+            // Диапазоны: внутри куска, через границы, целые куски, в конце
+            for(int iter=0; iter!=50 && size; ++iter)
+            {
+                const std::size_t offset    = rng()%size;
+                const std::size_t rangeSize = rng()%(std::min<std::size_t>(size-offset, 3*4096)+1);
+
+                std::vector<std::uint8_t> range(rangeSize);
+                RCFS_CHECK(decodeChunkedRange(range.data(), encoded.data(), encoded.size(), chain, offset, rangeSize, 2, 0x1234, 0x5678));
+                RCFS_CHECK(std::equal(range.begin(), range.end(), data.begin()+offset));
+            }
+
+            std::uint8_t b = 0;
+            RCFS_CHECK(!decodeChunkedRange(&b, encoded.data(), encoded.size(), chain, size, 1, 2, 0x1234, 0x5678));
+        }
+    }
+
+    RCFS_CHECK_THROWS({ std::vector<std::uint8_t> e; encodeChunkedData(e, data, codecChainLz, 0, 0, 0); });
+    RCFS_CHECK_THROWS({ std::vector<std::uint8_t> e; encodeChunkedData(e, data, codecChainChunkedLz, 0, 0, 0, 0); });
+
+    // Повреждённые заголовки
+    {
+        // Число кусков переполняет (decodedSize+chunkSize-1)/chunkSize - раньше принималось и читалось за таблицей
+        std::vector<std::uint8_t> overflow = makeHeader(0xFFFFFFFFu, 0, 0xFFFFFFFFFFFFFFFEull, 32);
+        std::uint8_t buf[10];
+        RCFS_CHECK(chunkedGetDecodedSize(overflow.data(), overflow.size())==(std::size_t)-1);
+        RCFS_CHECK(!decodeChunkedRange(buf, overflow.data(), overflow.size(), codecChainChunkedLz, 0, 10, 0, 0, 0));
+
+        // Число кусков не соответствует размерам
+        std::vector<std::uint8_t> tooFew = makeHeader(16, 1, 100, 24+2*8);
+        RCFS_CHECK(chunkedGetDecodedSize(tooFew.data(), tooFew.size())==(std::size_t)-1);
+
+        std::vector<std::uint8_t> tooMany = makeHeader(16, 8, 100, 24+9*8);
+        RCFS_CHECK(chunkedGetDecodedSize(tooMany.data(), tooMany.size())==(std::size_t)-1);
+
+        // Нулевой размер куска, таблица не помещается, не та сигнатура или версия
+        RCFS_CHECK(chunkedGetDecodedSize(makeHeader(0, 0, 0, 32).data(), 32)==(std::size_t)-1);
+        RCFS_CHECK(chunkedGetDecodedSize(makeHeader(16, 7, 100, 24+7*8).data(), 24+7*8)==(std::size_t)-1);
+
+        std::vector<std::uint8_t> badVersion = makeHeader(16, 0, 0, 32);
+        badVersion[4] = 2;
+        RCFS_CHECK(chunkedGetDecodedSize(badVersion.data(), badVersion.size())==(std::size_t)-1);
+        RCFS_CHECK(chunkedGetDecodedSize(badVersion.data(), 10)==(std::size_t)-1);
+
+        // Правильный пустой контейнер
+        std::vector<std::uint8_t> empty = makeHeader(16, 0, 0, 32);
+        chunked_utils::writeLe(&empty[24], 32, 8);
+        RCFS_CHECK(chunkedGetDecodedSize(empty.data(), empty.size())==0);
+
+        // Номер куска за таблицей не читается
+        chunked_utils::ChunkedHeader header;
+        std::size_t begin = 0, end = 0;
+        RCFS_CHECK(chunked_utils::readHeader(empty.data(), empty.size(), header));
+        RCFS_CHECK(!chunked_utils::getChunkBounds(empty.data(), empty.size(), header, 0, begin, end));
+        RCFS_CHECK(!chunked_utils::decodeChunk(buf, empty.data(), empty.size(), header, 5, codecChainLz, 0, 0, 0));
+    }
+
+    // Повреждённая таблица смещений и данные кусков
+    {
+        std::vector<std::uint8_t> encoded;
+        encodeChunkedData(encoded, data.data(), 20000, codecChainChunkedLz, 0, 0, 0, 4096);
+
+        std::vector<std::uint8_t> decoded(20000);
+        for(std::size_t i=0; i!=6; ++i)
+        {
+            std::vector<std::uint8_t> bad = encoded;
+            chunked_utils::writeLe(&bad[24+i*8], i%2 ? bad.size()+1 : 3, 8); // За концом / внутри таблицы
+            RCFS_CHECK(!decodeChunkedData(decoded.data(), decoded.size(), bad.data(), bad.size(), codecChainChunkedLz, 0, 0, 0, 3));
+        }
+
+        for(int iter=0; iter!=300; ++iter)
+        {
+            std::vector<std::uint8_t> bad = encoded;
+            bad[24+6*8+rng()%(bad.size()-24-6*8)] ^= (std::uint8_t)(1+rng()%255);
+            decodeChunkedData(decoded.data(), decoded.size(), bad.data(), bad.size(), codecChainChunkedLz, 0, 0, 0, 2);
+
+            std::vector<std::uint8_t> range(777);
+            decodeChunkedRange(range.data(), bad.data(), bad.size(), codecChainChunkedLz, rng()%(20000-777), range.size(), 0, 0, 0);
+        }
+
+        // Обрезанный контейнер
+        for(std::size_t cut=0; cut<encoded.size(); cut+=97)
+            RCFS_CHECK(!decodeChunkedData(decoded.data(), decoded.size(), encoded.data(), cut, codecChainChunkedLz, 0, 0, 0));
+    }
+
+    // Через ФС: контейнер читается по диапазонам без декодирования целиком
+    {
+        std::vector<std::uint8_t> encoded;
+        encodeChunkedData(encoded, data, codecChainChunkedXorLz, 4, 0xCAFE, 0xBABE, 8192);
+
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        RCFS_CHECK(rcfs.createFile("big.bin"));
+        RCFS_CHECK(rcfs.setFileData("big.bin", encoded.data(), encoded.size(), 4, 0xCAFE, 0xBABE, codecChainChunkedXorLz));
+        rcfs.setRangeDecodeMode(true);
+
+        RCFS_CHECK(rcfs.getFileSize("big.bin")==data.size());
+
+        int iFile = rcfs.openFile("big.bin");
+        std::uint8_t buf[1000];
+        std::size_t nReaded = 0;
+        RCFS_CHECK(rcfs.preadFile(iFile, 123456, buf, sizeof(buf), &nReaded) && nReaded==sizeof(buf));
+        RCFS_CHECK(std::equal(buf, buf+sizeof(buf), data.begin()+123456));
+        RCFS_CHECK(rcfs.closeFile(iFile));
+
+        // Мелкие последовательные чтения - кусок декодируется в кэш дескриптора
+        iFile = rcfs.openFile("big.bin");
+        std::vector<std::uint8_t> seqRead;
+        for(std::size_t pos=0; pos<data.size(); pos+=sizeof(buf))
+        {
+            RCFS_CHECK(rcfs.preadFile(iFile, pos, buf, sizeof(buf), &nReaded) && nReaded==std::min(sizeof(buf), data.size()-pos));
+            seqRead.insert(seqRead.end(), buf, buf+nReaded);
+        }
+        RCFS_CHECK(seqRead==data);
+
+        #if defined(MARTY_RCFS_THREAD_SAFE)
+        // Параллельные чтения одного дескриптора - кэш захватывает один поток, остальные декодируют во временный буфер
+        {
+            std::atomic<int> numBad = 0;
+            std::vector<std::thread> threads;
+            for(unsigned t=0; t!=4; ++t)
+            {
+                threads.emplace_back([&, t]()
+                {
+                    std::uint8_t tbuf[777];
+                    std::size_t  tReaded = 0;
+                    for(std::size_t pos=t*1000; pos+sizeof(tbuf)<=data.size(); pos+=4*1000)
+                    {
+                        if (!rcfs.preadFile(iFile, pos, tbuf, sizeof(tbuf), &tReaded) || tReaded!=sizeof(tbuf) || !std::equal(tbuf, tbuf+sizeof(tbuf), data.begin()+pos))
+                            ++numBad;
+                    }
+                });
+            }
+            for(auto &th : threads)
+                th.join();
+            RCFS_CHECK(numBad==0);
+        }
+        #endif
+
+        RCFS_CHECK(rcfs.closeFile(iFile));
+    }
+
+    // Другие данные по тому же адресу и с тем же размером и ключом не читаются из кэша прежнего файла
+    {
+        const unsigned chain = makeCodecChain(CodecStage::Chunked, CodecStage::Xor); // Без сжатия - размер контейнера не зависит от данных
+
+        std::vector<std::uint8_t> other(data.size());
+        for(std::size_t i=0; i!=other.size(); ++i)
+            other[i] = (std::uint8_t)(data[i]^0x5A);
+
+        std::vector<std::uint8_t> encoded, encodedOther;
+        encodeChunkedData(encoded     , data , chain, 2, 0x1234, 0x5678, 4096);
+        encodeChunkedData(encodedOther, other, chain, 2, 0x1234, 0x5678, 4096);
+        RCFS_CHECK(encoded.size()==encodedOther.size());
+
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        rcfs.setRangeDecodeMode(true);
+        RCFS_CHECK(rcfs.createFile("a.bin"));
+        RCFS_CHECK(rcfs.setFileData("a.bin", encoded.data(), encoded.size(), 2, 0x1234, 0x5678, chain));
+
+        std::uint8_t buf[100];
+        std::size_t nReaded = 0;
+        int iFile = rcfs.openFile("a.bin");
+        RCFS_CHECK(rcfs.preadFile(iFile, 5000, buf, sizeof(buf), &nReaded) && std::equal(buf, buf+sizeof(buf), data.begin()+5000));
+        RCFS_CHECK(rcfs.closeFile(iFile));
+
+        encoded = encodedOther; // Тот же буфер - тот же адрес, a.bin больше не читается
+        RCFS_CHECK(rcfs.createFile("b.bin"));
+        RCFS_CHECK(rcfs.setFileData("b.bin", encoded.data(), encoded.size(), 2, 0x1234, 0x5678, chain));
+
+        iFile = rcfs.openFile("b.bin");
+        RCFS_CHECK(rcfs.preadFile(iFile, 5000, buf, sizeof(buf), &nReaded) && std::equal(buf, buf+sizeof(buf), other.begin()+5000));
+        RCFS_CHECK(rcfs.closeFile(iFile));
+
+        // Без кэша и с кэшем вне ФС
+        chunked_utils::ChunkCache cache;
+        RCFS_CHECK(decodeChunkedRange(buf, encoded.data(), encoded.size(), chain, 5000, sizeof(buf), 2, 0x1234, 0x5678, &cache) && std::equal(buf, buf+sizeof(buf), other.begin()+5000));
+        RCFS_CHECK(cache.chunkIdx==1);
+        RCFS_CHECK(decodeChunkedRange(buf, encoded.data(), encoded.size(), chain, 5100, sizeof(buf), 2, 0x1234, 0x5678, &cache) && std::equal(buf, buf+sizeof(buf), other.begin()+5100));
+    }
+
+    return marty_rcfs_test::report("test_chunked");
+}
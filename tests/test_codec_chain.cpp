@@ -0,0 +1,87 @@
+//----------------------------------------------------------------------------
+//! \file Цепочки кодеков: кодирование и декодирование, декодирование в буфер, размер без декодирования, ошибки
+
+#include "../rcfs_codec_chain.h"
+#include "rcfs_test.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+static const unsigned keySeed = 0x2468ACE1, keyInc = 0x11111111;
+
+//----------------------------------------------------------------------------
+static
+void checkChain(unsigned codecChain, unsigned keySize, const std::vector<std::uint8_t> &plain)
+{
+    std::vector<std::uint8_t> encoded;
+    encodeCodecChain(encoded, plain.data(), plain.size(), codecChain, keySize, keySeed, keyInc);
+
+    RCFS_CHECK(getCodecChainDecodedSize(encoded.data(), encoded.size(), codecChain, keySize, keySeed, keyInc)==plain.size());
+
+    std::vector<std::uint8_t> decoded(3, 0xFF); // Содержимое и ёмкость затираются
+    RCFS_CHECK(decodeCodecChain(decoded, encoded.data(), encoded.size(), codecChain, keySize, keySeed, keyInc)==(codecChain!=codecChainDefault));
+    if (codecChain!=codecChainDefault)
+        RCFS_CHECK(decoded==plain);
+
+    std::vector<std::uint8_t> direct(plain.size()+1);
+    RCFS_CHECK(decodeCodecChainTo(direct.data(), plain.size(), encoded.data(), encoded.size(), codecChain, keySize, keySeed, keyInc));
+    RCFS_CHECK(std::equal(plain.begin(), plain.end(), direct.begin()));
+
+    // Другой размер приёмника - false, без выхода за его границы
+    if (!plain.empty())
+        RCFS_CHECK(!decodeCodecChainTo(direct.data(), plain.size()-1, encoded.data(), encoded.size(), codecChain, keySize, keySeed, keyInc));
+    RCFS_CHECK(!decodeCodecChainTo(direct.data(), plain.size()+1, encoded.data(), encoded.size(), codecChain, keySize, keySeed, keyInc));
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    std::vector<std::uint8_t> text, noise, empty;
+    for(std::size_t i=0; i!=40000; ++i)
+        text.push_back((std::uint8_t)"abcabcabd, resource text; "[i%26]);
+
+    std::uint32_t rnd = 1;
+    for(std::size_t i=0; i!=5000; ++i)
+    {
+        rnd = rnd*1103515245u + 12345u;
+        noise.push_back((std::uint8_t)(rnd>>24));
+    }
+
+    const unsigned xorLzXor = makeCodecChain(CodecStage::Xor, CodecStage::Lz, CodecStage::Xor); // Общий путь, по стадиям
+
+    for(const std::vector<std::uint8_t> *pData : { &text, &noise, &empty })
+    {
+        for(unsigned keySize : { 1u, 2u, 4u })
+        {
+            checkChain(codecChainDefault, keySize, *pData);
+            checkChain(codecChainXor    , keySize, *pData);
+            checkChain(codecChainXorLz  , keySize, *pData);
+        }
+        checkChain(codecChainLz, 0, *pData);
+
+        std::vector<std::uint8_t> encoded, decoded;
+        encodeCodecChain(encoded, pData->data(), pData->size(), xorLzXor, 2, keySeed, keyInc);
+        RCFS_CHECK(decodeCodecChain(decoded, encoded.data(), encoded.size(), xorLzXor, 2, keySeed, keyInc) && decoded==*pData);
+        RCFS_CHECK(getCodecChainDecodedSize(encoded.data(), encoded.size(), xorLzXor, 2, keySeed, keyInc)==(std::size_t)-1);
+    }
+
+    // Сжатие работает
+    std::vector<std::uint8_t> encoded, decoded;
+    encodeCodecChain(encoded, text.data(), text.size(), codecChainLz, 0, 0, 0);
+    RCFS_CHECK(encoded.size()<text.size()/10);
+
+    // Повреждённые данные и недопустимые параметры - исключение
+    encoded.resize(encoded.size()/2);
+    RCFS_CHECK_THROWS(decodeCodecChain(decoded, encoded.data(), encoded.size(), codecChainLz, 0, 0, 0));
+    RCFS_CHECK(!decodeCodecChainTo(decoded.data(), text.size(), encoded.data(), encoded.size(), codecChainLz, 0, 0, 0));
+
+    RCFS_CHECK_THROWS(encodeCodecChain(encoded, text.data(), text.size(), codecChainXor, 3, keySeed, keyInc));
+    RCFS_CHECK_THROWS(decodeCodecChain(decoded, text.data(), text.size(), codecChainXor, 3, keySeed, keyInc));
+    RCFS_CHECK_THROWS(decodeCodecChain(decoded, text.data(), text.size(), 0xF, 0, 0, 0));
+
+    return marty_rcfs_test::report("test_codec_chain");
+}
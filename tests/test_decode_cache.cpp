@@ -0,0 +1,102 @@
+//----------------------------------------------------------------------------
+//! \file Кэш декодированных данных: бюджет, вытеснение LRU со вторым шансом, открытые файлы не вытесняются, trim, счётчики
+
+#include "rcfs_test_files.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_test;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::vector<TestFile> files = makeTestFiles();
+
+    {
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        addTestFiles(rcfs, files);
+
+        RCFS_CHECK(rcfs.getDecodeCacheBudget()==MARTY_RCFS_DECODE_CACHE_BUDGET);
+
+        // Бюджет больше самого большого файла - открытый файл при вставке не вытесняется
+        rcfs.setDecodeCacheBudget(100000);
+        RCFS_CHECK(rcfs.getDecodeCacheBudget()==100000);
+
+        for(const auto &f : files)
+            RCFS_CHECK(readAndCompare(rcfs, f));
+
+        DecodeCacheStats stats = rcfs.getDecodeCacheStats();
+        RCFS_CHECK(stats.numMisses==5);
+        RCFS_CHECK(stats.bytesCached<=100000);
+        RCFS_CHECK(stats.numEvictions>0 && stats.bytesEvicted>0);
+        RCFS_CHECK(stats.budgetBytes==100000);
+
+        // Уменьшение бюджета сразу вытесняет лишнее
+        rcfs.setDecodeCacheBudget(10000);
+        RCFS_CHECK(rcfs.getDecodeCacheStats().bytesCached<=10000);
+
+        // Вытесненный файл декодируется заново
+        RCFS_CHECK(readAndCompare(rcfs, files[3]));
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==6);
+    }
+
+    {
+        // trim: открытый файл не вытесняется, его данные остаются доступны
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        addTestFiles(rcfs, files);
+
+        for(const auto &f : files)
+            RCFS_CHECK(readAndCompare(rcfs, f));
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numCached==5);
+
+        int iFile = rcfs.openFile(files[4].name);
+        const std::size_t bytesFreed = rcfs.trimDecodeCache(0);
+        RCFS_CHECK(bytesFreed>0);
+
+        const DecodeCacheStats stats = rcfs.getDecodeCacheStats();
+        RCFS_CHECK(stats.numCached==1 && stats.bytesCached>=files[4].plain.size());
+        RCFS_CHECK(stats.bytesEvicted==bytesFreed && stats.numEvictions==4);
+
+        FileView view = rcfs.getFileView(iFile);
+        RCFS_CHECK(std::equal(view.begin(), view.end(), files[4].plain.begin(), files[4].plain.end()));
+        RCFS_CHECK(rcfs.closeFile(iFile));
+
+        RCFS_CHECK(rcfs.trimDecodeCache(0)>0); // Закрыт - теперь вытесняется
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numCached==0);
+        RCFS_CHECK(rcfs.trimDecodeCache(0)==0);
+    }
+
+    {
+        // Второй шанс: файл, открытый с прошлого вытеснения, переносится в начало списка
+        std::vector<TestFile> sameSize;
+        for(const char *name : { "a.bin", "b.bin", "c.bin" })
+            sameSize.push_back(makeTestFile(name, codecChainLz, 0, 10000));
+
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        addTestFiles(rcfs, sameSize);
+        rcfs.setDecodeCacheBudget(25000); // Помещаются два файла
+
+        RCFS_CHECK(readAndCompare(rcfs, sameSize[0]));
+        RCFS_CHECK(readAndCompare(rcfs, sameSize[1]));
+        RCFS_CHECK(readAndCompare(rcfs, sameSize[0])); // a - давно декодирован, но снова использован
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numHits==1);
+
+        RCFS_CHECK(readAndCompare(rcfs, sameSize[2])); // Вытесняется b, а не a
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numEvictions==1);
+
+        const std::size_t missesBefore = rcfs.getDecodeCacheStats().numMisses;
+        RCFS_CHECK(readAndCompare(rcfs, sameSize[0]));
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==missesBefore);
+        RCFS_CHECK(readAndCompare(rcfs, sameSize[1]));
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==missesBefore+1);
+    }
+
+    return marty_rcfs_test::report("test_decode_cache");
+}
@@ -0,0 +1,117 @@
+//----------------------------------------------------------------------------
+//! \file Однократное декодирование: повторные открытия без декодирования, одновременные открытия, warmUp в несколько потоков с бюджетом кэша
+
+#include "rcfs_test_files.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_test;
+
+//----------------------------------------------------------------------------
+//! Считает вызовы декодирования - повторных декодирований быть не должно
+struct CountingDecoder : public CodecChainFileDecoder
+{
+    mutable std::atomic<std::size_t> numDecodes{0};
+
+    bool decodeFileDataChain( std::vector<std::uint8_t> &decodedData
+                            , const std::uint8_t *pFileData
+                            , std::size_t          fileSize
+                            , unsigned codecChain
+                            , unsigned decryptKeySize
+                            , unsigned decryptKeySeed
+                            , unsigned decryptKeyInc
+                            ) const override
+    {
+        ++numDecodes;
+        return CodecChainFileDecoder::decodeFileDataChain(decodedData, pFileData, fileSize, codecChain, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+};
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::vector<TestFile> files = makeTestFiles();
+
+    {
+        // Каждый файл декодируется один раз, повторные открытия - попадания
+        CountingDecoder    decoder;
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, &decoder);
+        addTestFiles(rcfs, files);
+        rcfs.seal();
+
+        for(int round=0; round!=3; ++round)
+        {
+            for(const auto &f : files)
+                RCFS_CHECK(readAndCompare(rcfs, f));
+        }
+
+        const DecodeCacheStats stats = rcfs.getDecodeCacheStats();
+        RCFS_CHECK(stats.numMisses==5);  // Все закодированные, кроме пустого
+        RCFS_CHECK(stats.numHits==10);
+        RCFS_CHECK(stats.numWaits==0);
+        RCFS_CHECK(decoder.numDecodes==6); // И plain.txt - декодер один раз сообщает, что декодирование не требуется
+    }
+
+    #if defined(MARTY_RCFS_THREAD_SAFE)
+    {
+        // Одновременное открытие одного файла: декодирует один поток, остальные ждут
+        CountingDecoder    decoder;
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, &decoder);
+        addTestFiles(rcfs, files);
+        rcfs.seal();
+
+        std::atomic<std::size_t> numBad{0};
+        std::vector<std::thread> threads;
+        for(int t=0; t!=8; ++t)
+            threads.emplace_back([&]() { if (!readAndCompare(rcfs, files[5])) ++numBad; });
+        for(auto &thread : threads)
+            thread.join();
+
+        RCFS_CHECK(numBad==0);
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==1);
+        RCFS_CHECK(decoder.numDecodes==1);
+    }
+    #endif
+
+    {
+        // warmUp в несколько потоков, пока его же потоки вытесняют файлы по бюджету - в любой сборке
+        std::vector<TestFile> many;
+        for(std::size_t i=0; i!=256; ++i)
+            many.push_back(makeTestFile("many/file_" + std::to_string(i) + ".bin", codecChainXorLz, 2, 3000+i));
+
+        CountingDecoder    decoder;
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, &decoder);
+        addTestFiles(rcfs, many);
+        rcfs.seal();
+
+        const std::size_t budget = 200000;
+        rcfs.setDecodeCacheBudget(budget);
+
+        for(int round=0; round!=4; ++round)
+        {
+            const std::size_t cachedBefore = rcfs.getDecodeCacheStats().numCached;
+
+            const WarmUpStats warm = rcfs.warmUp(8);
+            RCFS_CHECK(warm.numFiles==many.size());
+            RCFS_CHECK(warm.numDecoded>=many.size()-cachedBefore && warm.numDecoded<=many.size());
+
+            const DecodeCacheStats stats = rcfs.getDecodeCacheStats();
+            RCFS_CHECK(stats.bytesCached<=budget);
+            RCFS_CHECK(stats.numMisses==decoder.numDecodes);
+        }
+
+        for(const auto &f : many)
+            RCFS_CHECK(readAndCompare(rcfs, f));
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==decoder.numDecodes);
+    }
+
+    return marty_rcfs_test::report("test_decode_once");
+}
@@ -0,0 +1,98 @@
+//----------------------------------------------------------------------------
+//! \file Декодирование сразу в буфер вызывающего: readFileTo, пакетное чтение с копированием, IFileDecoder::decodeFileDataTo
+
+#include "rcfs_test_files.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_test;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::vector<TestFile> files = makeTestFiles();
+
+    {
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        addTestFiles(rcfs, files);
+        rcfs.seal();
+
+        // Сразу в приёмник, минуя кэш декодированных данных
+        for(const auto &f : files)
+        {
+            std::vector<std::uint8_t> buf(f.plain.size()+10);
+            std::size_t nReaded = 0;
+            RCFS_CHECK(rcfs.readFileTo(rcfs.resolve(f.name), buf.data(), buf.size(), &nReaded));
+            RCFS_CHECK(nReaded==f.plain.size() && std::equal(f.plain.begin(), f.plain.end(), buf.begin()));
+
+            // Буфер меньше файла - ничего не читается
+            if (!f.plain.empty())
+                RCFS_CHECK(!rcfs.readFileTo(rcfs.resolve(f.name), buf.data(), f.plain.size()-1, &nReaded));
+        }
+
+        RCFS_CHECK(!rcfs.readFileTo(rcfs.resolve("data/missing.bin"), 0, 0, 0));
+
+        DecodeCacheStats stats = rcfs.getDecodeCacheStats();
+        RCFS_CHECK(stats.numCached==0 && stats.numMisses==0);
+
+        // Пакет с копированием - тоже минуя кэш
+        std::vector<std::string_view> paths;
+        for(const auto &f : files)
+            paths.push_back(f.name);
+        paths.push_back("data/missing.bin");
+
+        ResourceBatch batch;
+        RCFS_CHECK(!rcfs.readBatch(paths.data(), paths.size(), batch, true)); // Не все найдены
+        for(std::size_t i=0; i!=files.size(); ++i)
+            RCFS_CHECK(std::equal(batch[i].view.begin(), batch[i].view.end(), files[i].plain.begin(), files[i].plain.end()));
+
+        const BatchReadStats &batchStats = batch.getStats();
+        RCFS_CHECK(batchStats.numRequested==files.size()+1 && batchStats.numFound==files.size());
+        RCFS_CHECK(batchStats.numCopied==files.size());
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numCached==0);
+
+        // Без копирования - через кэш
+        ResourceBatch viewBatch;
+        RCFS_CHECK(rcfs.readBatch(paths.data(), files.size(), viewBatch));
+        RCFS_CHECK(viewBatch.getStats().numDecoded==5);
+        RCFS_CHECK(std::equal(viewBatch[3].view.begin(), viewBatch[3].view.end(), files[3].plain.begin(), files[3].plain.end()));
+
+        // Уже декодированный файл копируется из кэша
+        std::vector<std::uint8_t> buf(files[3].plain.size());
+        std::size_t nReaded = 0;
+        RCFS_CHECK(rcfs.readFileTo(rcfs.resolve(files[3].name), buf.data(), buf.size(), &nReaded) && buf==files[3].plain);
+    }
+
+    {
+        // Декодеры напрямую: decodeFileDataTo для каждой цепочки
+        const CodecChainFileDecoder chainDecoder(2);
+        for(const auto &f : files)
+        {
+            std::vector<std::uint8_t> out(f.plain.size());
+            const bool decoded = chainDecoder.decodeFileDataTo(out.data(), out.size(), f.stored.data(), f.stored.size(), f.codecChain, f.keySize, testKeySeed, testKeyInc);
+            RCFS_CHECK(decoded==f.encoded());
+            if (decoded)
+                RCFS_CHECK(out==f.plain);
+
+            RCFS_CHECK(chainDecoder.getDecodedSizeChain(f.stored.data(), f.stored.size(), f.codecChain, f.keySize, testKeySeed, testKeyInc)==f.plain.size());
+        }
+
+        std::vector<std::uint8_t> small(10);
+        RCFS_CHECK_THROWS(chainDecoder.decodeFileDataTo(small.data(), small.size(), files[3].stored.data(), files[3].stored.size(), codecChainLz, 0, 0, 0));
+
+        const LzFileDecoder lzDecoder;
+        std::vector<std::uint8_t> lzOut(files[3].plain.size());
+        RCFS_CHECK(lzDecoder.decodeFileDataTo(lzOut.data(), lzOut.size(), files[3].stored.data(), files[3].stored.size(), codecChainDefault, 0, 0, 0));
+        RCFS_CHECK(lzOut==files[3].plain);
+
+        RCFS_CHECK(!getDefaultNoDecodeFileDecoder()->decodeFileDataTo(lzOut.data(), lzOut.size(), files[0].stored.data(), files[0].stored.size(), codecChainDefault, 0, 0, 0));
+    }
+
+    return marty_rcfs_test::report("test_decode_to");
+}
@@ -0,0 +1,95 @@
+//----------------------------------------------------------------------------
+//! \file Размер декодированных данных по метаданным: statFile и getFileSize не открывают и не декодируют файл
+
+#include "rcfs_test_files.h"
+
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_test;
+
+//----------------------------------------------------------------------------
+//! Декодер без getDecodedSize - размер известен только после декодирования
+struct SizeUnknownXorDecoder : public IFileDecoder
+{
+    bool decodeFileData( std::vector<std::uint8_t> &decodedData
+                       , const std::uint8_t *pFileData
+                       , std::size_t          fileSize
+                       , unsigned decryptKeySize
+                       , unsigned decryptKeySeed
+                       , unsigned decryptKeyInc
+                       ) const override
+    {
+        if (!decryptKeySize)
+            return false;
+
+        decodedData.resize(fileSize);
+        return xorDecodeData(decodedData.data(), pFileData, fileSize, decryptKeySize, decryptKeySeed, decryptKeyInc);
+    }
+};
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::vector<TestFile> files = makeTestFiles();
+
+    {
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        addTestFiles(rcfs, files);
+        rcfs.seal();
+
+        for(const auto &f : files)
+        {
+            FileStat st;
+            RCFS_CHECK(rcfs.statFile(f.name, st));
+            RCFS_CHECK(st.size==f.plain.size() && st.storedSize==f.stored.size());
+            RCFS_CHECK(st.encoded==(f.encoded() && !f.stored.empty()));
+            RCFS_CHECK(!st.staticEntry);
+
+            RCFS_CHECK(rcfs.getFileSize(f.name)==f.plain.size());
+            RCFS_CHECK(rcfs.getFileSize(rcfs.resolve(f.name))==f.plain.size());
+        }
+
+        FileStat st;
+        RCFS_CHECK(!rcfs.statFile("data/missing.bin", st));
+        RCFS_CHECK(!rcfs.statFile("data", st)); // Каталог
+        RCFS_CHECK(rcfs.getFileSize("data/missing.bin")==(std::size_t)-1);
+
+        // Ничего не декодировано
+        const DecodeCacheStats stats = rcfs.getDecodeCacheStats();
+        RCFS_CHECK(stats.numMisses==0 && stats.numCached==0);
+    }
+
+    {
+        // Декодер не сообщает размер: statFile - неизвестен, getFileSize декодирует
+        SizeUnknownXorDecoder decoder;
+
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, &decoder);
+        addTestFiles(rcfs, files); // ФС не владеет данными - регистрируем из files
+
+        FileStat st;
+        RCFS_CHECK(rcfs.statFile(files[1].name, st) && st.size==(std::size_t)-1 && st.encoded);
+        RCFS_CHECK(rcfs.getFileSize(files[1].name)==files[1].plain.size());
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==1);
+
+        // Смена декодера пересчитывает размеры в записях
+        rcfs.setFileDecoder(getDefaultCodecChainFileDecoder());
+        RCFS_CHECK(rcfs.statFile(files[1].name, st) && st.size==files[1].plain.size());
+    }
+
+    {
+        // Без декодера - размер хранимых данных
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root);
+        addTestFiles(rcfs, files);
+
+        FileStat st;
+        RCFS_CHECK(rcfs.statFile(files[3].name, st) && st.size==files[3].stored.size());
+    }
+
+    return marty_rcfs_test::report("test_decoded_size");
+}
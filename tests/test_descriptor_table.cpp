@@ -0,0 +1,116 @@
+//----------------------------------------------------------------------------
+//! \file Таблица дескрипторов: устаревшие дескрипторы, порядок переиспользования слотов, переход в другие шарды
+
+// Маленькая таблица: 4 шарда по 256 слотов
+#define MARTY_RCFS_DESCRIPTOR_INDEX_BITS     10
+#define MARTY_RCFS_DESCRIPTOR_SHARD_BITS     2
+
+#include "../rcfs_descriptor_table.h"
+#include "rcfs_test.h"
+
+#include <set>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+typedef DescriptorTable<int>    TableType;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    {
+        TableType table;
+
+        int d1 = table.allocate(1);
+        int d2 = table.allocate(2);
+        RCFS_CHECK(d1>0 && d2>0 && d1!=d2);
+        RCFS_CHECK(table.find(d1) && *table.find(d1)==1);
+        RCFS_CHECK(table.find(d2) && *table.find(d2)==2);
+        RCFS_CHECK(table.size()==2);
+
+        int released = 0;
+        RCFS_CHECK(table.release(d1, &released) && released==1);
+        RCFS_CHECK(!table.release(d1));        // Повторное закрытие
+        RCFS_CHECK(table.find(d1)==0);         // Устаревший дескриптор
+        RCFS_CHECK(table.find(0)==0 && table.find(-1)==0);
+        RCFS_CHECK(table.size()==1);
+
+        // Новый дескриптор на месте закрытого - другое поколение, старый не оживает
+        int d3 = table.allocate(3);
+        RCFS_CHECK(d3!=d1);
+        RCFS_CHECK(table.find(d1)==0);
+        RCFS_CHECK(table.find(d3) && *table.find(d3)==3);
+        RCFS_CHECK(table.release(d2) && table.release(d3));
+        RCFS_CHECK(table.size()==0);
+    }
+
+    {
+        // Свободные слоты выдаются в порядке освобождения: закрытый слот уходит в конец очереди
+        TableType table;
+
+        std::vector<int> descriptors;
+        for(int i=0; i!=8; ++i)
+            descriptors.push_back(table.allocate(i));
+
+        const std::uint32_t slotMask = TableType::indexMask;
+        for(int d : descriptors)
+            RCFS_CHECK(table.release(d));
+
+        int first = table.allocate(100);
+        RCFS_CHECK(((std::uint32_t)first & slotMask)==((std::uint32_t)descriptors[0] & slotMask));
+        RCFS_CHECK(table.release(first));
+
+        int second = table.allocate(101);
+        RCFS_CHECK(((std::uint32_t)second & slotMask)==((std::uint32_t)descriptors[1] & slotMask));
+        RCFS_CHECK(table.release(second));
+    }
+
+    {
+        // Поколение повторяется по кругу: с единственным слотом - через generationMask закрытий
+        TableType table;
+
+        int d = table.allocate(1);
+        RCFS_CHECK(table.release(d));
+
+        int again = -1;
+        for(std::uint32_t i=0; i!=TableType::generationMask; ++i)
+        {
+            again = table.allocate(1);
+            RCFS_CHECK(again>0);
+            RCFS_CHECK(table.release(again));
+        }
+        RCFS_CHECK(again==d);
+    }
+
+    {
+        // Шард текущего потока заполнен - слоты берутся в остальных; предел - вся таблица
+        TableType table;
+
+        const std::size_t totalSlots = (std::size_t)TableType::numShards*TableType::maxShardSlots;
+
+        std::set<int> descriptors;
+        std::set<std::uint32_t> shards;
+        for(std::size_t i=0; i!=totalSlots; ++i)
+        {
+            int d = table.allocate((int)i);
+            RCFS_CHECK(d>0);
+            descriptors.insert(d);
+            shards.insert((std::uint32_t)d & (TableType::numShards-1));
+        }
+
+        RCFS_CHECK(descriptors.size()==totalSlots);
+        RCFS_CHECK(shards.size()==TableType::numShards);
+        RCFS_CHECK(table.size()==totalSlots);
+        RCFS_CHECK(table.allocate(-1)==-1);
+
+        // Освободили слот в чужом шарде - он снова доступен
+        int last = *descriptors.rbegin();
+        RCFS_CHECK(table.release(last));
+        int reused = table.allocate(7);
+        RCFS_CHECK(reused>0 && table.find(reused) && *table.find(reused)==7);
+        RCFS_CHECK(table.allocate(-1)==-1);
+    }
+
+    return marty_rcfs_test::report("test_descriptor_table");
+}
@@ -0,0 +1,81 @@
+//----------------------------------------------------------------------------
+//! \file Перечисление содержимого каталогов: по дереву и по диапазонам дочерних записей плоского индекса после seal
+
+#include "../rcfs_enumerate.h"
+#include "rcfs_test.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+static const std::uint8_t fileData[] = { 'd', 'a', 't', 'a' };
+
+//----------------------------------------------------------------------------
+//! Все элементы как "каталог|имя|D/F", отсортированные - порядок перечисления может зависеть от MARTY_RCFS_ORDERED
+static
+std::vector<std::string> enumerateAll(ResourceFileSystem &rcfs, const std::string &dirPath, bool recurse)
+{
+    std::vector<std::string> items;
+    enumerateDirectoryItems(&rcfs, dirPath, [&](const std::string &path, const FileInfo &fi)
+                            {
+                                const bool isDir = (fi.attrs&FileAttrs::FlagDirectory)!=0;
+                                items.emplace_back(path + "|" + fi.name + (isDir ? "|D" : "|F"));
+                                return true;
+                            }
+                           , recurse
+                           );
+    std::sort(items.begin(), items.end());
+    return items;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    DirectoryEntry     root;
+    ResourceFileSystem rcfs(false, &root);
+
+    for(const char *name : { "root.txt", "dir1/a.txt", "dir1/sub/b.txt", "dir1/sub/c.txt", "dir2/d.bin", "dir1/sub/deeper/e.bin" })
+    {
+        RCFS_CHECK(rcfs.createFile(name));
+        RCFS_CHECK(rcfs.setFileData(name, fileData, sizeof(fileData)));
+    }
+
+    const std::vector<std::string> treeAll  = enumerateAll(rcfs, "", true);
+    const std::vector<std::string> treeSub  = enumerateAll(rcfs, "dir1/sub", false);
+    const std::vector<std::string> treeRoot = enumerateAll(rcfs, "", false);
+
+    RCFS_CHECK(treeAll.size()==10);
+    RCFS_CHECK((treeSub==std::vector<std::string>{ "dir1/sub|b.txt|F", "dir1/sub|c.txt|F", "dir1/sub|deeper|D" }));
+    RCFS_CHECK(treeRoot.size()==3);
+
+    #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+    const FlatIndex::Record *pBegin = 0, *pEnd = 0;
+    RCFS_CHECK(!rcfs.findFlatIndexChildren("dir1", pBegin, pEnd)); // Индекса ещё нет
+    #endif
+
+    rcfs.seal();
+
+    // Запечатанная ФС перечисляется по плоскому индексу, результат тот же
+    #if !defined(MARTY_RCFS_DISABLE_FLAT_INDEX)
+    RCFS_CHECK(rcfs.findFlatIndexChildren("DIR1/Sub", pBegin, pEnd) && pEnd-pBegin==3);
+    RCFS_CHECK(rcfs.findFlatIndexChildren("", pBegin, pEnd) && pEnd-pBegin==3);
+    RCFS_CHECK(!rcfs.findFlatIndexChildren("dir1/a.txt", pBegin, pEnd)); // Файл, а не каталог
+    RCFS_CHECK(!rcfs.findFlatIndexChildren("missing", pBegin, pEnd));
+    #endif
+
+    RCFS_CHECK(enumerateAll(rcfs, "", true)==treeAll);
+    RCFS_CHECK(enumerateAll(rcfs, "dir1/sub", false)==treeSub);
+    RCFS_CHECK(enumerateAll(rcfs, "", false)==treeRoot);
+    RCFS_CHECK(enumerateAll(rcfs, "dir2/d.bin", false).empty());
+    RCFS_CHECK(!enumerateDirectoryItems(&rcfs, "missing", [](const std::string&, const FileInfo&) { return true; }));
+
+    // Обработчик прерывает перечисление
+    std::size_t numCalls = 0;
+    RCFS_CHECK(enumerateDirectoryItems(&rcfs, "dir1/sub", [&](const std::string&, const FileInfo&) { ++numCalls; return false; }, true));
+    RCFS_CHECK(numCalls==1);
+
+    return marty_rcfs_test::report("test_enumerate");
+}
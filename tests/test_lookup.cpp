@@ -0,0 +1,90 @@
+//----------------------------------------------------------------------------
+//! \file Поиск по дереву без аллокаций: компоненты ".", "..", разделители, регистр, индекс после seal, ResourceId
+
+#include "../rcfs.h"
+#include "rcfs_test.h"
+
+#include <string>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+static const std::uint8_t fileData[] = { 'd', 'a', 't', 'a' };
+
+//----------------------------------------------------------------------------
+static
+void addFile(ResourceFileSystem &rcfs, const std::string &name)
+{
+    RCFS_CHECK(rcfs.createFile(name));
+    RCFS_CHECK(rcfs.setFileData(name, fileData, sizeof(fileData)));
+}
+
+//----------------------------------------------------------------------------
+static
+void checkLookups(const ResourceFileSystem &rcfs, bool caseSens)
+{
+    DirectoryEntry *pFile = rcfs.findFileEntry("dir1/sub/file.txt");
+    RCFS_CHECK(pFile!=0);
+
+    RCFS_CHECK(rcfs.findFileEntry("/dir1/sub/file.txt")==pFile);
+    RCFS_CHECK(rcfs.findFileEntry("dir1\\sub\\file.txt")==pFile);
+    RCFS_CHECK(rcfs.findFileEntry("dir1//sub/./file.txt")==pFile);
+    RCFS_CHECK(rcfs.findFileEntry("dir1/other/../sub/file.txt")==pFile);
+    RCFS_CHECK(rcfs.findFileEntry("../../dir1/sub/file.txt")==pFile); // Выше корня не поднимаемся
+
+    if (caseSens)
+        RCFS_CHECK(rcfs.findFileEntry("DIR1/Sub/FILE.txt")==0);
+    else
+        RCFS_CHECK(rcfs.findFileEntry("DIR1/Sub/FILE.txt")==pFile);
+
+    RCFS_CHECK(rcfs.findFileEntry("dir1/sub")==0);           // Каталог, а не файл
+    RCFS_CHECK(rcfs.findDirectoryEntry("dir1/sub")!=0);
+    RCFS_CHECK(rcfs.findDirectoryEntry("dir1/sub/file.txt")==0);
+    RCFS_CHECK(rcfs.findFileEntry("dir1/sub/missing.txt")==0);
+    RCFS_CHECK(rcfs.findFileEntry("missing/sub/file.txt")==0);
+    RCFS_CHECK(rcfs.findFileEntry("root.txt")!=0);
+
+    // Слишком глубокий путь - поиск через splitPath, результат тот же
+    std::string deepPath;
+    for(int i=0; i!=MARTY_RCFS_MAX_PATH_DEPTH+4; ++i)
+        deepPath.append("x/../");
+    deepPath.append("dir1/sub/file.txt");
+    RCFS_CHECK(rcfs.findFileEntry(deepPath)==pFile);
+
+    // ResourceId
+    ResourceId id = rcfs.resolve("dir1/sub/file.txt");
+    RCFS_CHECK(id.valid());
+    RCFS_CHECK(id.getFileEntry()==pFile);
+    RCFS_CHECK(!rcfs.resolve("nope").valid());
+    RCFS_CHECK(rcfs.getFileSize(id)==sizeof(fileData));
+
+    int iFile = rcfs.openFile(id);
+    RCFS_CHECK(iFile>=0);
+    RCFS_CHECK(rcfs.getFileSize(iFile)==sizeof(fileData));
+    RCFS_CHECK(rcfs.closeFile(iFile));
+    RCFS_CHECK(!rcfs.closeFile(iFile));
+    RCFS_CHECK(rcfs.openFile(ResourceId())<0);
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    for(bool caseSens : { false, true })
+    {
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(caseSens, &root);
+
+        addFile(rcfs, "dir1/sub/file.txt");
+        addFile(rcfs, "dir1/sub2/file.txt");
+        addFile(rcfs, "dir2/a.bin");
+        addFile(rcfs, "root.txt");
+        RCFS_CHECK(!rcfs.createFile("dir2/a.bin")); // Уже есть
+
+        checkLookups(rcfs, caseSens); // Поиск по дереву
+
+        rcfs.seal();
+        checkLookups(rcfs, caseSens); // Поиск по плоскому индексу
+    }
+
+    return marty_rcfs_test::report("test_lookup");
+}
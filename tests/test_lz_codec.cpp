@@ -0,0 +1,160 @@
+//----------------------------------------------------------------------------
+//! \file LZ-кодек: сжатие/распаковка случайных, повторяющихся и пустых данных, XOR -> LZ за один проход, повреждённые данные
+
+#include "../rcfs.h"
+#include "../rcfs_file_decoders.h"
+#include "rcfs_test.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+static
+std::vector<std::uint8_t> makeData(std::mt19937 &rng, std::size_t size, int kind)
+{
+    std::vector<std::uint8_t> data(size);
+    static const char *words[] = { "resource", "directory", "file", "/", ".bin", " ", "\n", "marty_rcfs" };
+
+    for(std::size_t i=0; i!=size; )
+    {
+        switch(kind)
+        {
+            case 0 : data[i++] = (std::uint8_t)rng(); break;                       // Случайные - не сжимаются
+            case 1 : data[i++] = (std::uint8_t)'A'; break;                         // Один повторяющийся байт
+            case 2 : data[i] = (std::uint8_t)(i%7); ++i; break;                    // Короткий период - перекрывающиеся совпадения
+            default:                                                               // Текст из повторяющихся слов
+            {
+                const char *w = words[rng()%8];
+                for(; *w && i!=size; ++w)
+                    data[i++] = (std::uint8_t)*w;
+            }
+        }
+    }
+
+    return data;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    std::mt19937 rng(1);
+
+    const std::size_t sizes[] = { 0, 1, 3, 4, 5, 15, 16, 17, 31, 32, 33, 100, 255, 256, 1000, 4095, 4096, 4097, 70000, 300000 };
+
+    std::vector<std::uint8_t> compressed, decompressed, encoded;
+
+    for(std::size_t size : sizes)
+    {
+        for(int kind=0; kind!=4; ++kind)
+        {
+            const std::vector<std::uint8_t> data = makeData(rng, size, kind);
+
+            lzCompress(compressed, data);
+            RCFS_CHECK(lzIsCompressed(compressed.data(), compressed.size()));
+            RCFS_CHECK(lzGetDecompressedSize(compressed.data(), compressed.size())==size);
+
+            RCFS_CHECK(lzDecompress(decompressed, compressed.data(), compressed.size()));
+            RCFS_CHECK(decompressed==data);
+
+            if (kind!=0 && size>=1000)
+                RCFS_CHECK(compressed.size()<size/2);
+
+            // В буфер вызывающего и через совмещённое XOR -> LZ
+            std::vector<std::uint8_t> to(size);
+            RCFS_CHECK(decodeCodecChainTo(to.data(), to.size(), compressed.data(), compressed.size(), codecChainLz, 0, 0, 0));
+            RCFS_CHECK(to==data);
+
+            encodeCodecChain(encoded, data.data(), data.size(), codecChainXorLz, 2, 0x1234, 0x77);
+            std::fill(to.begin(), to.end(), 0);
+            RCFS_CHECK(decodeCodecChainTo(to.data(), to.size(), encoded.data(), encoded.size(), codecChainXorLz, 2, 0x1234, 0x77));
+            RCFS_CHECK(to==data);
+
+            RCFS_CHECK(decodeCodecChain(decompressed, encoded.data(), encoded.size(), codecChainXorLz, 2, 0x1234, 0x77));
+            RCFS_CHECK(decompressed==data);
+        }
+    }
+
+    // Не сжатые данные не трогаются
+    {
+        const std::uint8_t plain[] = { 'p', 'l', 'a', 'i', 'n' };
+        RCFS_CHECK(!lzIsCompressed(plain, sizeof(plain)));
+        RCFS_CHECK(!lzDecompress(decompressed, plain, sizeof(plain)));
+        RCFS_CHECK(lzGetDecompressedSize(plain, sizeof(plain))==(std::size_t)-1);
+
+        LzFileDecoder decoder;
+        RCFS_CHECK(!decoder.decodeFileData(decompressed, plain, sizeof(plain), 0, 0, 0));
+        RCFS_CHECK(decoder.getDecodedSize(plain, sizeof(plain), 0, 0, 0)==sizeof(plain));
+    }
+
+    // Повреждённые данные: false (или исключение у decodeCodecChain), но не выход за буфер
+    {
+        const std::vector<std::uint8_t> data = makeData(rng, 5000, 3);
+        lzCompress(compressed, data);
+        encodeCodecChain(encoded, data.data(), data.size(), codecChainXorLz, 4, 0xABCDEF01, 0x13579BDF);
+
+        // Обрезанные в каждой точке
+        for(std::size_t cut=0; cut<compressed.size(); cut+=(cut<64 ? 1 : 7))
+        {
+            RCFS_CHECK(!lzDecompress(decompressed, compressed.data(), cut));
+
+            std::vector<std::uint8_t> to(data.size());
+            RCFS_CHECK(!decodeCodecChainTo(to.data(), to.size(), compressed.data(), cut, codecChainLz, 0, 0, 0));
+            RCFS_CHECK(!decodeCodecChainTo(to.data(), to.size(), encoded.data(), cut, codecChainXorLz, 4, 0xABCDEF01, 0x13579BDF));
+        }
+
+        // Испорченные байты после заголовка
+        for(int iter=0; iter!=2000; ++iter)
+        {
+            std::vector<std::uint8_t> bad = compressed;
+            const std::size_t numFlips = 1+rng()%4;
+            for(std::size_t i=0; i!=numFlips; ++i)
+                bad[16+rng()%(bad.size()-16)] ^= (std::uint8_t)(1+rng()%255);
+
+            if (lzDecompress(decompressed, bad.data(), bad.size()))
+                RCFS_CHECK(decompressed.size()==data.size()); // Могло и распаковаться - тогда в размер из заголовка
+
+            std::vector<std::uint8_t> badXor = encoded;
+            for(std::size_t i=0; i!=numFlips; ++i)
+                badXor[16+rng()%(badXor.size()-16)] ^= (std::uint8_t)(1+rng()%255);
+
+            std::vector<std::uint8_t> to(data.size());
+            decodeCodecChainTo(to.data(), to.size(), badXor.data(), badXor.size(), codecChainXorLz, 4, 0xABCDEF01, 0x13579BDF);
+        }
+
+        // Размер в заголовке не совпадает с данными
+        std::vector<std::uint8_t> bigger = compressed;
+        bigger[8] ^= 1;
+        RCFS_CHECK(!lzDecompress(decompressed, bigger.data(), bigger.size()));
+
+        std::vector<std::uint8_t> huge = compressed;
+        for(unsigned i=8; i!=16; ++i)
+            huge[i] = 0xFF;
+        RCFS_CHECK(!lzDecompress(decompressed, huge.data(), huge.size()));
+
+        // Мусор с правильным заголовком
+        for(int iter=0; iter!=500; ++iter)
+        {
+            std::vector<std::uint8_t> garbage(16+rng()%200);
+            for(auto &b : garbage)
+                b = (std::uint8_t)rng();
+            std::copy(compressed.begin(), compressed.begin()+16, garbage.begin());
+            garbage[8] = (std::uint8_t)rng(); garbage[9] = 0;
+            for(unsigned i=10; i!=16; ++i)
+                garbage[i] = 0;
+
+            lzDecompress(decompressed, garbage.data(), garbage.size());
+        }
+
+        // Пустые данные со сжатым размером 0 и без последовательностей
+        std::vector<std::uint8_t> empty;
+        lzCompress(compressed, empty);
+        RCFS_CHECK(lzDecompress(decompressed, compressed.data(), compressed.size()) && decompressed.empty());
+        RCFS_CHECK(decodeCodecChainTo(0, 0, compressed.data(), compressed.size(), codecChainLz, 0, 0, 0));
+        RCFS_CHECK(decodeCodecChainTo(0, 0, compressed.data(), 0, codecChainDefault, 0, 0, 0));
+    }
+
+    return marty_rcfs_test::report("test_lz_codec");
+}
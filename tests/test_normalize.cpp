@@ -0,0 +1,103 @@
+//----------------------------------------------------------------------------
+//! \file Нормализация имён (векторный и скалярный варианты) и хэширование/сравнение без учёта регистра
+
+#include "../rcfs.h"
+#include "rcfs_test.h"
+
+#include <algorithm>
+#include <cctype>
+#include <random>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+static
+char referenceNormalize(char ch, bool toLowerCase)
+{
+    if (ch=='\\')
+        return '/';
+    if (toLowerCase && ch>='A' && ch<='Z')
+        return (char)(ch-'A'+'a');
+    return ch;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    std::mt19937 rng(1);
+
+    // Все длины вокруг границ векторов, все значения байт, со смещением начала
+    for(std::size_t size=0; size!=300; ++size)
+    {
+        for(int iter=0; iter!=4; ++iter)
+        {
+            std::vector<char> src(size+3);
+            for(auto &ch : src)
+                ch = (char)(iter&1 ? rng() : "Ab\\/zZ@[`{"[rng()%10]);
+
+            const char *pSrc = src.data()+iter%3;
+
+            for(bool toLowerCase : { false, true })
+            {
+                std::vector<char> dst(size+1, 'x'), dstScalar(size+1, 'x');
+                normalizePathSymbols      (dst.data()      , pSrc, size, toLowerCase);
+                normalize_utils::normalizePathSymbolsScalar(dstScalar.data(), pSrc, size, toLowerCase);
+
+                bool ok = dst[size]=='x'; // За границу не пишет
+                for(std::size_t i=0; i!=size; ++i)
+                    ok = ok && dst[i]==referenceNormalize(pSrc[i], toLowerCase) && dstScalar[i]==dst[i];
+                RCFS_CHECK(ok);
+
+                // На месте
+                std::vector<char> inPlace(pSrc, pSrc+size);
+                if (size)
+                    normalizePathSymbols(inPlace.data(), inPlace.data(), size, toLowerCase);
+                RCFS_CHECK(std::equal(inPlace.begin(), inPlace.end(), dst.begin()));
+            }
+        }
+    }
+
+    // Хэш и сравнение без учёта регистра
+    for(std::size_t size=0; size!=100; ++size)
+    {
+        std::string lower(size, 'a'), mixed;
+        for(auto &ch : lower)
+            ch = "abcxyz0129_.-"[rng()%13];
+
+        mixed = lower;
+        for(auto &ch : mixed)
+        {
+            if (rng()%2)
+                ch = (char)std::toupper((unsigned char)ch);
+        }
+
+        RCFS_CHECK(foldCaseHash(mixed)==foldCaseHash(lower));
+        RCFS_CHECK(equalFolded(mixed, lower));
+        RCFS_CHECK(compareFolded(mixed, lower)==0);
+
+        if (size)
+        {
+            std::string other = lower;
+            other[rng()%size] = '#';
+            RCFS_CHECK(!equalFolded(mixed, other));
+            RCFS_CHECK(compareFolded(mixed, other)!=0);
+        }
+    }
+
+    RCFS_CHECK(compareFolded("ABC", "abd")<0);
+    RCFS_CHECK(compareFolded("abc", "ab" )>0);
+    RCFS_CHECK(!equalFolded("[", "{")); // Не буквы - не сворачиваются
+
+    // Через ФС: регистронезависимое дерево находит имя в любом регистре, не создавая копий пути
+    DirectoryEntry     root;
+    ResourceFileSystem rcfs(false, &root);
+    static const std::uint8_t data[] = { 1 };
+    RCFS_CHECK(rcfs.createFile("Some\\Mixed/CASE_Name.Bin"));
+    RCFS_CHECK(rcfs.setFileData("some/mixed/case_name.bin", data, 1));
+    RCFS_CHECK(rcfs.findFileEntry("SOME/MIXED/case_NAME.BIN")!=0);
+    RCFS_CHECK(rcfs.normalizeNameSymbols("A\\B/c")=="a/b/c");
+
+    return marty_rcfs_test::report("test_normalize");
+}
@@ -0,0 +1,74 @@
+//----------------------------------------------------------------------------
+//! \file Режим декодирования диапазонов: чтение декодирует только читаемые байты, полная декодированная копия не создаётся
+
+#include "rcfs_test_files.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_test;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::vector<TestFile> files = makeTestFiles();
+
+    DirectoryEntry     root;
+    ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+    addTestFiles(rcfs, files);
+    rcfs.seal();
+
+    RCFS_CHECK(!rcfs.getRangeDecodeMode());
+    rcfs.setRangeDecodeMode(true);
+    RCFS_CHECK(rcfs.getRangeDecodeMode());
+
+    // XOR без цепочки, цепочка Xor и контейнер кусков декодируются по диапазонам
+    for(std::size_t fileIdx : { 1u, 2u, 5u })
+    {
+        const TestFile &f = files[fileIdx];
+
+        int iFile = rcfs.openFile(f.name);
+        RCFS_CHECK(iFile>=0 && rcfs.getFileSize(iFile)==f.plain.size());
+        RCFS_CHECK(rcfs.getFileView(iFile).empty()); // Декодированной копии нет
+
+        std::uint8_t buf[333];
+        std::size_t nReaded = 0;
+        RCFS_CHECK(rcfs.preadFile(iFile, 1001, buf, sizeof(buf), &nReaded) && nReaded==sizeof(buf));
+        RCFS_CHECK(std::equal(buf, buf+sizeof(buf), f.plain.begin()+1001));
+
+        // Диапазон внутри ключа и у конца файла
+        RCFS_CHECK(rcfs.preadFile(iFile, f.plain.size()-3, buf, sizeof(buf), &nReaded) && nReaded==3);
+        RCFS_CHECK(std::equal(buf, buf+3, f.plain.end()-3));
+
+        RCFS_CHECK(rcfs.seekFile(iFile, 3));
+        RCFS_CHECK(rcfs.readFile(iFile, buf, 5, &nReaded) && nReaded==5 && std::equal(buf, buf+5, f.plain.begin()+3));
+        RCFS_CHECK(rcfs.tellFile(iFile)==8);
+
+        std::vector<std::uint8_t> whole;
+        RCFS_CHECK(rcfs.seekFile(iFile, 0) && rcfs.readFile(iFile, whole) && whole==f.plain);
+
+        RCFS_CHECK(rcfs.closeFile(iFile));
+    }
+
+    RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==0);
+    RCFS_CHECK(rcfs.getDecodeCacheStats().numCached==0);
+
+    // Lz и Xor -> Lz по диапазонам не декодируются - файл декодируется целиком при открытии
+    RCFS_CHECK(readAndCompare(rcfs, files[3]));
+    RCFS_CHECK(readAndCompare(rcfs, files[4]));
+    RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==2);
+
+    // Без кодирования - данные как есть
+    RCFS_CHECK(readAndCompare(rcfs, files[0]));
+
+    // Выключение режима - полное декодирование при открытии
+    rcfs.setRangeDecodeMode(false);
+    int iFile = rcfs.openFile(files[2].name);
+    RCFS_CHECK(rcfs.getFileView(iFile).size()==files[2].plain.size());
+    RCFS_CHECK(rcfs.closeFile(iFile));
+
+    return marty_rcfs_test::report("test_range_decode");
+}
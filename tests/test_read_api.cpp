@@ -0,0 +1,187 @@
+//----------------------------------------------------------------------------
+//! \file Чтение открытых файлов: FileView, seek/tell, pread/preadv/readv, контейнеры, streambuf, пакетное чтение
+
+#include "../rcfs.h"
+#include "../rcfs_streambuf.h"
+#include "rcfs_test.h"
+
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    std::vector<std::uint8_t> data(1000);
+    for(std::size_t i=0; i!=data.size(); ++i)
+        data[i] = (std::uint8_t)(i*7+3);
+
+    DirectoryEntry     root;
+    ResourceFileSystem rcfs(true, &root);
+    RCFS_CHECK(rcfs.createFile("dir/data.bin"));
+    RCFS_CHECK(rcfs.setFileData("dir/data.bin", data.data(), data.size()));
+    RCFS_CHECK(rcfs.createFile("dir/text.txt"));
+    RCFS_CHECK(rcfs.setFileData("dir/text.txt", (const std::uint8_t*)"hello", 5));
+
+    {
+        // FileView
+        int iFile = rcfs.openFile("dir/data.bin");
+        RCFS_CHECK(iFile>=0);
+
+        FileView view = rcfs.getFileView(iFile);
+        RCFS_CHECK(view.size()==data.size() && std::equal(view.begin(), view.end(), data.begin()));
+        RCFS_CHECK(view.subView(990).size()==10 && view.subView(990)[0]==data[990]);
+        RCFS_CHECK(view.subView(2000).empty());
+        RCFS_CHECK(rcfs.getFileView(-1).empty());
+
+        // seek/tell
+        RCFS_CHECK(rcfs.tellFile(iFile)==0);
+        RCFS_CHECK(rcfs.seekFile(iFile, 100));
+        RCFS_CHECK(rcfs.seekFile(iFile, 50, SeekOrigin::Current) && rcfs.tellFile(iFile)==150);
+        RCFS_CHECK(rcfs.seekFile(iFile, -10, SeekOrigin::End) && rcfs.tellFile(iFile)==990);
+        RCFS_CHECK(!rcfs.seekFile(iFile, 1, SeekOrigin::End));
+        RCFS_CHECK(!rcfs.seekFile(iFile, -1, SeekOrigin::Begin));
+        RCFS_CHECK(!rcfs.seekFile(iFile, std::numeric_limits<std::ptrdiff_t>::min(), SeekOrigin::End));
+        RCFS_CHECK(!rcfs.seekFile(iFile, std::numeric_limits<std::ptrdiff_t>::max(), SeekOrigin::Current));
+        RCFS_CHECK(rcfs.tellFile(iFile)==990);
+
+        // readFile в буфер: читается остаток, позиция сдвигается, в конце - false
+        std::uint8_t buf[64];
+        std::size_t nReaded = 0;
+        RCFS_CHECK(rcfs.readFile(iFile, buf, sizeof(buf), &nReaded) && nReaded==10 && buf[0]==data[990]);
+        RCFS_CHECK(rcfs.tellFile(iFile)==1000);
+        RCFS_CHECK(!rcfs.readFile(iFile, buf, sizeof(buf), &nReaded));
+
+        // pread позицию не трогает
+        RCFS_CHECK(rcfs.preadFile(iFile, 500, buf, 16, &nReaded) && nReaded==16 && std::equal(buf, buf+16, data.begin()+500));
+        RCFS_CHECK(rcfs.tellFile(iFile)==1000);
+        RCFS_CHECK(rcfs.preadFile(iFile, 995, buf, 16, &nReaded) && nReaded==5);
+        RCFS_CHECK(!rcfs.preadFile(iFile, 1000, buf, 16, &nReaded));
+
+        // readv/preadv: буферы заполняются по порядку, пустой буфер пропускается
+        std::uint8_t a[3], b[5];
+        ReadIoVec iov[3];
+        iov[0].pData = a; iov[0].size = sizeof(a);
+        iov[1].pData = 0; iov[1].size = 0;
+        iov[2].pData = b; iov[2].size = sizeof(b);
+
+        RCFS_CHECK(rcfs.preadvFile(iFile, 10, iov, 3, &nReaded) && nReaded==8);
+        RCFS_CHECK(a[0]==data[10] && a[2]==data[12] && b[0]==data[13] && b[4]==data[17]);
+
+        RCFS_CHECK(rcfs.seekFile(iFile, 996));
+        RCFS_CHECK(rcfs.readvFile(iFile, iov, 3, &nReaded) && nReaded==4);
+        RCFS_CHECK(a[0]==data[996] && b[0]==data[999]);
+        RCFS_CHECK(rcfs.tellFile(iFile)==1000);
+
+        // Контейнеры: полностью, частями и дописыванием
+        RCFS_CHECK(rcfs.seekFile(iFile, 0));
+        std::vector<std::uint8_t> v;
+        RCFS_CHECK(rcfs.readFile(iFile, v, 100) && v.size()==100 && std::equal(v.begin(), v.end(), data.begin()));
+        RCFS_CHECK(rcfs.readFileAppend(iFile, v, 100) && v.size()==200 && std::equal(v.begin(), v.end(), data.begin()));
+        std::string s;
+        RCFS_CHECK(rcfs.readFile(iFile, s) && s.size()==800 && (std::uint8_t)s[0]==data[200]);
+
+        RCFS_CHECK(rcfs.closeFile(iFile));
+        RCFS_CHECK(!rcfs.closeFile(iFile));
+        RCFS_CHECK(rcfs.tellFile(iFile)==(std::size_t)-1);
+        RCFS_CHECK(!rcfs.preadFile(iFile, 0, buf, 1, &nReaded));
+    }
+
+    {
+        // Чтение по ResourceId и в буфер вызывающего
+        ResourceId id = rcfs.resolve("dir/text.txt");
+        RCFS_CHECK(id.valid() && rcfs.getFileSize(id)==5);
+
+        std::vector<char> v;
+        RCFS_CHECK(rcfs.readFile(id, v) && std::string(v.begin(), v.end())=="hello");
+
+        char buf[8] = {};
+        std::size_t nReaded = 0;
+        RCFS_CHECK(rcfs.readFileTo(id, (std::uint8_t*)buf, sizeof(buf), &nReaded) && nReaded==5 && std::string(buf)=="hello");
+        RCFS_CHECK(!rcfs.readFileTo(id, (std::uint8_t*)buf, 4, &nReaded)); // Буфер меньше файла
+
+        RCFS_CHECK(!rcfs.resolve("dir/missing.txt").valid());
+    }
+
+    {
+        // std::istream поверх файла
+        ResourceStreamBuf streamBuf(&rcfs);
+        RCFS_CHECK(streamBuf.open("dir/data.bin") && streamBuf.getFileSize()==data.size());
+
+        std::istream in(&streamBuf);
+        in.seekg(900);
+        std::vector<char> rest((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        RCFS_CHECK(rest.size()==100 && (std::uint8_t)rest[0]==data[900]);
+
+        in.clear();
+        in.seekg(-1, std::ios_base::end);
+        RCFS_CHECK(in.get()==data[999]);
+
+        RCFS_CHECK(streamBuf.pubseekoff(std::numeric_limits<std::streamoff>::min(), std::ios_base::end, std::ios_base::in)==std::streampos(std::streamoff(-1)));
+        RCFS_CHECK(streamBuf.pubseekoff(std::numeric_limits<std::streamoff>::max(), std::ios_base::beg, std::ios_base::in)==std::streampos(std::streamoff(-1)));
+
+        streamBuf.close();
+        RCFS_CHECK(!streamBuf.isOpen());
+        RCFS_CHECK(!streamBuf.open("nope"));
+    }
+
+    {
+        // Пакетное чтение, с копированием и без
+        std::string_view paths[] = { "dir/text.txt", "dir/missing", "dir/data.bin" };
+
+        for(bool copyData : { false, true })
+        {
+            ResourceBatch batch;
+            rcfs.readBatch(paths, 3, batch, copyData);
+            RCFS_CHECK(batch.size()==3);
+            RCFS_CHECK(batch[0].view.toStringView()=="hello");
+            RCFS_CHECK(!batch[1].id.valid() && batch[1].view.empty());
+            RCFS_CHECK(batch[2].view.size()==data.size() && batch[2].view[999]==data[999]);
+            RCFS_CHECK(batch.getStats().numRequested==3 && batch.getStats().numFound==2);
+        }
+
+        std::size_t visited = 0;
+        rcfs.visitBatch(paths, 3, [&](std::size_t idx, const FileView &view)
+                        {
+                            visited += idx==1 ? 100 : view.size();
+                        });
+        RCFS_CHECK(visited==5+data.size());
+    }
+
+    {
+        // pread параллельно с readFile/seekFile на одном дескрипторе
+        int iFile = rcfs.openFile("dir/data.bin");
+
+        std::size_t badPread = 0;
+        std::thread preader([&]()
+        {
+            std::uint8_t buf[10];
+            for(std::size_t i=0; i!=20000; ++i)
+            {
+                std::size_t offset = (i*37)%990, nReaded = 0;
+                if (!rcfs.preadFile(iFile, offset, buf, 10, &nReaded) || nReaded!=10 || !std::equal(buf, buf+10, data.begin()+offset))
+                    ++badPread;
+            }
+        });
+
+        std::uint8_t buf[10];
+        for(std::size_t i=0; i!=20000; ++i)
+        {
+            std::size_t nReaded = 0;
+            if (!rcfs.readFile(iFile, buf, 10, &nReaded))
+                rcfs.seekFile(iFile, 0);
+        }
+
+        preader.join();
+        RCFS_CHECK(badPread==0);
+        RCFS_CHECK(rcfs.closeFile(iFile));
+    }
+
+    return marty_rcfs_test::report("test_read_api");
+}
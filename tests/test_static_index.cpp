@@ -0,0 +1,84 @@
+//----------------------------------------------------------------------------
+//! \file Статическая таблица ресурсов: поиск через ResourceFileSystem, диагностика дубликатов
+
+#include "../rcfs.h"
+#include "rcfs_test.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+static constexpr char fileA[] = "aaaa";
+static constexpr char fileB[] = "bb";
+static constexpr char fileC[] = "c";
+
+static constexpr StaticFileEntry rcEntries[] =
+{ MARTY_RCFS_STATIC_FILE_ARRAY_EX("a.txt"              , fileA, 4)
+, MARTY_RCFS_STATIC_FILE_ARRAY_EX("dir/b.bin"          , fileB, 2)
+, MARTY_RCFS_STATIC_FILE_ARRAY_EX("dir/sub/./Deep.TXT" , fileC, 1)
+};
+
+static constexpr auto rcIndex = makeStaticResourceIndex(rcEntries);
+
+//----------------------------------------------------------------------------
+//! Сообщение об ошибке построения таблицы (построение в runtime - то же, что и в compile time)
+template<std::size_t N>
+std::string getBuildError(const StaticFileEntry (&entries)[N])
+{
+    try
+    {
+        StaticResourceIndex<N> index(entries);
+        (void)index;
+    }
+    catch(const std::logic_error &e)
+    {
+        return e.what();
+    }
+
+    return std::string();
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    {
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root);
+        rcfs.setStaticIndex(rcIndex.view());
+
+        RCFS_CHECK(rcfs.getFileSize("a.txt")==4);
+        RCFS_CHECK(rcfs.getFileSize("/dir//b.bin")==2);
+        RCFS_CHECK(rcfs.getFileSize("DIR/SUB/deep.txt")==1);
+        RCFS_CHECK(rcfs.getFileSize("dir/missing")==(std::size_t)-1);
+
+        std::string data;
+        RCFS_CHECK(rcfs.readFile(rcfs.resolve("dir/b.bin"), data));
+        RCFS_CHECK(data=="bb");
+    }
+
+    {
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(true /* caseSens */, &root);
+        rcfs.setStaticIndex(rcIndex.view());
+        RCFS_CHECK(rcfs.getFileSize("dir/sub/Deep.TXT")==1);
+        RCFS_CHECK(rcfs.getFileSize("dir/sub/deep.txt")==(std::size_t)-1);
+    }
+
+    // Дубликаты - отдельная диагностика, а не "hash collision"
+    static constexpr StaticFileEntry dupSlashes[] = { MARTY_RCFS_STATIC_FILE_ARRAY_EX("a//b", fileA, 4), MARTY_RCFS_STATIC_FILE_ARRAY_EX("a/b", fileB, 2) };
+    static constexpr StaticFileEntry dupCase   [] = { MARTY_RCFS_STATIC_FILE_ARRAY_EX("Dir/File", fileA, 4), MARTY_RCFS_STATIC_FILE_ARRAY_EX("dir/file", fileB, 2) };
+    static constexpr StaticFileEntry dupDot    [] = { MARTY_RCFS_STATIC_FILE_ARRAY_EX("x", fileC, 1), MARTY_RCFS_STATIC_FILE_ARRAY_EX("./x/", fileA, 4), MARTY_RCFS_STATIC_FILE_ARRAY_EX("y", fileB, 2) };
+    static constexpr StaticFileEntry dotDot    [] = { MARTY_RCFS_STATIC_FILE_ARRAY_EX("a/../b", fileA, 4) };
+    static constexpr StaticFileEntry distinct  [] = { MARTY_RCFS_STATIC_FILE_ARRAY_EX("a/b", fileA, 4), MARTY_RCFS_STATIC_FILE_ARRAY_EX("a/bb", fileB, 2), MARTY_RCFS_STATIC_FILE_ARRAY_EX("ab", fileC, 1) };
+
+    RCFS_CHECK(getBuildError(dupSlashes).find("duplicate resource path")!=std::string::npos);
+    RCFS_CHECK(getBuildError(dupCase   ).find("duplicate resource path")!=std::string::npos);
+    RCFS_CHECK(getBuildError(dupDot    ).find("duplicate resource path")!=std::string::npos);
+    RCFS_CHECK(getBuildError(dotDot    ).find("'..'")!=std::string::npos);
+    RCFS_CHECK(getBuildError(distinct  ).empty());
+
+    return marty_rcfs_test::report("test_static_index");
+}
@@ -0,0 +1,83 @@
+//----------------------------------------------------------------------------
+//! \file Предварительное декодирование warmUp: статистика, первое открытие - попадание в кэш, ошибки декодирования
+
+#include "rcfs_test_files.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+using namespace marty_rcfs_test;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::vector<TestFile> files = makeTestFiles();
+
+    std::size_t bytesEncoded = 0;
+    for(const auto &f : files)
+    {
+        if (f.encoded())
+            bytesEncoded += f.plain.size();
+    }
+
+    for(unsigned numThreads : { 1u, 3u, 0u })
+    {
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        addTestFiles(rcfs, files);
+        rcfs.seal();
+
+        const WarmUpStats warm = rcfs.warmUp(numThreads);
+        RCFS_CHECK(warm.numFiles==files.size()-1); // У пустого файла нет данных
+        RCFS_CHECK(warm.numDecoded==5);
+        RCFS_CHECK(warm.bytesDecoded==bytesEncoded);
+        RCFS_CHECK(warm.numThreads>=1 && warm.numThreads<=warm.numFiles);
+        if (numThreads)
+            RCFS_CHECK(warm.numThreads==numThreads);
+        RCFS_CHECK(warm.wallTime>=0);
+
+        RCFS_CHECK(rcfs.warmUp(2).numDecoded==0); // Уже декодированы
+
+        // Первое открытие - только поиск
+        const std::size_t missesBefore = rcfs.getDecodeCacheStats().numMisses;
+        for(const auto &f : files)
+            RCFS_CHECK(readAndCompare(rcfs, f));
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numMisses==missesBefore);
+        RCFS_CHECK(rcfs.getDecodeCacheStats().numHits==5);
+    }
+
+    {
+        // Без декодера и без файлов - нечего декодировать
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root);
+        addTestFiles(rcfs, files);
+        RCFS_CHECK(rcfs.warmUp(2).numDecoded==0);
+
+        DirectoryEntry     emptyRoot;
+        ResourceFileSystem emptyRcfs(false, &emptyRoot, getDefaultCodecChainFileDecoder());
+        const WarmUpStats warm = emptyRcfs.warmUp(4);
+        RCFS_CHECK(warm.numFiles==0 && warm.numDecoded==0);
+    }
+
+    {
+        // Ошибка декодирования передаётся вызывающему, файл остаётся недекодированным
+        TestFile broken = makeTestFile("broken.bin", codecChainLz, 0, 5000);
+        broken.stored.resize(broken.stored.size()/2);
+
+        DirectoryEntry     root;
+        ResourceFileSystem rcfs(false, &root, getDefaultCodecChainFileDecoder());
+        addTestFiles(rcfs, files);
+        RCFS_CHECK(rcfs.createFile(broken.name));
+        RCFS_CHECK(rcfs.setFileData(broken.name, broken.stored.data(), broken.stored.size(), 0, 0, 0, codecChainLz));
+
+        RCFS_CHECK_THROWS(rcfs.warmUp(2));
+        RCFS_CHECK_THROWS(rcfs.openFile(broken.name)); // Следующее открытие пробует снова
+        for(const auto &f : files)
+            RCFS_CHECK(readAndCompare(rcfs, f));
+    }
+
+    return marty_rcfs_test::report("test_warm_up");
+}
@@ -0,0 +1,151 @@
+//----------------------------------------------------------------------------
+//! \file XOR-декодирование: сверка с _2c::xorDecrypt (обязательна - _2c в путях включения), известные ответы, XorFileDecoder
+
+#include "../rcfs.h"
+#include "../rcfs_file_decoders.h"
+#include "rcfs_test.h"
+
+#include <random>
+#include <vector>
+
+// XorFileDecoder заменяет декодер на _2c::xorDecrypt (MARTY_RCFS_IMPLEMENT_XOR_DECRYPT_FILE_DECODER) -
+// без сверки с настоящим _2c тест не имеет смысла, поэтому без _2c он не собирается
+#include "_2c_xor_encrypt.h"
+
+//----------------------------------------------------------------------------
+using namespace marty_rcfs;
+
+//! Эталон по описанию формата: ключ номер j = seed + j*inc, усечённый до keySize байт, накладывается байтами от младшего
+static
+void referenceXor(std::uint8_t *pDst, const std::uint8_t *pSrc, std::size_t size, unsigned keySize, std::uint32_t seed, std::uint32_t inc)
+{
+    std::uint32_t key = seed;
+    for(std::size_t i=0; i<size; i+=keySize, key+=inc)
+    {
+        for(unsigned b=0; b!=keySize && i+b<size; ++b)
+            pDst[i+b] = (std::uint8_t)(pSrc[i+b] ^ (std::uint8_t)(key>>(8*b)));
+    }
+}
+
+struct KnownAnswer
+{
+    unsigned                    keySize;
+    std::uint32_t               seed;
+    std::uint32_t               inc;
+    std::vector<std::uint8_t>   plain;
+    std::vector<std::uint8_t>   encoded;
+};
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const KnownAnswer knownAnswers[] =
+    { { 1, 250       , 3     , { 0, 0, 0, 0 }            , { 0xFA, 0xFD, 0x00, 0x03 } }
+    , { 1, 1         , 1     , { 'A', 'B', 'C' }         , { 0x40, 0x40, 0x40 } }
+    , { 2, 0x1234    , 0x0101, { 0, 0, 0, 0, 0, 0 }      , { 0x34, 0x12, 0x35, 0x13, 0x36, 0x14 } }
+    , { 2, 0xFFFF    , 2     , { 0, 0, 0, 0, 0 }         , { 0xFF, 0xFF, 0x01, 0x00, 0x03 } }       // Перенос по модулю 2^16, неполный последний ключ
+    , { 4, 0xFFFFFFFF, 1     , { 0, 0, 0, 0, 0, 0, 0, 0 }, { 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00 } }
+    , { 4, 0x04030201, 0     , { 1, 2, 3, 4, 5, 6 }      , { 0, 0, 0, 0, 4, 4 } }
+    };
+
+    for(const auto &ka : knownAnswers)
+    {
+        std::vector<std::uint8_t> out(ka.plain.size());
+        RCFS_CHECK(xorDecodeData(out.data(), ka.plain.data(), out.size(), ka.keySize, ka.seed, ka.inc));
+        RCFS_CHECK(out==ka.encoded);
+
+        RCFS_CHECK(xorDecodeData(out.data(), out.data(), out.size(), ka.keySize, ka.seed, ka.inc));
+        RCFS_CHECK(out==ka.plain);
+    }
+
+    std::uint8_t dummy = 0;
+    RCFS_CHECK(!xorDecodeData(&dummy, &dummy, 1, 3, 0, 0));
+    RCFS_CHECK(!xorDecodeData(&dummy, &dummy, 1, 0, 0, 0));
+
+    // Все размеры ключа, длины вокруг границ векторов, невыровненные буферы, смещения в потоке, на месте
+    std::mt19937 rng(1);
+    for(unsigned keySize : { 1u, 2u, 4u })
+    {
+        for(std::size_t size=0; size!=300; ++size)
+        {
+            const std::uint32_t seed = rng(), inc = rng();
+
+            std::vector<std::uint8_t> src(size+1), expected(size+1), out(size+1);
+            for(auto &b : src)
+                b = (std::uint8_t)rng();
+
+            referenceXor(expected.data()+1, src.data()+1, size, keySize, seed, inc);
+
+            RCFS_CHECK(xorDecodeData(out.data()+1, src.data()+1, size, keySize, seed, inc));
+            RCFS_CHECK(std::equal(out.begin()+1, out.end(), expected.begin()+1));
+
+            std::vector<std::uint8_t> inPlace = src;
+            RCFS_CHECK(xorDecodeData(inPlace.data()+1, inPlace.data()+1, size, keySize, seed, inc));
+            RCFS_CHECK(std::equal(inPlace.begin()+1, inPlace.end(), expected.begin()+1));
+
+            // Диапазон с произвольного смещения, в т.ч. внутри ключа
+            const std::size_t offset = size ? rng()%size : 0;
+            std::vector<std::uint8_t> part(size-offset);
+            RCFS_CHECK(xorDecodeData(part.data(), src.data()+1+offset, part.size(), keySize, seed, inc, offset));
+            RCFS_CHECK(std::equal(part.begin(), part.end(), expected.begin()+1+offset));
+        }
+    }
+
+    // XorFileDecoder: целиком, в буфер вызывающего, диапазоном
+    {
+        const XorFileDecoder decoder;
+
+        std::vector<std::uint8_t> plain(1000), encoded(1000), expected(1000);
+        for(auto &b : plain)
+            b = (std::uint8_t)rng();
+        referenceXor(encoded.data(), plain.data(), plain.size(), 2, 0xBEEF, 0x1357);
+
+        std::vector<std::uint8_t> decoded;
+        RCFS_CHECK(decoder.decodeFileData(decoded, encoded.data(), encoded.size(), 2, 0xBEEF, 0x1357) && decoded==plain);
+        RCFS_CHECK(!decoder.decodeFileData(decoded, encoded.data(), encoded.size(), 0, 0, 0)); // Без ключа - не требуется
+        RCFS_CHECK(decoder.getDecodedSize(encoded.data(), encoded.size(), 2, 0xBEEF, 0x1357)==encoded.size());
+
+        std::vector<std::uint8_t> to(1000);
+        RCFS_CHECK(decoder.decodeFileDataTo(to.data(), to.size(), encoded.data(), encoded.size(), codecChainDefault, 2, 0xBEEF, 0x1357) && to==plain);
+
+        std::uint8_t range[37];
+        RCFS_CHECK(decoder.decodeFileDataRange(range, encoded.data(), encoded.size(), 501, sizeof(range), 2, 0xBEEF, 0x1357));
+        RCFS_CHECK(std::equal(range, range+sizeof(range), plain.begin()+501));
+        RCFS_CHECK(!decoder.decodeFileDataRange(range, encoded.data(), encoded.size(), 990, sizeof(range), 2, 0xBEEF, 0x1357));
+
+        RCFS_CHECK_THROWS(decoder.decodeFileData(decoded, encoded.data(), encoded.size(), 3, 0, 0));
+    }
+
+    // Сверка с _2c::xorDecrypt - декодером данных, которые генерируют утилиты _2c
+    for(unsigned keySize : { 1u, 2u, 4u })
+    {
+        for(std::size_t size : { 0u, 1u, 3u, 15u, 16u, 33u, 257u, 4099u })
+        {
+            const std::uint32_t seed = rng(), inc = rng();
+
+            std::vector<std::uint8_t> src(size);
+            for(auto &b : src)
+                b = (std::uint8_t)rng();
+
+            std::vector<std::uint8_t> expected = src, out(size);
+            _2c::xorDecrypt(expected.begin(), expected.end(), (_2c::EKeySize)keySize, seed, inc);
+
+            RCFS_CHECK(xorDecodeData(out.data(), src.data(), size, keySize, seed, inc));
+            RCFS_CHECK(out==expected);
+
+            // XorFileDecoder, через который теперь идут данные _2c
+            std::vector<std::uint8_t> decoded;
+            RCFS_CHECK(XorFileDecoder().decodeFileData(decoded, src.data(), size, keySize, seed, inc) && decoded==expected);
+        }
+    }
+
+    // Известные ответы - тоже сверяем с _2c, а не только с нашим пониманием формата
+    for(const auto &ka : knownAnswers)
+    {
+        std::vector<std::uint8_t> expected = ka.plain;
+        _2c::xorDecrypt(expected.begin(), expected.end(), (_2c::EKeySize)ka.keySize, ka.seed, ka.inc);
+        RCFS_CHECK(expected==ka.encoded);
+    }
+
+    return marty_rcfs_test::report("test_xor_decode");
+}